@@ -0,0 +1,52 @@
+package com.webspiders.extension
+{
+	import flash.events.Event;
+	
+	/**
+	 * MoodstocksJobEvent
+	 * 
+	 * Dispatched by MoodstocksScanner when an asynchronous
+	 * native call returned by job id has finished
+	 */
+	public class MoodstocksJobEvent extends Event
+	{
+		public static const JOB_COMPLETE			: String = "jobComplete";
+		
+		public static const OPERATION_OPEN			: uint = 1;
+		public static const OPERATION_CLOSE			: uint = 2;
+		public static const OPERATION_SYNC			: uint = 3;
+		public static const OPERATION_PRESENT		: uint = 4;
+		public static const OPERATION_DISMISS		: uint = 5;
+		public static const OPERATION_PREWARM		: uint = 6;
+		public static const OPERATION_IMPORT		: uint = 7;
+		
+		public var jobId							: uint;
+		public var operation						: uint;
+		
+		/**
+		 * 0 on success, else the Moodstocks SDK error code (-1 if unknown)
+		 */
+		public var errorCode						: int;
+		
+		/**
+		 * CONSTRUCTOR
+		 */
+		public function MoodstocksJobEvent(type:String, jobId:uint, operation:uint, errorCode:int)
+		{
+			super( type );
+			this.jobId = jobId;
+			this.operation = operation;
+			this.errorCode = errorCode;
+		}
+		
+		public function get succeeded() : Boolean
+		{
+			return errorCode == 0;
+		}
+		
+		override public function clone() : Event
+		{
+			return new MoodstocksJobEvent( type, jobId, operation, errorCode );
+		}
+	}
+}
@@ -1,9 +1,12 @@
 package com.webspiders.extension
 {
+	import flash.display.BitmapData;
 	import flash.events.Event;
 	import flash.events.EventDispatcher;
 	import flash.events.StatusEvent;
 	import flash.external.ExtensionContext;
+	import flash.utils.ByteArray;
+	import flash.utils.Endian;
 	import flash.utils.setTimeout;
 	
 	/**
@@ -15,13 +18,83 @@ package com.webspiders.extension
 	 */
 	public class MoodstocksScanner extends EventDispatcher
 	{
+		//--------------------------------------------------------------------------
+		//
+		//  PUBLIC STATIC
+		//
+		//--------------------------------------------------------------------------
+		
+		/**
+		 * Packed result record layout inside resultBuffer (little endian):
+		 * 
+		 * uint   type		MSResultType (RESULT_TYPE_IMAGE or a barcode format)
+		 * ubyte  origin		1 client, 2 server
+		 * ubyte  source		SOURCE_CAMERA, SOURCE_BITMAP, SOURCE_ENCODED, SOURCE_BATCH
+		 * ubyte  flags		RESULT_FLAG_CORNERS if 8 corner floats follow the header,
+		 * 					RESULT_FLAG_SKIPPED if the frame was dropped by the governor,
+		 * 					RESULT_FLAG_BLURRED if it was too blurred or moving to search,
+		 * 					RESULT_FLAG_TIMEOUT if the server did not answer in time,
+		 * 					RESULT_FLAG_ERROR if the image could not be read or decoded
+		 * ubyte  reserved
+		 * uint   tag			job id or batch index, 0 for the camera UI
+		 * uint   idLength		number of id bytes following the header (and corners)
+		 * double timestamp	capture time in seconds
+		 */
+		public static const RESULT_HEADER_SIZE		: uint = 24;
+		public static const RESULT_CORNERS_SIZE		: uint = 32;
+		public static const RESULT_FLAG_CORNERS		: uint = 1;
+		public static const RESULT_FLAG_SKIPPED		: uint = 2;
+		public static const RESULT_FLAG_BLURRED		: uint = 4;
+		public static const RESULT_FLAG_TIMEOUT		: uint = 8;
+		public static const RESULT_FLAG_ERROR		: uint = 16;
+		public static const RESULT_TYPE_NONE		: uint = 0;
+		public static const RESULT_TYPE_EAN8		: uint = 1;
+		public static const RESULT_TYPE_EAN13		: uint = 2;
+		public static const RESULT_TYPE_QRCODE		: uint = 4;
+		public static const RESULT_TYPE_DATAMATRIX	: uint = 8;
+		public static const RESULT_TYPE_IMAGE		: uint = 0x80000000;
+		public static const RESULT_TYPES_DEFAULT	: uint = RESULT_TYPE_IMAGE | RESULT_TYPE_QRCODE | RESULT_TYPE_EAN13;
+		
+		public static const SCAN_MODE_MANUAL		: uint = 0;
+		public static const SCAN_MODE_AUTO			: uint = 1;
+		
+		public static const RESULT_EXTRA_NONE		: uint = 0;
+		public static const RESULT_EXTRA_CORNERS	: uint = 1;
+		public static const RESULT_EXTRA_HOMOGRAPHY	: uint = 2;
+		public static const RESULT_EXTRA_DIMENSIONS	: uint = 4;
+		
+		public static const SEARCH_DEFAULT			: uint = 0;
+		public static const SEARCH_NO_PARTIAL		: uint = 1;
+		public static const SEARCH_SMALL_TARGET		: uint = 2;
+		
+		public static const CASCADE_BARCODE_FIRST	: uint = 0;
+		public static const CASCADE_IMAGE_FIRST		: uint = 1;
+		
+		public static const SOURCE_CAMERA			: uint = 0;
+		public static const SOURCE_BITMAP			: uint = 1;
+		public static const SOURCE_ENCODED			: uint = 2;
+		public static const SOURCE_BATCH			: uint = 3;
+		
+		/**
+		 * Dispatched once the camera UI delivers frames,
+		 * see timeToFirstFrame
+		 */
+		public static const CAMERA_READY			: String = "cameraReady";
+		
+		/**
+		 * Dispatched when isSyncing, syncProgress or syncError of a
+		 * catalog changed, at most once per setSyncStatusInterval() and
+		 * catalog; syncApiKey tells which one
+		 */
+		public static const SYNC_STATUS				: String = "syncStatus";
+		
 		//--------------------------------------------------------------------------
 		//
 		//  PRIVATE STATIC
 		//
 		//--------------------------------------------------------------------------
 		
-		private static var INSTANCE			: MoodstocksScanner;
+		private static var INSTANCES		: Object = {};
 		
 		//--------------------------------------------------------------------------
 		//
@@ -30,17 +103,34 @@ package com.webspiders.extension
 		//--------------------------------------------------------------------------
 		
 		protected var extContext			: ExtensionContext;
+		protected var contextType			: String;
 		protected var matchValue			: String;
+		protected var results				: ByteArray;
+		protected var resultsLength			: uint;
+		protected var lastResultOffset		: int = -1;
+		protected var lastBatchProcessed	: uint;
+		protected var jobs					: ByteArray;
+		protected var lastTimeToFirstFrame	: Number = NaN;
+		protected var syncing				: Boolean;
+		protected var lastSyncProgress		: int = -1;
+		protected var lastSyncError			: int;
+		protected var lastSyncApiKey			: String;
 		
 		/**
 		 * CONSTRUCTOR
 		 */
-		public function MoodstocksScanner(enforcer:SingletonEnforcer)
+		public function MoodstocksScanner(enforcer:SingletonEnforcer, contextType:String="")
 		{
 			super();
 			
+			results = new ByteArray();
+			results.endian = Endian.LITTLE_ENDIAN;
+			jobs = new ByteArray();
+			jobs.endian = Endian.LITTLE_ENDIAN;
+			
 			// singleton enforcer.. 
-			extContext = ExtensionContext.createExtensionContext( "com.webspiders.MoodstocksScanner", "" );
+			this.contextType = contextType;
+			extContext = ExtensionContext.createExtensionContext( "com.webspiders.MoodstocksScanner", contextType );
 			if ( !extContext ) throw new Error( "MoodstocksScanner extension is not supported on this platform." );
 			else extContext.addEventListener( StatusEvent.STATUS, onStatus );
 		}
@@ -50,8 +140,19 @@ package com.webspiders.extension
 		 */
 		public static function get instance() : MoodstocksScanner
 		{
-			if ( !INSTANCE ) INSTANCE = new MoodstocksScanner( new SingletonEnforcer() );
-			return INSTANCE;
+			return forContext( "" );
+		}
+		
+		/**
+		 * RETURN INSTANCE FOR A NAMED CONTEXT
+		 * 
+		 * Every context drives its own native scanner and
+		 * local database, so several catalogs can run side by side
+		 */
+		public static function forContext( contextType:String ) : MoodstocksScanner
+		{
+			if ( !INSTANCES[contextType] ) INSTANCES[contextType] = new MoodstocksScanner( new SingletonEnforcer(), contextType );
+			return INSTANCES[contextType];
 		}
 		
 		//--------------------------------------------------------------------------
@@ -61,15 +162,505 @@ package com.webspiders.extension
 		//--------------------------------------------------------------------------
 		
 		/**
-		 * Opens native Moodstocks camera UI
+		 * Opens native Moodstocks camera UI. The scanner database is
+		 * opened in the background, the camera shows up right after
 		 * 
 		 * @required
 		 * APIKey String
 		 * APISecret String
+		 * 
+		 * @optional
+		 * options Object: mode (SCAN_MODE_MANUAL, the default, snaps on
+		 * tap and dismisses on a match; SCAN_MODE_AUTO searches every
+		 * frame on the device and streams matches with Event.CHANGE while
+		 * the camera stays up), resultTypes, and for SCAN_MODE_AUTO
+		 * resultExtras (RESULT_EXTRA_*) and searchOptions (SEARCH_*)
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows once presented
+		 */
+		public function runScanner( apiKey:String, apiSecret:String, options:Object=null ) : uint
+		{
+			if ( !options ) options = {};
+			return extContext.call( "runScanner", apiKey, apiSecret,
+				( "mode" in options ) ? uint( options.mode ) : SCAN_MODE_MANUAL,
+				( "resultTypes" in options ) ? uint( options.resultTypes ) : RESULT_TYPES_DEFAULT,
+				( "resultExtras" in options ) ? uint( options.resultExtras ) : RESULT_EXTRA_NONE,
+				( "searchOptions" in options ) ? uint( options.searchOptions ) : SEARCH_DEFAULT ) as uint;
+		}
+		
+		/**
+		 * Does the expensive part of the first runScanner() in the
+		 * background, e.g. while your app shows its splash screen:
+		 * opens the local database, starts the first sync and loads the
+		 * camera UI without starting the camera
+		 * 
+		 * @required
+		 * APIKey String
+		 * APISecret String
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows once ready
+		 */
+		public function prewarm( apiKey:String, apiSecret:String ) : uint
+		{
+			return extContext.call( "prewarm", apiKey, apiSecret ) as uint;
+		}
+		
+		/**
+		 * Closes native Moodstocks camera UI
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows once closed
+		 */
+		public function releaseScanner() : uint
+		{
+			return extContext.call( "releaseScanner" ) as uint;
+		}
+		
+		/**
+		 * Opens the scanner without presenting the camera UI,
+		 * required before scanning your own frames
+		 * 
+		 * @required
+		 * APIKey String
+		 * APISecret String
+		 */
+		public function openScanner( apiKey:String, apiSecret:String ) : Boolean
+		{
+			return extContext.call( "openScanner", apiKey, apiSecret ) as Boolean;
+		}
+		
+		/**
+		 * Same as openScanner() without blocking the AIR UI
+		 * while the local database opens
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows once open
+		 */
+		public function openScannerAsync( apiKey:String, apiSecret:String ) : uint
+		{
+			return extContext.call( "openScannerAsync", apiKey, apiSecret ) as uint;
+		}
+		
+		/**
+		 * Imports the prebuilt signatures of a bundle shipped with the
+		 * application into the open scanner, so the first launch can scan
+		 * before a sync. No network is needed.
+		 * 
+		 * @required
+		 * path String, relative to the application bundle unless absolute
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows once imported
+		 */
+		public function importBundle( path:String ) : uint
+		{
+			return extContext.call( "importBundle", path ) as uint;
+		}
+		
+		/**
+		 * Closes the scanner once pending scans are done
+		 * 
+		 * @return
+		 * Job id
+		 */
+		public function closeScanner() : uint
+		{
+			return extContext.call( "closeScanner" ) as uint;
+		}
+		
+		/**
+		 * Controls when the local database is synced in the background.
+		 * A sync starts when the scanner opens and at most once per
+		 * minInterval after that; failed attempts without connection are
+		 * retried with an increasing delay. Syncs keep running when the
+		 * camera UI is dismissed
+		 * 
+		 * @required
+		 * minInterval Seconds after a successful sync, 3600 by default
+		 * unmeteredOnly Only sync over Wi-Fi
+		 * idleOnly Only sync while neither the camera nor a batch is scanning
 		 */
-		public function runScanner( apiKey:String, apiSecret:String ) : void
+		public function setSyncPolicy( minInterval:Number=3600, unmeteredOnly:Boolean=false, idleOnly:Boolean=false ) : void
 		{
-			extContext.call( "runScanner", apiKey, apiSecret );
+			extContext.call( "setSyncPolicy", minInterval, unmeteredOnly, idleOnly );
+		}
+		
+		/**
+		 * Sets how often SYNC_STATUS may be dispatched while a sync
+		 * progresses, 0.25 seconds by default. Only the latest state is
+		 * delivered
+		 */
+		public function setSyncStatusInterval( seconds:Number ) : void
+		{
+			extContext.call( "setSyncStatusInterval", seconds );
+		}
+		
+		/**
+		 * Whether a sync of the local database is running
+		 */
+		public function get isSyncing() : Boolean
+		{
+			return syncing;
+		}
+		
+		/**
+		 * Progress of the running or last sync in percent, -1 if unknown
+		 */
+		public function get syncProgress() : int
+		{
+			return lastSyncProgress;
+		}
+		
+		/**
+		 * Moodstocks SDK error code of the last sync, 0 if it succeeded
+		 */
+		public function get syncError() : int
+		{
+			return lastSyncError;
+		}
+		
+		/**
+		 * API key of the catalog the last SYNC_STATUS was about. Pooled
+		 * scanners of other catalogs may still be syncing
+		 */
+		public function get syncApiKey() : String
+		{
+			return lastSyncApiKey;
+		}
+		
+		/**
+		 * What the successful syncs of this scanner downloaded so far:
+		 * syncCount, lastSyncBytes, totalSyncBytes and lastSyncDuration
+		 * (seconds). Bytes are measured as growth of the local database
+		 */
+		public function get syncStats() : Object
+		{
+			return extContext.call( "syncStats" );
+		}
+		
+		/**
+		 * Synchronizes the local database of the open scanner now,
+		 * regardless of the sync policy's interval
+		 * 
+		 * @return
+		 * Job id, MoodstocksJobEvent.JOB_COMPLETE follows with the sync result
+		 */
+		public function sync() : uint
+		{
+			return extContext.call( "syncScanner" ) as uint;
+		}
+		
+		/**
+		 * Scans a BitmapData without the native camera UI. The pixels are
+		 * copied during the call, recognition runs in the background and the
+		 * outcome arrives with Event.CHANGE, as a RESULT_TYPE_NONE record
+		 * with the same tag when nothing matched
+		 * 
+		 * @return
+		 * false if the scanner is not open or the bitmap cannot be read
+		 */
+		public function scanBitmapData( bitmapData:BitmapData, resultTypes:uint=RESULT_TYPES_DEFAULT, tag:uint=0 ) : Boolean
+		{
+			return extContext.call( "scanBitmapData", bitmapData, resultTypes, tag ) as Boolean;
+		}
+		
+		/**
+		 * Limits the CPU continuous scanning may use: the SCAN_MODE_AUTO
+		 * camera and frames passed to scanBitmapData(). Frames are
+		 * processed at the interval their average search time allows
+		 * within cpuBudget (share of one core, 0.5 by default, 0 to
+		 * process every frame); UI frames slower than uiFrameTime
+		 * (seconds) lower the budget further. A dropped scanBitmapData()
+		 * frame is reported as a RESULT_FLAG_SKIPPED record
+		 */
+		public function setFrameGovernor( cpuBudget:Number=0.5, uiFrameTime:Number=0.016666 ) : void
+		{
+			extContext.call( "setFrameGovernor", cpuBudget, uiFrameTime );
+		}
+		
+		/**
+		 * Governor counters of the auto mode camera (camera) and of
+		 * scanBitmapData() (frames): admitted, skipped, averageCost and
+		 * interval in milliseconds, and the current budget
+		 */
+		public function get frameGovernorStats() : Object
+		{
+			return extContext.call( "frameGovernorStats" );
+		}
+		
+		/**
+		 * Frames passed to scanBitmapData() are only searched when sharp
+		 * enough, i.e. their focus measure reaches sharpnessRatio of what
+		 * recent frames reached, and when the mean luma change from the
+		 * previous frame is at most maxMotion (0-255). Others are reported
+		 * as RESULT_FLAG_BLURRED records
+		 */
+		public function setFrameGate( enabled:Boolean=true, sharpnessRatio:Number=0.5, maxMotion:Number=10 ) : void
+		{
+			extContext.call( "setFrameGate", enabled, sharpnessRatio, maxMotion );
+		}
+		
+		/**
+		 * Frame gate counters: frames, passed, blurred and moving
+		 */
+		public function get frameGateStats() : Object
+		{
+			return extContext.call( "frameGateStats" );
+		}
+		
+		/**
+		 * Only converts and searches the given part of scanBitmapData()
+		 * frames, normalized to the bitmap (0-1). A centre viewfinder is
+		 * on from the start; pass enabled false to scan whole frames.
+		 * After fallbackMisses frames in a row without a match one full
+		 * frame is scanned, 0 never does. Corners are reported for the
+		 * whole frame all the same
+		 */
+		public function setRegionOfInterest( enabled:Boolean=true, x:Number=0.2, y:Number=0.2, width:Number=0.6, height:Number=0.6, fallbackMisses:uint=5 ) : void
+		{
+			extContext.call( "setRegionOfInterest", enabled, x, y, width, height, fallbackMisses );
+		}
+		
+		/**
+		 * Region of interest counters: frames, cropped, fallbacks,
+		 * fallbackHits and pixelRatio, the share of pixels converted
+		 */
+		public function get regionOfInterestStats() : Object
+		{
+			return extContext.call( "regionOfInterestStats" );
+		}
+		
+		/**
+		 * When both barcodes and images are requested, scanBatch() (and
+		 * scanBitmapData() or scanEncodedBytes() without parallel lanes)
+		 * tries one after the other and stops at the first match.
+		 * CASCADE_BARCODE_FIRST (the default) decodes barcodes first,
+		 * CASCADE_IMAGE_FIRST matches images first
+		 */
+		public function setCascadeOrder( order:uint ) : void
+		{
+			extContext.call( "setCascadeOrder", order );
+		}
+		
+		/**
+		 * With enabled, images that scanBitmapData() or scanEncodedBytes()
+		 * could not match on the device are searched on the server, one at
+		 * a time; the answer comes as a record of origin 2. A search that
+		 * takes longer than deadline seconds is cancelled and reported as
+		 * a RESULT_FLAG_TIMEOUT record. The deadline also applies to the
+		 * server searches of the camera UI in SCAN_MODE_MANUAL, 0 for none.
+		 * The query first goes through a grayscale JPEG of the given
+		 * quality, 0 to 1, which smooths out sensor noise before the SDK
+		 * encodes its upload; 0 hands the SDK the raw pixels
+		 */
+		public function setServerFallback( enabled:Boolean, deadline:Number=4, quality:Number=0.7 ) : void
+		{
+			extContext.call( "setServerFallback", enabled, deadline, quality );
+		}
+		
+		/**
+		 * Server fallback counters: requests, hits, misses, errors,
+		 * timeouts, busy and offline (misses reported without asking the
+		 * server), averageTime in milliseconds, prepared (queries run
+		 * through a JPEG) and averagePreparedBytes, the size of those
+		 * JPEGs. The SDK re-encodes the query, so this is not the upload
+		 * size
+		 */
+		public function get serverFallbackStats() : Object
+		{
+			return extContext.call( "serverFallbackStats" );
+		}
+		
+		/**
+		 * HTTP proxy for the scanners opened from now on, e.g. a test
+		 * server; an empty host for none
+		 */
+		public function setProxy( host:String, port:uint=80 ) : void
+		{
+			extContext.call( "setProxy", host, port );
+		}
+		
+		/**
+		 * scanBitmapData() frames are matched with SEARCH_DEFAULT. Once a
+		 * sharp, steady scene has missed that many times in a row, it is
+		 * searched once with SEARCH_SMALL_TARGET, which finds small or
+		 * distant items at a higher cost; each further try on the scene
+		 * needs twice the misses. Pointing at another scene starts over.
+		 * noPartial adds SEARCH_NO_PARTIAL to every search, against false
+		 * positives
+		 */
+		public function setSearchEscalation( enabled:Boolean=true, misses:uint=3, noPartial:Boolean=false ) : void
+		{
+			extContext.call( "setSearchEscalation", enabled, misses, noPartial );
+		}
+		
+		/**
+		 * Search counters per option, { standard, smallTarget }, each with
+		 * runs, hits and time in milliseconds, and sceneChanges. Passing
+		 * true resets them
+		 */
+		public function searchStats( reset:Boolean=false ) : Object
+		{
+			return extContext.call( "searchStats", reset );
+		}
+		
+		/**
+		 * On devices with several cores scanBitmapData() and
+		 * scanEncodedBytes() decode barcodes and match images at the same
+		 * time, and report the first match without waiting for the other
+		 * stage. The cascade order breaks ties
+		 */
+		public function setParallelLanes( enabled:Boolean ) : void
+		{
+			extContext.call( "setParallelLanes", enabled );
+		}
+		
+		/**
+		 * Cascade counters, { decode, search }, each with runs, hits,
+		 * skipped (another stage had matched) and time in milliseconds,
+		 * and lanes, { runs, early }: parallel scans and those answered
+		 * before the slower stage was done
+		 */
+		public function get cascadeStats() : Object
+		{
+			return extContext.call( "cascadeStats" );
+		}
+		
+		/**
+		 * Frames passed to scanBitmapData() that differ from one scanned
+		 * less than ttl seconds ago by at most maxDistance bits of their
+		 * 64 bit perceptual hash reuse its result instead of searching
+		 * again. 1 second and 4 bits by default, a ttl of 0 turns it off
+		 */
+		public function setSceneCache( ttl:Number=1, maxDistance:uint=4 ) : void
+		{
+			extContext.call( "setSceneCache", ttl, maxDistance );
+		}
+		
+		/**
+		 * Scene cache counters: lookups, hits, and savedTime, the
+		 * milliseconds of search the hits replaced
+		 */
+		public function get sceneCacheStats() : Object
+		{
+			return extContext.call( "sceneCacheStats" );
+		}
+		
+		/**
+		 * Scans a JPEG or PNG file image, e.g. a photo loaded from the
+		 * camera roll, without decoding it in ActionScript. Only the
+		 * compressed bytes are copied during the call; the image is decoded
+		 * at the smallest size recognition needs, in the background, and
+		 * the outcome arrives with Event.CHANGE like scanBitmapData(), or a
+		 * RESULT_FLAG_ERROR record if the file turns out to be corrupt
+		 * 
+		 * @return
+		 * false if the scanner is not open or the bytes are not JPEG or PNG
+		 */
+		public function scanEncodedBytes( bytes:ByteArray, resultTypes:uint=RESULT_TYPES_DEFAULT, tag:uint=0 ) : Boolean
+		{
+			return extContext.call( "scanEncodedBytes", bytes, resultTypes, tag ) as Boolean;
+		}
+		
+		/**
+		 * Scans many images on a pool of native worker threads, one per
+		 * CPU core. Results arrive with Event.CHANGE in completion order,
+		 * as SOURCE_BATCH records tagged with the image's index; an image that
+		 * cannot be read or decoded gets a RESULT_FLAG_ERROR record instead of
+		 * a miss. Event.COMPLETE (or Event.CANCEL after cancelBatch()) follows
+		 * the last result.
+		 * Only one batch runs at a time across all scanner instances
+		 * 
+		 * @required
+		 * images Vector.<BitmapData> or Vector.<ByteArray> of JPEG/PNG files
+		 * 
+		 * @return
+		 * false if the scanner is not open or a batch is already running
+		 */
+		public function scanBatch( images:Object, resultTypes:uint=RESULT_TYPES_DEFAULT ) : Boolean
+		{
+			return extContext.call( "scanBatch", images, resultTypes ) as Boolean;
+		}
+		
+		/**
+		 * Stops the running batch. Images already being recognized still
+		 * report their result
+		 */
+		public function cancelBatch() : void
+		{
+			extContext.call( "cancelBatch" );
+		}
+		
+		/**
+		 * Counters of the native pixel buffer pool shared by all scanners:
+		 * allocations, reuses, bytesInUse, bytesCached, highWaterInUse,
+		 * highWaterTotal and capacity. allocations stops growing once
+		 * frames of a steady size are scanned
+		 */
+		public function get bufferPoolStats() : Object
+		{
+			return extContext.call( "bufferPoolStats" );
+		}
+		
+		/**
+		 * Limits how many scanners of different API keys stay open,
+		 * and how many bytes of local databases they may keep. The
+		 * least recently used ones are closed first; the one in use
+		 * always stays. 4 scanners and 64 MB by default
+		 */
+		public function setScannerPoolLimits( maxScanners:uint=4, maxBytes:Number=67108864 ) : void
+		{
+			extContext.call( "setScannerPoolLimits", maxScanners, maxBytes );
+		}
+		
+		/**
+		 * Counters of the pool of open scanners: open, bytes, hits,
+		 * misses, evictions, and the duration of the last switch to
+		 * another API key (lastSwitchTime, milliseconds) along with
+		 * whether that scanner was still open (lastSwitchPooled)
+		 */
+		public function get scannerPoolStats() : Object
+		{
+			return extContext.call( "scannerPoolStats" );
+		}
+		
+		/**
+		 * Caps the bytes the native buffer pool keeps around,
+		 * 32 MB by default
+		 */
+		public function set bufferPoolCapacity( value:uint ) : void
+		{
+			extContext.call( "setBufferPoolCapacity", value );
+		}
+		
+		/**
+		 * Milliseconds from the last runScanner() call until the camera
+		 * delivered frames. The scanner stays open between presentations,
+		 * so only the first one pays for opening the local database
+		 */
+		public function get timeToFirstFrame() : Number
+		{
+			return lastTimeToFirstFrame;
+		}
+		
+		/**
+		 * Milestones of the extension's cold start in milliseconds since it
+		 * was initialized: extension, context, prewarm, bundle, open, view,
+		 * runScanner, present, camera and sync, as far as reached
+		 */
+		public function get coldStartTimeline() : Object
+		{
+			return extContext.call( "coldStartTimeline" );
+		}
+		
+		/**
+		 * Number of images processed by the last finished batch
+		 */
+		public function get batchProcessed() : uint
+		{
+			return lastBatchProcessed;
 		}
 		
 		/**
@@ -79,7 +670,10 @@ package com.webspiders.extension
 		{
 			extContext.call( "releaseScanner" );
 			setTimeout( extContext.dispose, 500 );
+			delete INSTANCES[contextType];
 			matchValue = null;
+			resultsLength = 0;
+			lastResultOffset = -1;
 		}
 		
 		/**
@@ -90,9 +684,36 @@ package com.webspiders.extension
 		 */
 		public function getValue() : String
 		{
+			// decoded lazily so a busy scan loop does not build strings nobody reads
+			if ( !matchValue && lastResultOffset >= 0 )
+			{
+				results.position = lastResultOffset;
+				var type:uint = results.readUnsignedInt();
+				results.position = lastResultOffset + 6;
+				var flags:uint = results.readUnsignedByte();
+				results.position = lastResultOffset + 12;
+				var idLength:uint = results.readUnsignedInt();
+				results.position = lastResultOffset + RESULT_HEADER_SIZE + (( flags & RESULT_FLAG_CORNERS ) ? RESULT_CORNERS_SIZE : 0);
+				matchValue = (( type == RESULT_TYPE_IMAGE ) ? "Image" : "Barcode") +":\n"+ results.readUTFBytes( idLength );
+			}
 			return matchValue;
 		}
 		
+		/**
+		 * Packed results received with the last Event.CHANGE, see RESULT_HEADER_SIZE
+		 * for the record layout. The same ByteArray is reused between events, only the
+		 * first resultBufferLength bytes are valid.
+		 */
+		public function get resultBuffer() : ByteArray
+		{
+			return results;
+		}
+		
+		public function get resultBufferLength() : uint
+		{
+			return resultsLength;
+		}
+		
 		//--------------------------------------------------------------------------
 		//
 		//  LISTENERS API
@@ -104,8 +725,63 @@ package com.webspiders.extension
 		 */
 		private function onStatus( event:StatusEvent ) : void
 		{
-			matchValue = event.level;
-			dispatchEvent( new Event(Event.CHANGE) );
+			if ( event.code == "resultsAvailable" )
+			{
+				// the buffer is about to be reused, keep an unread match decodable
+				if ( lastResultOffset >= 0 ) getValue();
+				lastResultOffset = -1;
+				
+				resultsLength = extContext.call( "drainResults", results ) as uint;
+				if ( resultsLength == 0 ) return;
+				
+				// remember where the newest match starts, getValue() decodes it on demand
+				var offset:uint = 0;
+				while ( offset < resultsLength )
+				{
+					results.position = offset;
+					if ( results.readUnsignedInt() != RESULT_TYPE_NONE ) lastResultOffset = offset;
+					results.position = offset + 6;
+					var flags:uint = results.readUnsignedByte();
+					results.position = offset + 12;
+					offset += RESULT_HEADER_SIZE + results.readUnsignedInt() + (( flags & RESULT_FLAG_CORNERS ) ? RESULT_CORNERS_SIZE : 0);
+				}
+				if ( lastResultOffset >= 0 ) matchValue = null;
+				results.position = 0;
+				dispatchEvent( new Event(Event.CHANGE) );
+			}
+			else if ( event.code == "jobsCompleted" )
+			{
+				// one status event for any number of completions
+				var length:uint = extContext.call( "drainJobs", jobs ) as uint;
+				jobs.position = 0;
+				while ( jobs.position < length )
+				{
+					var jobId:uint = jobs.readUnsignedInt();
+					var operation:uint = jobs.readUnsignedInt();
+					var errorCode:int = jobs.readInt();
+					dispatchEvent( new MoodstocksJobEvent(MoodstocksJobEvent.JOB_COMPLETE, jobId, operation, errorCode) );
+				}
+			}
+			else if ( event.code == SYNC_STATUS )
+			{
+				// "syncing,progress,error,apiKey"
+				var status:Array = event.level.split( "," );
+				syncing = status[0] == "1";
+				lastSyncProgress = int( status[1] );
+				lastSyncError = int( status[2] );
+				lastSyncApiKey = status.slice( 3 ).join( "," );
+				dispatchEvent( new Event(SYNC_STATUS) );
+			}
+			else if ( event.code == CAMERA_READY )
+			{
+				lastTimeToFirstFrame = Number( event.level );
+				dispatchEvent( new Event(CAMERA_READY) );
+			}
+			else if ( event.code == "batchComplete" || event.code == "batchCancelled" )
+			{
+				lastBatchProcessed = uint( event.level );
+				dispatchEvent( new Event(event.code == "batchComplete" ? Event.COMPLETE : Event.CANCEL) );
+			}
 		}
 	}
 }
@@ -0,0 +1,156 @@
+//
+//  BufferPool.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "BufferPool.h"
+
+#include <stdlib.h>
+
+namespace msane {
+
+BufferPool::BufferPool(size_t capacity)
+    : _capacity(capacity), _inUse(0), _cached(0), _highInUse(0), _highTotal(0),
+      _allocations(0), _reuses(0)
+{
+    for (int c = 0; c < kClassCount; c++)
+        for (int s = 0; s < kSlotsPerClass; s++)
+            _slots[c][s] = NULL;
+}
+
+BufferPool::~BufferPool()
+{
+    trim();
+}
+
+BufferPool &BufferPool::shared()
+{
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+int BufferPool::classIndex(size_t bytes)
+{
+    int index = 0;
+    size_t size = (size_t) 1 << kMinClassShift;
+    while (size < bytes) {
+        size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+size_t BufferPool::classSize(size_t bytes)
+{
+    int index = classIndex(bytes);
+    if (index >= kClassCount)
+        return bytes;
+    return (size_t) 1 << (kMinClassShift + index);
+}
+
+void BufferPool::raise(std::atomic<size_t> &highWater, size_t value)
+{
+    size_t seen = highWater.load(std::memory_order_relaxed);
+    while (value > seen && !highWater.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+        ;
+}
+
+// Counts `size` more cached bytes if they fit the capacity. A block is only
+// put in a slot after its bytes are counted, so whoever pops it can always
+// take them back out without _cached wrapping around.
+bool BufferPool::reserve(size_t size, size_t inUse)
+{
+    size_t cached = _cached.load(std::memory_order_relaxed);
+    do {
+        if (inUse + cached + size > _capacity.load(std::memory_order_relaxed))
+            return false;
+    } while (!_cached.compare_exchange_weak(cached, cached + size, std::memory_order_relaxed));
+    return true;
+}
+
+void *BufferPool::acquire(size_t bytes)
+{
+    int index = classIndex(bytes);
+    size_t size = classSize(bytes);
+    void *buffer = NULL;
+
+    if (index < kClassCount) {
+        // taking a slot is a plain exchange, so there is no ABA to guard against
+        for (int s = 0; s < kSlotsPerClass && buffer == NULL; s++) {
+            if (_slots[index][s].load(std::memory_order_relaxed) != NULL)
+                buffer = _slots[index][s].exchange(NULL, std::memory_order_acquire);
+        }
+    }
+
+    if (buffer != NULL) {
+        _cached -= size;
+        _reuses++;
+    } else {
+        buffer = malloc(size);
+        if (buffer == NULL)
+            return NULL;
+        _allocations++;
+    }
+
+    size_t inUse = (_inUse += size);
+    raise(_highInUse, inUse);
+    raise(_highTotal, inUse + _cached.load(std::memory_order_relaxed));
+    return buffer;
+}
+
+void BufferPool::release(void *buffer, size_t bytes)
+{
+    if (buffer == NULL)
+        return;
+
+    int index = classIndex(bytes);
+    size_t size = classSize(bytes);
+    size_t inUse = (_inUse -= size);
+
+    if (index < kClassCount && reserve(size, inUse)) {
+        for (int s = 0; s < kSlotsPerClass; s++) {
+            void *expected = NULL;
+            if (_slots[index][s].compare_exchange_strong(expected, buffer, std::memory_order_release))
+                return;
+        }
+        _cached -= size;
+    }
+    free(buffer);
+}
+
+void BufferPool::setCapacity(size_t capacity)
+{
+    _capacity = capacity;
+    if (_inUse.load() + _cached.load() > capacity)
+        trim();
+}
+
+void BufferPool::trim()
+{
+    for (int c = 0; c < kClassCount; c++) {
+        for (int s = 0; s < kSlotsPerClass; s++) {
+            void *buffer = _slots[c][s].exchange(NULL, std::memory_order_acquire);
+            if (buffer != NULL) {
+                _cached -= (size_t) 1 << (kMinClassShift + c);
+                free(buffer);
+            }
+        }
+    }
+}
+
+BufferPoolStats BufferPool::stats() const
+{
+    BufferPoolStats stats;
+    stats.allocations = _allocations.load();
+    stats.reuses = _reuses.load();
+    stats.bytesInUse = _inUse.load();
+    stats.bytesCached = _cached.load();
+    stats.highWaterInUse = _highInUse.load();
+    stats.highWaterTotal = _highTotal.load();
+    stats.capacity = _capacity.load();
+    return stats;
+}
+
+} // namespace msane
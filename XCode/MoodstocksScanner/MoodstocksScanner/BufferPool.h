@@ -0,0 +1,102 @@
+//
+//  BufferPool.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_BufferPool_h
+#define MoodstocksScanner_BufferPool_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace msane {
+
+struct BufferPoolStats {
+    uint64_t allocations;       // buffers that had to come from malloc
+    uint64_t reuses;            // buffers handed out from the pool
+    size_t bytesInUse;          // acquired and not yet released
+    size_t bytesCached;         // idle in the pool
+    size_t highWaterInUse;
+    size_t highWaterTotal;      // in use + cached
+    size_t capacity;
+};
+
+// Power of two size classes of pixel buffers shared by every conversion and
+// scan stage. Idle buffers sit in a few lock-free slots per class, so
+// acquire() and release() are a handful of atomic exchanges and, once a
+// steady frame size is reached, never touch the heap. Released buffers are
+// freed instead of cached while the pool holds more than its capacity.
+class BufferPool {
+public:
+    explicit BufferPool(size_t capacity = 32 * 1024 * 1024);
+    ~BufferPool();
+
+    // Returns at least `bytes` bytes, NULL only if malloc fails
+    void *acquire(size_t bytes);
+
+    // `bytes` must be the size passed to acquire()
+    void release(void *buffer, size_t bytes);
+
+    void setCapacity(size_t capacity);
+
+    // Frees every idle buffer, e.g. on a memory warning
+    void trim();
+
+    BufferPoolStats stats() const;
+
+    // Size actually reserved for a request of `bytes`
+    static size_t classSize(size_t bytes);
+
+    // One pool for the whole extension, never torn down
+    static BufferPool &shared();
+
+private:
+    BufferPool(const BufferPool &);
+    BufferPool &operator=(const BufferPool &);
+
+    static const int kMinClassShift = 12;   // 4 KB
+    static const int kClassCount = 13;      // up to 16 MB, larger is not pooled
+    static const int kSlotsPerClass = 8;
+
+    static int classIndex(size_t bytes);
+    static void raise(std::atomic<size_t> &highWater, size_t value);
+    bool reserve(size_t size, size_t inUse);
+
+    std::atomic<void *> _slots[kClassCount][kSlotsPerClass];
+    std::atomic<size_t> _capacity;
+    std::atomic<size_t> _inUse;
+    std::atomic<size_t> _cached;
+    std::atomic<size_t> _highInUse;
+    std::atomic<size_t> _highTotal;
+    std::atomic<uint64_t> _allocations;
+    std::atomic<uint64_t> _reuses;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,73 @@
+//
+//  Cascade.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "Cascade.h"
+
+#include <string.h>
+
+namespace msane {
+
+Cascade::Cascade()
+    : _order(CascadeBarcodeFirst)
+{
+    reset();
+}
+
+void Cascade::setOrder(CascadeOrder order)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _order = order;
+}
+
+CascadeOrder Cascade::order() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _order;
+}
+
+int Cascade::stages(bool barcodes, bool image, CascadeStage out[kCascadeStages]) const
+{
+    int count = 0;
+    if (order() == CascadeImageFirst) {
+        if (image) out[count++] = CascadeStageSearch;
+        if (barcodes) out[count++] = CascadeStageDecode;
+    } else {
+        if (barcodes) out[count++] = CascadeStageDecode;
+        if (image) out[count++] = CascadeStageSearch;
+    }
+    return count;
+}
+
+void Cascade::record(CascadeStage stage, double seconds, bool hit)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    StageStats &stats = _stages[stage];
+    stats.runs++;
+    if (hit)
+        stats.hits++;
+    stats.time += seconds;
+}
+
+void Cascade::skip(CascadeStage stage)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _stages[stage].skipped++;
+}
+
+void Cascade::reset()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    memset(_stages, 0, sizeof(_stages));
+}
+
+StageStats Cascade::stats(CascadeStage stage) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stages[stage];
+}
+
+} // namespace msane
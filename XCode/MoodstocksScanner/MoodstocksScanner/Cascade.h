@@ -0,0 +1,89 @@
+//
+//  Cascade.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_Cascade_h
+#define MoodstocksScanner_Cascade_h
+
+#include <stdint.h>
+
+#include <mutex>
+
+namespace msane {
+
+// Recognition stages of a query, see MSScanner
+enum CascadeStage {
+    CascadeStageDecode = 0,     // decodeWithQuery:, barcodes
+    CascadeStageSearch = 1,     // searchWithQuery:, image matching
+    kCascadeStages = 2
+};
+
+// Which stage runs first; the other one only runs if the first found
+// nothing. Barcodes are cheap to rule out on most frames, image matching
+// is cheaper when products rarely carry a code.
+enum CascadeOrder {
+    CascadeBarcodeFirst = 0,
+    CascadeImageFirst   = 1
+};
+
+struct StageStats {
+    uint64_t runs;
+    uint64_t hits;
+    uint64_t skipped;           // wanted, but an earlier stage already matched
+    double time;                // seconds spent in the stage, query included
+};
+
+// Stage order and per stage latency counters, shared by the scan queue and
+// the batch workers
+class Cascade {
+public:
+    Cascade();
+
+    void setOrder(CascadeOrder order);
+    CascadeOrder order() const;
+
+    // Fills `stages` with the stages to try in order for the wanted result
+    // types and returns how many there are
+    int stages(bool barcodes, bool image, CascadeStage out[kCascadeStages]) const;
+
+    void record(CascadeStage stage, double seconds, bool hit);
+    void skip(CascadeStage stage);
+    void reset();
+
+    StageStats stats(CascadeStage stage) const;
+
+private:
+    Cascade(const Cascade &);
+    Cascade &operator=(const Cascade &);
+
+    CascadeOrder _order;
+    StageStats _stages[kCascadeStages];
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
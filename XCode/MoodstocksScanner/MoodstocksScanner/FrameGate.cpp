@@ -0,0 +1,186 @@
+//
+//  FrameGate.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "FrameGate.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace msane {
+
+FrameGate::FrameGate(const GatePolicy &policy)
+    : _policy(policy), _frames(0), _passed(0), _blurred(0), _moving(0)
+{
+    reset();
+}
+
+void FrameGate::setPolicy(const GatePolicy &policy)
+{
+    _policy = policy;
+    reset();
+}
+
+void FrameGate::reset()
+{
+    _width = 0;
+    _height = 0;
+    _previousWidth = 0;
+    _previousHeight = 0;
+    _peak = 0;
+    _peakTime = 0;
+}
+
+GateVerdict FrameGate::evaluate(const GrayView &plane, double now)
+{
+    GateVerdict verdict = { true, false, false, 0, 0 };
+    if (!_policy.enabled)
+        return verdict;
+
+    _frames++;
+    _previous.swap(_sample);
+    _previousWidth = _width;
+    _previousHeight = _height;
+    downsample(plane);
+    if (_width < 3 || _height < 3) {
+        _passed++;
+        return verdict;
+    }
+
+    verdict.sharpness = laplacianVariance();
+    verdict.motion = motion();
+
+    // the peak decays so a scene that cannot get sharper is accepted again
+    if (_peak > 0 && now > _peakTime)
+        _peak *= pow(0.5, (now - _peakTime) / _policy.peakHalfLife);
+    _peakTime = now;
+    if (verdict.sharpness > _peak)
+        _peak = verdict.sharpness;
+
+    verdict.blurred = verdict.sharpness < _policy.sharpnessRatio * _peak;
+    verdict.moving = verdict.motion > _policy.maxMotion;
+    verdict.pass = !verdict.blurred && !verdict.moving;
+
+    if (verdict.pass)
+        _passed++;
+    else if (verdict.moving)
+        _moving++;
+    else
+        _blurred++;
+    return verdict;
+}
+
+GateStats FrameGate::stats() const
+{
+    GateStats stats;
+    stats.frames = _frames;
+    stats.passed = _passed;
+    stats.blurred = _blurred;
+    stats.moving = _moving;
+    return stats;
+}
+
+//
+//  Private
+//
+
+// Box average by a whole factor; the sums are kept per column so the inner
+// loops are uniform and the compiler vectorizes them
+void FrameGate::downsample(const GrayView &plane)
+{
+    int longest = plane.width > plane.height ? plane.width : plane.height;
+    int factor = longest / _policy.sampleSide;
+    if (factor < 1)
+        factor = 1;
+    if (factor > 16)
+        factor = 16;    // 16 x 16 x 255 still fits the uint16 sums
+
+    _width = plane.width / factor;
+    _height = plane.height / factor;
+    if (_sample.size() < (size_t) _width * _height)
+        _sample.resize((size_t) _width * _height);
+    if (_row.size() < (size_t) plane.width)
+        _row.resize(plane.width);
+
+    int shift = 0;
+    bool powerOfTwo = (factor & (factor - 1)) == 0;
+    while ((1 << shift) < factor * factor)
+        shift++;
+    int area = factor * factor;
+
+    uint16_t *row = &_row[0];
+    for (int y = 0; y < _height; y++) {
+        const uint8_t *in = plane.pixels + (size_t) y * factor * plane.stride;
+        for (int x = 0; x < plane.width; x++)
+            row[x] = in[x];
+        for (int j = 1; j < factor; j++) {
+            in += plane.stride;
+            for (int x = 0; x < plane.width; x++)
+                row[x] = (uint16_t) (row[x] + in[x]);
+        }
+
+        uint8_t *out = &_sample[(size_t) y * _width];
+        for (int x = 0; x < _width; x++) {
+            const uint16_t *p = row + x * factor;
+            unsigned sum = 0;
+            for (int i = 0; i < factor; i++)
+                sum += p[i];
+            out[x] = (uint8_t) (powerOfTwo ? sum >> shift : sum / area);
+        }
+    }
+}
+
+double FrameGate::laplacianVariance() const
+{
+    const uint8_t *s = &_sample[0];
+    int64_t sum = 0;
+    int64_t squares = 0;
+
+    for (int y = 1; y < _height - 1; y++) {
+        const uint8_t *up = s + (size_t) (y - 1) * _width;
+        const uint8_t *mid = up + _width;
+        const uint8_t *down = mid + _width;
+
+        int32_t rowSum = 0;
+        int32_t rowSquares = 0;
+        for (int x = 1; x < _width - 1; x++) {
+            int32_t l = 4 * mid[x] - mid[x - 1] - mid[x + 1] - up[x] - down[x];
+            rowSum += l;
+            rowSquares += l * l;
+        }
+        sum += rowSum;
+        squares += rowSquares;
+    }
+
+    double count = (double) (_width - 2) * (_height - 2);
+    double mean = sum / count;
+    return squares / count - mean * mean;
+}
+
+double FrameGate::motion() const
+{
+    if (_previousWidth != _width || _previousHeight != _height)
+        return 0;
+
+    const uint8_t *a = &_sample[0];
+    const uint8_t *b = &_previous[0];
+    size_t count = (size_t) _width * _height;
+
+    uint64_t total = 0;
+    for (int y = 0; y < _height; y++) {
+        uint32_t rowTotal = 0;
+        for (int x = 0; x < _width; x++) {
+            int d = a[x] - b[x];
+            rowTotal += (uint32_t) (d < 0 ? -d : d);
+        }
+        total += rowTotal;
+        a += _width;
+        b += _width;
+    }
+    return (double) total / count;
+}
+
+} // namespace msane
@@ -0,0 +1,114 @@
+//
+//  FrameGate.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_FrameGate_h
+#define MoodstocksScanner_FrameGate_h
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "PixelConvert.h"
+
+namespace msane {
+
+struct GatePolicy {
+    bool enabled;
+    double sharpnessRatio;      // of the recent peak a frame needs to be searched
+    double peakHalfLife;        // seconds for the recent peak to decay by half
+    double maxMotion;           // mean absolute luma change from the previous frame
+    int sampleSide;             // longest side the plane is measured at
+
+    GatePolicy()
+        : enabled(true), sharpnessRatio(0.5), peakHalfLife(2.0),
+          maxMotion(10.0), sampleSide(160) {}
+};
+
+struct GateVerdict {
+    bool pass;
+    bool blurred;
+    bool moving;
+    double sharpness;           // variance of the Laplacian
+    double motion;
+};
+
+struct GateStats {
+    uint64_t frames;
+    uint64_t passed;
+    uint64_t blurred;
+    uint64_t moving;
+};
+
+// Keeps frames that cannot match away from the search: motion blurred
+// ones, whose focus measure (variance of the Laplacian of a downsampled
+// luma plane) is well under what the scene recently reached, and frames
+// taken while the camera moves (mean absolute difference from the previous
+// one). The threshold follows the recent peak, which decays over time, so
+// a plain scene is not rejected forever. Not thread safe, except stats()
+// which may be read from any thread.
+class FrameGate {
+public:
+    explicit FrameGate(const GatePolicy &policy = GatePolicy());
+
+    void setPolicy(const GatePolicy &policy);
+    const GatePolicy &policy() const { return _policy; }
+
+    GateVerdict evaluate(const GrayView &plane, double now);
+
+    // Forgets the previous frame and the peak, e.g. for a new frame source
+    void reset();
+
+    GateStats stats() const;
+
+private:
+    FrameGate(const FrameGate &);
+    FrameGate &operator=(const FrameGate &);
+
+    void downsample(const GrayView &plane);
+    double laplacianVariance() const;
+    double motion() const;
+
+    GatePolicy _policy;
+    std::vector<uint8_t> _sample;
+    std::vector<uint8_t> _previous;
+    std::vector<uint16_t> _row;
+    int _width;
+    int _height;
+    int _previousWidth;
+    int _previousHeight;
+    double _peak;
+    double _peakTime;
+    std::atomic<uint64_t> _frames;
+    std::atomic<uint64_t> _passed;
+    std::atomic<uint64_t> _blurred;
+    std::atomic<uint64_t> _moving;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,136 @@
+//
+//  FrameGovernor.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "FrameGovernor.h"
+
+#include <sys/resource.h>
+#include <time.h>
+
+namespace msane {
+
+static const double kSlowFrameRatio = 1.25;
+static const double kDecrease = 0.97;       // per slow UI frame
+static const double kIncrease = 0.005;      // per UI frame on time
+static const double kMinScale = 0.1;
+static const double kSlack = 0.001;         // capture timestamps jitter
+
+FrameGovernor::FrameGovernor(const GovernorPolicy &policy)
+    : _policy(policy), _admitted(0), _skipped(0)
+{
+    reset();
+}
+
+void FrameGovernor::setPolicy(const GovernorPolicy &policy)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _policy = policy;
+}
+
+bool FrameGovernor::admit(double now)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (_policy.cpuBudget <= 0 || now + kSlack >= _due) {
+        // keep the schedule rather than restart it from the frame that
+        // happened to arrive, else the rate is rounded down to a whole
+        // number of camera frames
+        double interval = this->interval();
+        _due = (now - _due < interval ? _due : now) + interval;
+        _admitted++;
+        return true;
+    }
+    _skipped++;
+    return false;
+}
+
+void FrameGovernor::processed(double cost)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    if (cost < 0)
+        cost = 0;
+    _cost = _cost < 0 ? cost : _cost + _policy.smoothing * (cost - _cost);
+}
+
+void FrameGovernor::uiFrame(double duration)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_policy.uiFrameTime <= 0)
+        return;
+
+    _uiTime = _uiTime < 0 ? duration : _uiTime + _policy.smoothing * (duration - _uiTime);
+    if (_uiTime > _policy.uiFrameTime * kSlowFrameRatio) {
+        _scale *= kDecrease;
+        if (_scale < kMinScale)
+            _scale = kMinScale;
+    } else if (_scale < 1) {
+        _scale += kIncrease;
+        if (_scale > 1)
+            _scale = 1;
+    }
+}
+
+void FrameGovernor::reset()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _cost = -1;
+    _uiTime = -1;
+    _scale = 1;
+    _due = 0;
+}
+
+GovernorStats FrameGovernor::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    GovernorStats stats;
+    stats.admitted = _admitted;
+    stats.skipped = _skipped;
+    stats.averageCost = _cost < 0 ? 0 : _cost;
+    stats.interval = interval();
+    stats.budget = budget();
+    return stats;
+}
+
+//
+//  Private, called with _lock held
+//
+
+double FrameGovernor::budget() const
+{
+    return _policy.cpuBudget * _scale;
+}
+
+double FrameGovernor::interval() const
+{
+    if (_policy.cpuBudget <= 0 || _cost < 0)
+        return _policy.minInterval;
+
+    double interval = _cost / budget();
+    if (interval < _policy.minInterval)
+        return _policy.minInterval;
+    if (interval > _policy.maxInterval)
+        return _policy.maxInterval;
+    return interval;
+}
+
+double processCpuTime()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+         + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+double threadCpuTime()
+{
+    struct timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+        return 0;
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+} // namespace msane
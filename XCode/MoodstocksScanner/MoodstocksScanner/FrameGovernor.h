@@ -0,0 +1,108 @@
+//
+//  FrameGovernor.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_FrameGovernor_h
+#define MoodstocksScanner_FrameGovernor_h
+
+#include <stdint.h>
+
+#include <mutex>
+
+namespace msane {
+
+struct GovernorPolicy {
+    double cpuBudget;           // share of one core spent scanning, 0 turns the governor off
+    double uiFrameTime;         // seconds, slower UI frames lower the budget; 0 ignores them
+    double minInterval;         // between processed frames, seconds
+    double maxInterval;
+    double smoothing;           // weight of a new sample in the averages
+
+    GovernorPolicy()
+        : cpuBudget(0.5), uiFrameTime(1.0 / 60), minInterval(1.0 / 30),
+          maxInterval(1.0), smoothing(0.2) {}
+};
+
+struct GovernorStats {
+    uint64_t admitted;
+    uint64_t skipped;
+    double averageCost;         // seconds of CPU per processed frame
+    double interval;            // current interval between processed frames
+    double budget;              // cpuBudget after UI pressure
+};
+
+// Decides which frames of a continuous scan are processed. The average
+// cost of a frame (EWMA) over the CPU budget gives the interval between
+// processed frames, so scanning uses about `cpuBudget` of a core whatever
+// the catalog size or search options. UI frames slower than `uiFrameTime`
+// lower the budget multiplicatively, good ones give it back slowly. Time
+// is passed in by the caller so the loop can be run in virtual time.
+// Thread safe.
+class FrameGovernor {
+public:
+    explicit FrameGovernor(const GovernorPolicy &policy = GovernorPolicy());
+
+    void setPolicy(const GovernorPolicy &policy);
+
+    // True if a frame arriving at `now` is to be processed
+    bool admit(double now);
+
+    // Reports the CPU time an admitted frame took
+    void processed(double cost);
+
+    void uiFrame(double duration);
+
+    // Forgets the averages, e.g. when the scanner or options change
+    void reset();
+
+    GovernorStats stats() const;
+
+private:
+    FrameGovernor(const FrameGovernor &);
+    FrameGovernor &operator=(const FrameGovernor &);
+
+    double interval() const;
+    double budget() const;
+
+    GovernorPolicy _policy;
+    double _cost;               // < 0 until the first frame
+    double _uiTime;             // < 0 until the first UI frame
+    double _scale;              // UI pressure, 0.1 to 1
+    double _due;                // when the next frame may be processed
+    uint64_t _admitted;
+    uint64_t _skipped;
+    mutable std::mutex _lock;
+};
+
+// CPU time used by the whole process so far, seconds
+double processCpuTime();
+
+// CPU time used by the calling thread so far, seconds
+double threadCpuTime();
+
+} // namespace msane
+
+#endif
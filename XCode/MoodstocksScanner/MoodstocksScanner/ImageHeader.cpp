@@ -0,0 +1,95 @@
+//
+//  ImageHeader.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "ImageHeader.h"
+
+#include <string.h>
+
+namespace msane {
+
+static int readBigEndian16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static uint32_t readBigEndian32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+// Walks the marker segments up to the first start of frame
+static bool readJpegHeader(const uint8_t *bytes, size_t length, ImageHeader *header)
+{
+    size_t offset = 2;
+    while (offset + 4 <= length) {
+        if (bytes[offset] != 0xff)
+            return false;
+
+        uint8_t marker = bytes[offset + 1];
+        if (marker == 0xff) {
+            // fill byte
+            offset++;
+            continue;
+        }
+        if (marker == 0xd8 || (marker >= 0xd0 && marker <= 0xd7) || marker == 0x01) {
+            offset += 2;
+            continue;
+        }
+
+        int segmentLength = readBigEndian16(bytes + offset + 2);
+        bool startOfFrame = marker >= 0xc0 && marker <= 0xcf &&
+                            marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+        if (startOfFrame) {
+            if (offset + 9 > length)
+                return false;
+            header->format = ImageFormatJPEG;
+            header->height = readBigEndian16(bytes + offset + 5);
+            header->width = readBigEndian16(bytes + offset + 7);
+            return header->width > 0 && header->height > 0;
+        }
+        if (marker == 0xd9 || marker == 0xda)
+            return false;
+
+        offset += 2 + segmentLength;
+    }
+    return false;
+}
+
+bool readImageHeader(const uint8_t *bytes, size_t length, ImageHeader *header)
+{
+    static const uint8_t kPngSignature[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+
+    header->format = ImageFormatUnknown;
+    header->width = 0;
+    header->height = 0;
+
+    if (length >= 4 && bytes[0] == 0xff && bytes[1] == 0xd8)
+        return readJpegHeader(bytes, length, header);
+
+    if (length >= 24 && memcmp(bytes, kPngSignature, 8) == 0 && memcmp(bytes + 12, "IHDR", 4) == 0) {
+        header->format = ImageFormatPNG;
+        header->width = (int) readBigEndian32(bytes + 16);
+        header->height = (int) readBigEndian32(bytes + 20);
+        return header->width > 0 && header->height > 0;
+    }
+    return false;
+}
+
+int scaledDecodeSide(const ImageHeader &header, int wanted)
+{
+    int longest = header.width > header.height ? header.width : header.height;
+    if (header.format != ImageFormatJPEG)
+        return longest;
+
+    // libjpeg rounds scaled sizes up
+    int denominator = 1;
+    while (denominator < 8 && (longest + 2 * denominator - 1) / (2 * denominator) >= wanted)
+        denominator *= 2;
+    return (longest + denominator - 1) / denominator;
+}
+
+} // namespace msane
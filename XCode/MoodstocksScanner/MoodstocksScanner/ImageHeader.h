@@ -0,0 +1,59 @@
+//
+//  ImageHeader.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_ImageHeader_h
+#define MoodstocksScanner_ImageHeader_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace msane {
+
+enum ImageFormat {
+    ImageFormatUnknown,
+    ImageFormatJPEG,
+    ImageFormatPNG
+};
+
+struct ImageHeader {
+    ImageFormat format;
+    int width;
+    int height;
+};
+
+// Reads the format and pixel size of an encoded JPEG or PNG without
+// decoding it
+bool readImageHeader(const uint8_t *bytes, size_t length, ImageHeader *header);
+
+// Longest side to decode at so that a JPEG is reduced purely by DCT
+// scaling (1/2, 1/4 or 1/8) while staying at least `wanted` pixels long.
+// Other formats decode at full size.
+int scaledDecodeSide(const ImageHeader &header, int wanted);
+
+} // namespace msane
+
+#endif
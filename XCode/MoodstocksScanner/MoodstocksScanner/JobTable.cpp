@@ -0,0 +1,82 @@
+//
+//  JobTable.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "JobTable.h"
+
+namespace msane {
+
+static_assert(sizeof(JobCompletion) == kJobCompletionSize, "packed job completion layout changed");
+
+JobTable::JobTable()
+    : _nextId(1), _notifyPending(false)
+{
+}
+
+uint32_t JobTable::begin(uint32_t operation)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    uint32_t id = _nextId++;
+    if (_nextId == 0)
+        _nextId = 1;
+    _running[id] = operation;
+    return id;
+}
+
+bool JobTable::finish(uint32_t id, int32_t error)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    std::map<uint32_t, uint32_t>::iterator it = _running.find(id);
+    if (it == _running.end())
+        return false;
+
+    JobCompletion completion;
+    completion.id = id;
+    completion.operation = it->second;
+    completion.error = error;
+    _completed.push_back(completion);
+    _running.erase(it);
+
+    bool notify = !_notifyPending;
+    _notifyPending = true;
+    return notify;
+}
+
+size_t JobTable::drain(JobCompletion *dst, size_t maxCount, bool *hasMore)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    size_t count = _completed.size() < maxCount ? _completed.size() : maxCount;
+    for (size_t i = 0; i < count; i++)
+        dst[i] = _completed[i];
+    _completed.erase(_completed.begin(), _completed.begin() + count);
+
+    _notifyPending = !_completed.empty();
+    if (hasMore)
+        *hasMore = _notifyPending;
+    return count;
+}
+
+size_t JobTable::runningCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _running.size();
+}
+
+size_t JobTable::completedCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _completed.size();
+}
+
+bool JobTable::isRunning(uint32_t id) const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _running.count(id) != 0;
+}
+
+} // namespace msane
@@ -0,0 +1,97 @@
+//
+//  JobTable.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_JobTable_h
+#define MoodstocksScanner_JobTable_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace msane {
+
+// Slow native operations that run in the background and report back by id
+enum JobOperation {
+    JobOperationOpen    = 1,
+    JobOperationClose   = 2,
+    JobOperationSync    = 3,
+    JobOperationPresent = 4,    // open, then present the camera UI
+    JobOperationDismiss = 5,    // dismiss the camera UI
+    JobOperationPrewarm = 6,    // open and load the camera UI ahead of time
+    JobOperationImport  = 7     // import a bundled signature database
+};
+
+// Packed exactly like this for ActionScript, little endian
+struct JobCompletion {
+    uint32_t id;
+    uint32_t operation;     // JobOperation
+    int32_t  error;         // 0 on success, else an MSError code or -1
+};
+
+static const size_t kJobCompletionSize = 12;
+
+// Hands out job ids and collects completions until ActionScript drains
+// them. Any number of completions between two drains are announced with
+// a single notification.
+class JobTable {
+public:
+    JobTable();
+
+    // Registers a running job, ids start at 1 and are never reused
+    uint32_t begin(uint32_t operation);
+
+    // Records the outcome of a running job. Returns true if the consumer has
+    // to be notified; false for unknown ids or when a notification is
+    // already outstanding.
+    bool finish(uint32_t id, int32_t error);
+
+    // Moves up to `maxCount` completions into `dst`, oldest first.
+    // `hasMore` is set when some are left behind.
+    size_t drain(JobCompletion *dst, size_t maxCount, bool *hasMore);
+
+    size_t runningCount() const;
+    size_t completedCount() const;
+    bool isRunning(uint32_t id) const;
+
+private:
+    JobTable(const JobTable &);
+    JobTable &operator=(const JobTable &);
+
+    uint32_t _nextId;
+    std::map<uint32_t, uint32_t> _running;     // id -> operation
+    std::vector<JobCompletion> _completed;
+    bool _notifyPending;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
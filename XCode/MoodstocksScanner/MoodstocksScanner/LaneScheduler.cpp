@@ -0,0 +1,137 @@
+//
+//  LaneScheduler.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "LaneScheduler.h"
+
+#include "FrameGovernor.h"
+
+namespace msane {
+
+LaneScheduler::LaneScheduler(unsigned threads)
+    : _job(NULL), _generation(0), _stopping(false)
+{
+    _stats.runs = 0;
+    _stats.early = 0;
+    _stats.cpuTime = 0;
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; i++)
+        _threads.push_back(std::thread(&LaneScheduler::workerLoop, this));
+}
+
+LaneScheduler::~LaneScheduler()
+{
+    settle();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (size_t i = 0; i < _threads.size(); i++)
+        _threads[i].join();
+}
+
+int LaneScheduler::run(LaneJob *job, int count)
+{
+    if (count <= 0)
+        return -1;
+    if (count > kMaxLanes)
+        count = kMaxLanes;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_job != NULL)
+        _done.wait(lock);
+
+    _job = job;
+    job->_count = count;
+    job->_next = 0;
+    job->_finished = 0;
+    job->_hits = 0;
+    job->_cpuTime = 0;
+    job->_cancelled = false;
+    _generation++;
+    _wake.notify_all();
+
+    // only this job's state: another caller's run may have started already
+    while (job->_hits == 0 && job->_finished < job->_count)
+        _done.wait(lock);
+
+    int winner = -1;
+    for (int lane = 0; lane < job->_count; lane++) {
+        if (job->_hits & (1u << lane)) {
+            winner = lane;
+            break;
+        }
+    }
+
+    _stats.runs++;
+    if (job->_finished < job->_count) {
+        job->_cancelled = true;
+        _stats.early++;
+    }
+    return winner;
+}
+
+double LaneScheduler::settle(LaneJob *job)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while (job->_finished < job->_count)
+        _done.wait(lock);
+    double cpu = job->_cpuTime;
+    job->_cpuTime = 0;
+    return cpu;
+}
+
+void LaneScheduler::settle()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_job != NULL)
+        _done.wait(lock);
+}
+
+LaneStats LaneScheduler::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+void LaneScheduler::workerLoop()
+{
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(_lock);
+    for (;;) {
+        while (!_stopping && (_job == NULL || _generation == seen))
+            _wake.wait(lock);
+        if (_stopping)
+            return;
+        seen = _generation;
+
+        // lanes are claimed one at a time, a pool smaller than the job
+        // still gets through all of them
+        while (_job != NULL && _job->_next < _job->_count) {
+            LaneJob *job = _job;
+            int lane = job->_next++;
+
+            lock.unlock();
+            double cpu = threadCpuTime();
+            bool hit = job->runLane(lane, job->_cancelled);
+            cpu = threadCpuTime() - cpu;
+            lock.lock();
+
+            job->_cpuTime += cpu;
+            _stats.cpuTime += cpu;
+
+            if (hit)
+                job->_hits |= 1u << lane;
+            if (++job->_finished == job->_count)
+                _job = NULL;
+            _done.notify_all();
+        }
+    }
+}
+
+} // namespace msane
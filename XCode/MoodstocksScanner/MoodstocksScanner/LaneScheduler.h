@@ -0,0 +1,124 @@
+//
+//  LaneScheduler.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_LaneScheduler_h
+#define MoodstocksScanner_LaneScheduler_h
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msane {
+
+static const int kMaxLanes = 8;
+
+class LaneScheduler;
+
+// Independent ways of looking at the same input, e.g. barcode decoding and
+// image matching of one query. The job carries the state of its last run,
+// so callers sharing a scheduler only ever see their own lanes.
+class LaneJob {
+public:
+    LaneJob() : _count(0), _next(0), _finished(0), _hits(0), _cpuTime(0), _cancelled(false) {}
+    virtual ~LaneJob() {}
+
+    // Runs lane `lane` and returns true on a hit. `cancelled` turns true once
+    // another lane has won; a lane checks it before its expensive steps and
+    // gives up with a miss.
+    virtual bool runLane(int lane, const std::atomic<bool> &cancelled) = 0;
+
+private:
+    LaneJob(const LaneJob &);
+    LaneJob &operator=(const LaneJob &);
+
+    friend class LaneScheduler;
+
+    // under the scheduler's lock
+    int _count;
+    int _next;
+    int _finished;
+    unsigned _hits;         // bit per lane
+    double _cpuTime;        // of the lanes done, until settle() hands it out
+    std::atomic<bool> _cancelled;
+};
+
+struct LaneStats {
+    uint64_t runs;
+    uint64_t early;     // answered while a lane was still running
+    double cpuTime;     // seconds of CPU the lanes used, counted once they are done
+};
+
+// Runs the lanes of one job at once on threads started once, and wakes the
+// caller up as soon as the outcome is known instead of when the slowest
+// lane is done. One job at a time; a run waits for the lanes of the
+// previous one, which may belong to another caller.
+class LaneScheduler {
+public:
+    explicit LaneScheduler(unsigned threads = 2);
+    ~LaneScheduler(); // waits for the last run and joins
+
+    unsigned threads() const { return (unsigned) _threads.size(); }
+
+    // Runs lanes 0 .. count - 1 of `job` and returns the winner: the first
+    // lane to hit, the lowest index if several hit before the caller woke
+    // up, or -1 if all missed. Lanes still running are cancelled and finish
+    // in the background; `job` and whatever they read must stay valid until
+    // settle(job).
+    int run(LaneJob *job, int count);
+
+    // Blocks until every lane of the last run of `job` is done and returns
+    // the seconds of CPU they used, once: a second call returns 0
+    double settle(LaneJob *job);
+
+    // Blocks until no lanes are running, whoever's they are
+    void settle();
+
+    LaneStats stats() const;
+
+private:
+    LaneScheduler(const LaneScheduler &);
+    LaneScheduler &operator=(const LaneScheduler &);
+
+    void workerLoop();
+
+    std::vector<std::thread> _threads;
+    LaneJob *_job;          // the one with lanes running or to claim
+    unsigned _generation;
+    bool _stopping;
+    LaneStats _stats;
+    mutable std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+};
+
+} // namespace msane
+
+#endif
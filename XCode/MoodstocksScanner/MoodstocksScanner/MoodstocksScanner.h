@@ -1,5 +1,5 @@
 //
-//  ScannerViewController.h
+//  MoodstocksScanner.h
 //  MoodstocksScanner
 
 // This code is distributed under the terms and conditions of the MIT license.
@@ -27,13 +27,22 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "FlashRuntimeExtensions.h"
+#import "ScannerViewController.h"
+
+// Native state of one ActionScript ExtensionContext, stored with
+// FRESetContextNativeData and released by the context finalizer
 @interface UIViewExtension :NSObject {
     UIWindow *camView;
 }
 
--(void)hideCam;
--(void)showCam:(NSString *)apikey apisecret:(NSString *)apisecret;
+-(id)initWithContext:(FREContext)ctx;
+-(void)dispose;
+-(uint32_t)hideCam;
+-(uint32_t)showCam:(NSString *)apikey apisecret:(NSString *)apisecret;
+-(uint32_t)showCam:(NSString *)apikey apisecret:(NSString *)apisecret mode:(ScannerMode)mode resultTypes:(int)resultTypes resultExtras:(int)resultExtras searchOptions:(int)searchOptions;
 
 @property(retain, nonatomic) UIWindow *camView;
+@property(copy, nonatomic) NSString *dbName;
 
 @end
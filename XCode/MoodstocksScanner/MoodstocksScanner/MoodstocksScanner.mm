@@ -0,0 +1,2859 @@
+//
+//  MoodstocksScanner.mm
+//  MoodstocksScanner
+//
+//  Created by Santanu.K on 08/04/14.
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#import "MoodstocksScanner.h"
+#import "FlashRuntimeExtensions.h"
+
+#import <ImageIO/ImageIO.h>
+#import <Moodstocks/Moodstocks.h>
+#import <SystemConfiguration/SystemConfiguration.h>
+
+#import "ScannerViewController.h"
+
+#include "BufferPool.h"
+#include "Cascade.h"
+#include "FrameGate.h"
+#include "FrameGovernor.h"
+#include "ImageHeader.h"
+#include "JobTable.h"
+#include "LaneScheduler.h"
+#include "PixelConvert.h"
+#include "RegionOfInterest.h"
+#include "Resample.h"
+#include "ResultRing.h"
+#include "ScannerPool.h"
+#include "SceneCache.h"
+#include "SearchEscalation.h"
+#include "ServerFallback.h"
+#include "SyncScheduler.h"
+#include "SyncStatus.h"
+#include "Timeline.h"
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+
+using namespace msane;
+
+// Scratch buffers for turning one image into a query. The scan queue owns
+// one, every batch worker has its own.
+struct ScanWorkspace {
+    Resampler resampler;
+    std::vector<uint8_t> queryPlane;
+    std::vector<uint8_t> decodePlane;
+};
+
+// One photo of a batch: a grayscale plane, or the encoded file when width
+// is 0. `bytes` comes from the shared BufferPool and goes back once scanned.
+struct BatchItem {
+    uint8_t *bytes;
+    size_t length;
+    int width;
+    int height;
+};
+
+class ScanBatchJob;
+class FrameLanes;
+
+@interface UIViewExtension () {
+    FREContext _context;
+    // the pooled scanner in use, written on _scanQueue under _openLock;
+    // other threads read them with openState:
+    MSScanner *_scanner;
+    NSString *_apiKey;
+    NSString *_apiSecret;
+    BOOL _isOpen;
+    MSScanner *_syncingScanner; // the one a sync runs on, any thread under _openLock
+    std::mutex _openLock;
+    ScannerViewController *_scannerUIViewController;
+    dispatch_queue_t _scanQueue;
+    ResultRing _results;
+    JobTable _jobs;
+    
+    std::weak_ptr<ScanBatchJob> _batch;
+    
+    // only touched on _scanQueue
+    NSMutableDictionary *_scanners;     // open scanners by API key
+    NSMutableDictionary *_syncObservers;    // their sync notification observers
+    ScannerPool _pool;
+    std::atomic<double> _lastSwitchDuration;   // also read by poolStats
+    std::atomic<bool> _lastSwitchPooled;
+    ScanWorkspace _workspace;
+    SceneCache _sceneCache;
+    FrameGate _frameGate;
+    NSMutableArray *_sceneResults;      // by SceneCache slot, NSNull for a miss
+    NSUInteger _scannerUsers;   // camera UI and headless calls, see acquireScanner
+    BOOL _cameraUser;
+    BOOL _headlessUser;
+    MSScanner *_cameraScanner;  // stays open while presented, even if not in use
+    
+    CFAbsoluteTime _presentTime;
+    ScannerMode _cameraMode;    // options of the next presentation, main thread
+    int _cameraResultTypes;
+    int _cameraResultExtras;
+    int _cameraSearchOptions;
+    
+    // auto mode duty cycle, main thread only
+    FrameGovernor _cameraGovernor;
+    CADisplayLink *_displayLink;
+    CFTimeInterval _lastDisplayTime;
+    BOOL _cameraProcessing;
+    double _burstStart;
+    double _burstCpu;
+    double _idleStart;
+    double _idleCpu;
+    double _idleCpuRate;        // preview and UI alone, CPU seconds per second
+    
+    FrameGovernor _frameGovernor;   // scanBitmap frames, any thread
+    RegionOfInterest _region;
+    
+    // headless recognition, any thread
+    Cascade _cascade;
+    SearchEscalation _escalation;
+    ServerFallback _fallback;
+    NSOperationQueue *_apiSearchQueue;  // fallback searches, cancelled one by one
+    NSString *_proxyHost;       // for scanners opened from now on, _scanQueue only
+    NSNumber *_proxyPort;
+    std::unique_ptr<FrameLanes> _frameLanes;    // these two _scanQueue only
+    BOOL _parallelLanes;
+    
+    // sync scheduling, main thread only
+    SyncScheduler _syncScheduler;
+    SCNetworkReachabilityRef _reachability;
+    NSMutableArray *_syncJobs;
+    NSUInteger _syncTimerGeneration;
+    BOOL _syncRestored;
+    
+    SyncStatusBoard _syncStatus;
+    
+    // sync bookkeeping, main thread only
+    UIBackgroundTaskIdentifier _syncBackgroundTask;
+    BOOL _syncInterrupted;
+    BOOL _syncResumePending;    // set with _syncInterrupted, cleared in the foreground
+    NSUInteger _syncCount;
+    unsigned long long _lastSyncBytes;
+    unsigned long long _totalSyncBytes;
+}
+
+-(void)pushResult:(MSResult *)result source:(ResultSource)source tag:(uint32_t)tag timestamp:(double)timestamp;
+-(void)pushResult:(MSResult *)result source:(ResultSource)source tag:(uint32_t)tag timestamp:(double)timestamp region:(const RoiRect &)region;
+-(MSResult *)recognizeStage:(CascadeStage)stage gray:(const uint8_t *)pixels width:(int)width height:(int)height resultTypes:(int)resultTypes level:(SearchLevel)level workspace:(ScanWorkspace &)workspace cancelled:(const std::atomic<bool> *)cancelled;
+-(void)scanBatchItem:(const BatchItem &)item index:(uint32_t)index resultTypes:(int)resultTypes workspace:(ScanWorkspace &)workspace;
+-(void)batchFinished:(size_t)processed cancelled:(bool)cancelled;
+-(void)reachabilityFlagsChanged:(SCNetworkReachabilityFlags)flags;
+
+@end
+
+static void reachabilityCallback(SCNetworkReachabilityRef target, SCNetworkReachabilityFlags flags, void *info)
+{
+    [(__bridge UIViewExtension *) info reachabilityFlagsChanged:flags];
+}
+
+// Shared by all contexts and never torn down, so the last reference to an
+// extension may safely go away on a worker thread
+static WorkerPool &batchPool()
+{
+    static WorkerPool *pool = new WorkerPool((unsigned) [[NSProcessInfo processInfo] activeProcessorCount]);
+    return *pool;
+}
+
+class ScanBatchJob : public BatchJob {
+public:
+    ScanBatchJob(UIViewExtension *extension, int resultTypes)
+        : _extension(extension), _resultTypes(resultTypes),
+          _workspaces(new ScanWorkspace[batchPool().threads()]) {}
+    
+    // items skipped by a cancel still hold their buffer
+    virtual ~ScanBatchJob()
+    {
+        for (size_t i = 0; i < items.size(); i++)
+            BufferPool::shared().release(items[i].bytes, items[i].length);
+    }
+    
+    std::vector<BatchItem> items;
+    
+    virtual void process(size_t index, unsigned worker)
+    {
+        BatchItem &item = items[index];
+        [_extension scanBatchItem:item index:(uint32_t) index resultTypes:_resultTypes workspace:_workspaces[worker]];
+        BufferPool::shared().release(item.bytes, item.length);
+        item.bytes = NULL;
+    }
+    
+    virtual void finished(size_t processed, bool cancelled)
+    {
+        [_extension batchFinished:processed cancelled:cancelled];
+    }
+    
+private:
+    UIViewExtension *_extension;
+    int _resultTypes;
+    std::unique_ptr<ScanWorkspace[]> _workspaces;
+};
+
+// Shared by all contexts like the batch pool. Two threads: a frame has at
+// most a decoding and a matching lane.
+static LaneScheduler &lanePool()
+{
+    static LaneScheduler *pool = new LaneScheduler(kCascadeStages);
+    return *pool;
+}
+
+// The cascade stages of one scan queue plane, run at the same time on the
+// lane pool. Owned by the extension and only refilled once the lanes of the
+// previous plane settled.
+class FrameLanes : public LaneJob {
+public:
+    explicit FrameLanes(UIViewExtension *extension)
+        : pixels(NULL), width(0), height(0), resultTypes(0), level(SearchLevelDefault), _extension(extension) {}
+    
+    const uint8_t *pixels;
+    int width;
+    int height;
+    int resultTypes;
+    SearchLevel level;
+    CascadeStage stages[kCascadeStages];
+    MSResult *results[kCascadeStages];
+    
+    virtual bool runLane(int lane, const std::atomic<bool> &cancelled)
+    {
+        results[lane] = [_extension recognizeStage:stages[lane]
+                                              gray:pixels
+                                             width:width
+                                            height:height
+                                       resultTypes:resultTypes
+                                             level:level
+                                         workspace:_workspaces[lane]
+                                         cancelled:&cancelled];
+        return results[lane] != nil;
+    }
+    
+    void clear()
+    {
+        for (int i = 0; i < kCascadeStages; i++)
+            results[i] = nil;
+        pixels = NULL;
+    }
+    
+private:
+    __unsafe_unretained UIViewExtension *_extension;   // owns us
+    ScanWorkspace _workspaces[kCascadeStages];          // one query plane per lane
+};
+
+@implementation UIViewExtension
+@synthesize camView;
+@synthesize dbName;
+
+static const uint8_t *kResultsAvailable = (const uint8_t *) "resultsAvailable";
+static const uint8_t *kBatchComplete = (const uint8_t *) "batchComplete";
+static const uint8_t *kBatchCancelled = (const uint8_t *) "batchCancelled";
+static const uint8_t *kJobsCompleted = (const uint8_t *) "jobsCompleted";
+static const uint8_t *kCameraReady = (const uint8_t *) "cameraReady";
+static const uint8_t *kSyncStatus = (const uint8_t *) "syncStatus";
+
+// what the camera UI scans for, headless calls may ask for other types
+static const int kDefaultResultTypes = MSResultTypeImage | MSResultTypeQRCode | MSResultTypeEAN13;
+
+-(id)initWithContext:(FREContext)ctx
+{
+    self = [super init];
+    if (self)
+    {
+        _context = ctx;
+        _scanQueue = dispatch_queue_create("com.webspiders.MoodstocksScanner.scan", DISPATCH_QUEUE_SERIAL);
+        self.dbName = @"scanner.db";
+        
+        // an idle scanner stays open in the foreground, these are the only
+        // times it gets closed before dispose
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(memoryWarning:) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didEnterBackground:) name:UIApplicationDidEnterBackgroundNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(willEnterForeground:) name:UIApplicationWillEnterForegroundNotification object:nil];
+        
+        _scanners = [[NSMutableDictionary alloc] init];
+        _syncObservers = [[NSMutableDictionary alloc] init];
+        _apiSearchQueue = [[NSOperationQueue alloc] init];
+        _sceneResults = [[NSMutableArray alloc] init];
+        for (int i = 0; i < SceneCache::kCapacity; i++)
+            [_sceneResults addObject:[NSNull null]];
+        _syncJobs = [[NSMutableArray alloc] init];
+        _syncBackgroundTask = UIBackgroundTaskInvalid;
+        _frameLanes.reset(new FrameLanes(self));
+        _parallelLanes = [[NSProcessInfo processInfo] activeProcessorCount] > 1;
+        [self startReachability];
+    }
+    return self;
+}
+
+-(void)dispose
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    if (_scannerUIViewController.view.superview != nil)
+        [_scannerUIViewController dismissViewControllerAnimated:NO completion:nil];
+    
+    [self stopGovernor];
+    [self stopReachability];
+    [self endSyncBackgroundTask];
+    _syncTimerGeneration++;
+    MSScanner *scanner = nil;
+    [self openState:&scanner key:NULL secret:NULL];
+    [scanner cancelApiSearches];
+    [_apiSearchQueue cancelAllOperations];
+    [[self syncingScanner] cancelSync];
+    // the close runs on the scan queue and still needs _scanner
+    [self closeScannerThen:nil];
+    _scannerUIViewController = nil;
+    _context = NULL;
+}
+
+// Packs a scan result into the result ring and wakes ActionScript up if it
+// is not already due to drain it
+-(void)pushResult:(MSResult *)result source:(ResultSource)source tag:(uint32_t)tag timestamp:(double)timestamp
+{
+    RoiRect frame = { 0, 0, 1, 1 };
+    [self pushResult:result source:source tag:tag timestamp:timestamp region:frame];
+}
+
+// Corners of a result found in `region` of the frame are reported in the
+// frame's [-1, 1] range all the same
+-(void)pushResult:(MSResult *)result source:(ResultSource)source tag:(uint32_t)tag timestamp:(double)timestamp region:(const RoiRect &)region
+{
+    // a nil result is packed as a type 0 record with no id
+    NSData *data = [result data];
+
+    ResultHeader header;
+    header.type = (uint32_t) [result type];
+    header.origin = (uint8_t) [result origin];
+    header.source = (uint8_t) source;
+    header.flags = 0;
+    header.reserved = 0;
+    header.tag = tag;
+    header.idLength = (uint32_t) [data length];
+    header.timestamp = timestamp;
+
+    float corners[8];
+    const float *cornersPtr = NULL;
+    if ([result corners] != nil)
+    {
+        CGPoint points[4];
+        [[result corners] getValue:&points];
+        for (int i = 0; i < 4; i++)
+        {
+            corners[i * 2] = (float) points[i].x;
+            corners[i * 2 + 1] = (float) points[i].y;
+        }
+        mapToFrame(region, corners, 4);
+        header.flags |= ResultFlagCorners;
+        cornersPtr = corners;
+    }
+
+    if (_results.push(header, cornersPtr, (const uint8_t *) [data bytes]) && _context != NULL)
+        FREDispatchStatusEventAsync(_context, kResultsAvailable, (const uint8_t *) "");
+}
+
+// Tells ActionScript the frame with this tag was dropped or left undecided,
+// not missed; `flags` says why
+-(void)pushDroppedFrame:(uint32_t)tag source:(ResultSource)source flags:(uint8_t)flags timestamp:(double)timestamp
+{
+    ResultHeader header;
+    memset(&header, 0, sizeof(header));
+    header.source = (uint8_t) source;
+    header.flags = flags;
+    header.tag = tag;
+    header.timestamp = timestamp;
+    
+    if (_results.push(header, NULL, NULL) && _context != NULL)
+        FREDispatchStatusEventAsync(_context, kResultsAvailable, (const uint8_t *) "");
+}
+
+-(size_t)drainResults:(uint8_t *)bytes length:(size_t)length hasMore:(bool *)hasMore
+{
+    return _results.drain(bytes, length, hasMore);
+}
+
+-(size_t)pendingResultBytes
+{
+    return _results.pendingBytes();
+}
+
+// Records the outcome of a job and wakes ActionScript up if it is not
+// already due to drain completions. Any thread.
+-(void)finishJob:(uint32_t)job error:(NSError *)error succeeded:(BOOL)succeeded
+{
+    int32_t code = succeeded ? 0 : (error != nil ? (int32_t) [error code] : -1);
+    if (_jobs.finish(job, code) && _context != NULL)
+        FREDispatchStatusEventAsync(_context, kJobsCompleted, (const uint8_t *) "");
+}
+
+-(size_t)drainJobs:(JobCompletion *)completions count:(size_t)count hasMore:(bool *)hasMore
+{
+    return _jobs.drain(completions, count, hasMore);
+}
+
+-(size_t)completedJobCount
+{
+    return _jobs.completedCount();
+}
+
+
+// Makes the scanner of `apikey` the one in use and hands over to the sync
+// scheduler. Every API key has its own database and the scanners of recent
+// keys stay open in the pool, so switching back to one of them is a pointer
+// swap. The camera UI and the headless scan calls share the scanner in use.
+// Opening reads the local database, so this runs on _scanQueue only.
+-(BOOL)openWithKey:(NSString *)apikey secret:(NSString *)apisecret error:(NSError **)error
+{
+    if (_isOpen && [apikey isEqualToString:_apiKey])
+        return YES;
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    BOOL switching = _isOpen;
+    
+    // batch workers scan with the scanner in use
+    if (!_batch.expired())
+        batchPool().wait();
+    
+    MSScanner *scanner = [_scanners objectForKey:apikey];
+    BOOL pooled = _pool.touch([apikey UTF8String]);
+    if (!pooled)
+    {
+        [self adoptLegacyDatabaseForKey:apikey];
+        scanner = [[MSScanner alloc] init];
+        NSError *proxyError = nil;
+        if (_proxyHost != nil && ![scanner setProxySettings:_proxyHost port:_proxyPort error:&proxyError])
+            MSDLog(@" [MOODSTOCKS SDK] PROXY ERROR: %@", [proxyError ms_message]);
+        if (![scanner openWithPath:[self databasePathForKey:apikey]
+                               key:apikey
+                            secret:apisecret
+                             error:error]) {
+            
+            MSDLog(@" [MOODSTOCKS SDK] SCANNER OPEN ERROR: %@", [*error ms_message]);
+            return NO;
+        }
+        __weak UIViewExtension *weakSelf = self;
+        id observer = [[NSNotificationCenter defaultCenter] addObserverForName:MSScannerSyncChangeNotification object:scanner queue:nil usingBlock:^(NSNotification *notification) {
+            [weakSelf syncChanged:notification key:apikey];
+        }];
+        [_syncObservers setObject:observer forKey:apikey];
+        [_scanners setObject:scanner forKey:apikey];
+        _pool.insert([apikey UTF8String], [self databaseBytesForKey:apikey]);
+    }
+    
+    MSDLog(@"[MOODSTOCKS] OPEN SCANNER SUCCEED");
+    Timeline::coldStart().mark("open");
+    {
+        std::lock_guard<std::mutex> guard(_openLock);
+        _scanner = scanner;
+        _isOpen = YES;
+        _apiKey = apikey;
+        _apiSecret = apisecret;
+    }
+    _sceneCache.clear();
+    [self evictScanners];
+    
+    if (switching)
+    {
+        _lastSwitchDuration = CFAbsoluteTimeGetCurrent() - start;
+        _lastSwitchPooled = pooled;
+        MSDLog(@"[MOODSTOCKS] SWITCHED CATALOG IN %.1f ms (%@)", _lastSwitchDuration * 1000, pooled ? @"pooled" : @"opened");
+    }
+    
+    // the sync scheduler decides whether this open calls for a sync
+    dispatch_async(dispatch_get_main_queue(), ^{
+        _syncRestored = NO;
+        [self scheduleSync];
+    });
+    return YES;
+}
+
+// `scanner.db` becomes `scanner-<key>.db`. Any thread.
+-(NSString *)databasePathForKey:(NSString *)apikey
+{
+    NSCharacterSet *unsafe = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+    NSString *safeKey = [[apikey componentsSeparatedByCharactersInSet:unsafe] componentsJoinedByString:@"_"];
+    NSString *name = [NSString stringWithFormat:@"%@-%@.%@", [self.dbName stringByDeletingPathExtension], safeKey, [self.dbName pathExtension]];
+    return [MSScanner cachesPathFor:name];
+}
+
+// Installs from before per-key databases have a single scanner.db in the
+// default context. The first key opened takes it over instead of syncing
+// from scratch. _scanQueue only.
+-(void)adoptLegacyDatabaseForKey:(NSString *)apikey
+{
+    NSFileManager *manager = [NSFileManager defaultManager];
+    NSString *legacyPath = [MSScanner cachesPathFor:self.dbName];
+    NSString *path = [self databasePathForKey:apikey];
+    if (![self.dbName isEqualToString:@"scanner.db"] || ![manager fileExistsAtPath:legacyPath] || [manager fileExistsAtPath:path])
+        return;
+    
+    NSError *error = nil;
+    if ([manager moveItemAtPath:legacyPath toPath:path error:&error])
+        MSDLog(@"[MOODSTOCKS] MOVED %@ TO %@", self.dbName, [path lastPathComponent]);
+    else
+        MSDLog(@"[MOODSTOCKS] COULD NOT MOVE %@: %@", self.dbName, error);
+}
+
+// Size of a local database, which is what its scanner costs in the pool and
+// whose growth tells how much a sync downloaded. Any thread.
+-(unsigned long long)databaseBytesForKey:(NSString *)apikey
+{
+    if (apikey == nil)
+        return 0;
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:[self databasePathForKey:apikey] error:nil] fileSize];
+}
+
+// Closes the pooled scanners the limits leave no room for. A syncing
+// scanner stays until its sync is over, the camera's until it is dismissed.
+// _scanQueue only.
+-(void)evictScanners
+{
+    for (NSString *key in _scanners)
+    {
+        MSScanner *scanner = [_scanners objectForKey:key];
+        _pool.setBusy([key UTF8String], [scanner isSyncing] || scanner == _cameraScanner);
+    }
+    
+    std::vector<std::string> evicted;
+    _pool.evict(&evicted);
+    for (size_t i = 0; i < evicted.size(); i++)
+        [self closePooledScanner:[NSString stringWithUTF8String:evicted[i].c_str()]];
+}
+
+-(void)closePooledScanner:(NSString *)apikey
+{
+    MSScanner *scanner = [_scanners objectForKey:apikey];
+    MSDLog(@"[MOODSTOCKS] CLOSING POOLED SCANNER %@", apikey);
+    
+    [[NSNotificationCenter defaultCenter] removeObserver:[_syncObservers objectForKey:apikey]];
+    [_syncObservers removeObjectForKey:apikey];
+    [scanner close:nil];
+    [_scanners removeObjectForKey:apikey];
+    _pool.remove([apikey UTF8String]);
+    
+    if (scanner == _scanner)
+    {
+        std::lock_guard<std::mutex> guard(_openLock);
+        _isOpen = NO;
+    }
+}
+
+// The scanner in use and the credentials it was opened with, which are
+// kept once it is closed. Returns whether it is open. Any thread; on
+// _scanQueue the ivars can be read directly.
+-(BOOL)openState:(MSScanner **)scanner key:(NSString **)apikey secret:(NSString **)apisecret
+{
+    std::lock_guard<std::mutex> guard(_openLock);
+    if (scanner != NULL)
+        *scanner = _isOpen ? _scanner : nil;
+    if (apikey != NULL)
+        *apikey = _apiKey;
+    if (apisecret != NULL)
+        *apisecret = _apiSecret;
+    return _isOpen;
+}
+
+-(void)setPoolLimits:(size_t)maxScanners bytes:(uint64_t)maxBytes
+{
+    dispatch_async(_scanQueue, ^{
+        _pool.setLimits(maxScanners, maxBytes);
+        [self evictScanners];
+    });
+}
+
+-(ScannerPoolStats)poolStats:(double *)lastSwitch pooled:(BOOL *)pooled
+{
+    // never waits for the scan queue, which may be busy with a search
+    *lastSwitch = _lastSwitchDuration;
+    *pooled = _lastSwitchPooled;
+    return _pool.stats();
+}
+
+// Blocking variant for callers that need the scanner right away
+-(BOOL)openWithKey:(NSString *)apikey secret:(NSString *)apisecret
+{
+    __block BOOL opened = NO;
+    dispatch_sync(_scanQueue, ^{
+        NSError *error = nil;
+        opened = [self acquireScanner:&_headlessUser key:apikey secret:apisecret error:&error];
+    });
+    return opened;
+}
+
+// The scanner is reference counted by its users: the camera UI and the
+// headless calls each hold one reference while they need it. Dropping the
+// last one keeps the scanner open, so the next presentation skips the
+// database open; it is only closed when idle on memory pressure or in the
+// background, and on dispose. Both run on _scanQueue only.
+-(BOOL)acquireScanner:(BOOL *)user key:(NSString *)apikey secret:(NSString *)apisecret error:(NSError **)error
+{
+    // a user holding the scanner may still switch it to another key
+    if (![self openWithKey:apikey secret:apisecret error:error])
+        return NO;
+    if (*user)
+        return YES;
+    
+    *user = YES;
+    _scannerUsers++;
+    if (user == &_cameraUser)
+        _cameraScanner = _scanner;
+    return YES;
+}
+
+-(void)releaseScanner:(BOOL *)user
+{
+    if (!*user)
+        return;
+    *user = NO;
+    _scannerUsers--;
+    if (user == &_cameraUser)
+        _cameraScanner = nil;
+}
+
+// Closes the pooled scanners of other keys, and the one in use if nobody
+// uses it, behind any scan still queued. A running sync counts as a user.
+-(void)closeIfIdle
+{
+    bool batchRunning = !_batch.expired();
+    dispatch_async(_scanQueue, ^{
+        BOOL inUse = _scannerUsers > 0 || batchRunning;
+        for (NSString *key in [_scanners allKeys])
+        {
+            MSScanner *scanner = [_scanners objectForKey:key];
+            if ([scanner isSyncing] || scanner == _cameraScanner || (scanner == _scanner && inUse))
+                continue;
+            [self closePooledScanner:key];
+        }
+    });
+}
+
+-(void)memoryWarning:(NSNotification *)notification
+{
+    BufferPool::shared().trim();
+    [self closeIfIdle];
+}
+
+// A running sync gets whatever background time iOS grants; if that runs
+// out it is cancelled cleanly and resumed first thing in the foreground
+-(void)didEnterBackground:(NSNotification *)notification
+{
+    _syncScheduler.setSuspended(true);
+    
+    if (_syncScheduler.running() && _syncBackgroundTask == UIBackgroundTaskInvalid)
+    {
+        // the scanner syncing may no longer be the one in use
+        _syncBackgroundTask = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
+            _syncInterrupted = YES;
+            _syncResumePending = YES;
+            [[self syncingScanner] cancelSync];
+            [self endSyncBackgroundTask];
+        }];
+    }
+    [self closeIfIdle];
+}
+
+-(void)willEnterForeground:(NSNotification *)notification
+{
+    _syncScheduler.setSuspended(false);
+    
+    // an interrupted sync does not wait for the next scan to reopen us;
+    // syncFinished: may have closed the scanner while we were suspended
+    NSString *apikey = nil;
+    NSString *apisecret = nil;
+    [self openState:NULL key:&apikey secret:&apisecret];
+    if (_syncResumePending && apikey != nil)
+    {
+        _syncResumePending = NO;
+        dispatch_async(_scanQueue, ^{
+            NSError *error = nil;
+            if (![self openWithKey:apikey secret:apisecret error:&error])
+                return;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self scheduleSync];
+            });
+        });
+    }
+    [self scheduleSync];
+}
+
+-(void)endSyncBackgroundTask
+{
+    if (_syncBackgroundTask == UIBackgroundTaskInvalid)
+        return;
+    [[UIApplication sharedApplication] endBackgroundTask:_syncBackgroundTask];
+    _syncBackgroundTask = UIBackgroundTaskInvalid;
+}
+
+// Does the work of the first runScanner ahead of time: finds the resource
+// bundle at low priority, opens the scanner (which starts the first sync)
+// on the scan queue and loads the camera view without starting the
+// capture. The open scanner is kept like after a dismissed camera.
+-(uint32_t)prewarmWithKey:(NSString *)apikey secret:(NSString *)apisecret
+{
+    Timeline::coldStart().mark("prewarm");
+    
+    uint32_t job = _jobs.begin(JobOperationPrewarm);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+        NSBundle *bundle = [self scannerBundle];
+        Timeline::coldStart().mark("bundle");
+        
+        dispatch_async(_scanQueue, ^{
+            NSError *error = nil;
+            BOOL opened = [self openWithKey:apikey secret:apisecret error:&error];
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (opened)
+                {
+                    [self loadCamController:bundle];
+                    [_scannerUIViewController view];
+                    Timeline::coldStart().mark("view");
+                }
+                [self finishJob:job error:error succeeded:opened];
+            });
+        });
+    });
+    return job;
+}
+
+// Opens on the scan queue and reports through the job table
+-(uint32_t)openAsyncWithKey:(NSString *)apikey secret:(NSString *)apisecret
+{
+    uint32_t job = _jobs.begin(JobOperationOpen);
+    dispatch_async(_scanQueue, ^{
+        NSError *error = nil;
+        BOOL opened = [self acquireScanner:&_headlessUser key:apikey secret:apisecret error:&error];
+        [self finishJob:job error:error succeeded:opened];
+    });
+    return job;
+}
+
+// Closes behind any scan still running on the scan queue or the batch
+// pool, then calls `completion` on the scan queue
+-(void)closeScannerThen:(void (^)(void))completion
+{
+    bool batchRunning = !_batch.expired();
+    if (batchRunning)
+        batchPool().cancel();
+    
+    dispatch_async(_scanQueue, ^{
+        if (batchRunning)
+            batchPool().wait();
+        for (NSString *key in [_scanners allKeys])
+            [self closePooledScanner:key];
+        if (completion)
+            completion();
+    });
+}
+
+// Drops the headless reference and closes unless the camera UI is still
+// using the scanner
+-(uint32_t)closeAsync
+{
+    uint32_t job = _jobs.begin(JobOperationClose);
+    dispatch_async(_scanQueue, ^{
+        [self releaseScanner:&_headlessUser];
+    });
+    [self closeIfIdle];
+    dispatch_async(_scanQueue, ^{
+        [self finishJob:job error:nil succeeded:YES];
+    });
+    return job;
+}
+
+// Syncs as soon as the network policy allows, ignoring the interval; the
+// job completes with the next sync
+-(uint32_t)syncAsync
+{
+    uint32_t job = _jobs.begin(JobOperationSync);
+    if (![self openState:NULL key:NULL secret:NULL])
+    {
+        [self finishJob:job error:nil succeeded:NO];
+        return job;
+    }
+    
+    [_syncJobs addObject:[NSNumber numberWithUnsignedInt:job]];
+    _syncScheduler.request();
+    [self scheduleSync];
+    return job;
+}
+
+// Bootstraps the open scanner from a bundle of prebuilt signatures, on the
+// scan queue behind the open. `path` is relative to the app bundle unless
+// absolute.
+-(uint32_t)importAsyncFromBundle:(NSString *)path
+{
+    uint32_t job = _jobs.begin(JobOperationImport);
+    dispatch_async(_scanQueue, ^{
+        if (!_isOpen)
+        {
+            [self finishJob:job error:nil succeeded:NO];
+            return;
+        }
+        
+        NSString *bundlePath = [path isAbsolutePath] ? path : [[[NSBundle mainBundle] bundlePath] stringByAppendingPathComponent:path];
+        NSBundle *bundle = [NSBundle bundleWithPath:bundlePath];
+        NSError *error = nil;
+        BOOL imported = bundle != nil && [_scanner importBundle:bundle error:&error];
+        if (!imported)
+            MSDLog(@" [MOODSTOCKS SDK] IMPORT ERROR: %@", bundle != nil ? [error ms_message] : bundlePath);
+        else
+        {
+            // cached misses may match the new signatures
+            _sceneCache.clear();
+            _pool.setBytes([_apiKey UTF8String], [self databaseBytesForKey:_apiKey]);
+        }
+        [self finishJob:job error:error succeeded:imported];
+    });
+    return job;
+}
+
+-(void)setSyncPolicy:(const SyncPolicy &)policy
+{
+    _syncScheduler.setPolicy(policy);
+    [self scheduleSync];
+}
+
+//
+//  Sync scheduling, main thread
+//
+
+-(NSString *)lastSyncKeyForKey:(NSString *)apikey
+{
+    return [NSString stringWithFormat:@"MoodstocksScanner.lastSync.%@", [[self databasePathForKey:apikey] lastPathComponent]];
+}
+
+-(void)startReachability
+{
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    
+    _reachability = SCNetworkReachabilityCreateWithAddress(kCFAllocatorDefault, (const struct sockaddr *) &address);
+    if (_reachability == NULL)
+        return;
+    
+    SCNetworkReachabilityContext context = { 0, (__bridge void *) self, NULL, NULL, NULL };
+    SCNetworkReachabilitySetCallback(_reachability, reachabilityCallback, &context);
+    SCNetworkReachabilityScheduleWithRunLoop(_reachability, CFRunLoopGetMain(), kCFRunLoopCommonModes);
+    
+    SCNetworkReachabilityFlags flags;
+    if (SCNetworkReachabilityGetFlags(_reachability, &flags))
+        [self reachabilityFlagsChanged:flags];
+}
+
+-(void)stopReachability
+{
+    if (_reachability == NULL)
+        return;
+    
+    SCNetworkReachabilitySetCallback(_reachability, NULL, NULL);
+    SCNetworkReachabilityUnscheduleFromRunLoop(_reachability, CFRunLoopGetMain(), kCFRunLoopCommonModes);
+    CFRelease(_reachability);
+    _reachability = NULL;
+}
+
+-(void)reachabilityFlagsChanged:(SCNetworkReachabilityFlags)flags
+{
+    bool reachable = (flags & kSCNetworkReachabilityFlagsReachable) && !(flags & kSCNetworkReachabilityFlagsConnectionRequired);
+    bool unmetered = !(flags & kSCNetworkReachabilityFlagsIsWWAN);
+    _syncScheduler.setNetwork(reachable, unmetered);
+    _fallback.setNetwork(reachable);
+    [self scheduleSync];
+}
+
+// Starts a sync if the policy allows one now, else wakes up again once the
+// interval or backoff is over. Network and idle changes call this too.
+-(void)scheduleSync
+{
+    NSString *apikey = nil;
+    if (![self openState:NULL key:&apikey secret:NULL] || _context == NULL)
+        return;
+    
+    // every catalog keeps its own sync time
+    if (!_syncRestored)
+    {
+        _syncScheduler.setLastSuccess([[NSUserDefaults standardUserDefaults] doubleForKey:[self lastSyncKeyForKey:apikey]]);
+        _syncRestored = YES;
+    }
+    
+    bool cameraShown = [_scannerUIViewController isViewLoaded] && _scannerUIViewController.view.window != nil;
+    bool busy = cameraShown || !_batch.expired();
+    _syncScheduler.setBusy(busy);
+    
+    double now = CFAbsoluteTimeGetCurrent();
+    if (_syncScheduler.shouldStart(now))
+    {
+        [self startSync];
+        return;
+    }
+    
+    double next = _syncScheduler.nextAllowed();
+    if (_syncScheduler.running() || next <= now)
+        return;
+    
+    NSUInteger generation = ++_syncTimerGeneration;
+    __weak UIViewExtension *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) ((next - now) * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        UIViewExtension *strongSelf = weakSelf;
+        if (strongSelf != nil && strongSelf->_syncTimerGeneration == generation)
+            [strongSelf scheduleSync];
+    });
+}
+
+-(void)startSync
+{
+    _syncScheduler.started(CFAbsoluteTimeGetCurrent());
+    MSDLog(@"[MOODSTOCKS] SYNC STARTED");
+    
+    dispatch_async(_scanQueue, ^{
+        if (!_isOpen)
+        {
+            // closed before the sync got going: fail its jobs and retry
+            // once a scanner is open again
+            dispatch_async(dispatch_get_main_queue(), ^{
+                _syncScheduler.finished(CFAbsoluteTimeGetCurrent(), SyncCancelled);
+                _syncScheduler.request();
+                for (NSNumber *job in _syncJobs)
+                    [self finishJob:[job unsignedIntValue] error:nil succeeded:NO];
+                [_syncJobs removeAllObjects];
+            });
+            return;
+        }
+        
+        // the sync outlives a switch to another catalog, so it keeps its
+        // own scanner, key and database size to start from
+        MSScanner *scanner = _scanner;
+        NSString *key = _apiKey;
+        unsigned long long startBytes = [self databaseBytesForKey:key];
+        {
+            std::lock_guard<std::mutex> guard(_openLock);
+            _syncingScanner = scanner;
+        }
+        [scanner syncInBackgroundWithBlock:^(MSSync *op, NSError *error) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self syncFinished:error key:key startBytes:startBytes];
+            });
+        } progressBlock:nil];
+    });
+}
+
+-(MSScanner *)syncingScanner
+{
+    std::lock_guard<std::mutex> guard(_openLock);
+    return _syncingScanner;
+}
+
+// Progress arrives once per percent on any thread; ActionScript gets the
+// latest state of each catalog at most once per throttle interval
+-(void)syncChanged:(NSNotification *)notification key:(NSString *)apikey
+{
+    MSScanner *scanner = [notification object];
+    NSError *error = [scanner syncError];
+    
+    SyncStatus status;
+    status.syncing = [scanner isSyncing] != NO;
+    status.progress = (int) [scanner syncProgress];
+    status.error = error != nil ? (int) [error code] : 0;
+    
+    double delay = _syncStatus.update([apikey UTF8String], status, CFAbsoluteTimeGetCurrent());
+    if (delay == 0)
+    {
+        [self deliverSyncStatus:apikey];
+    }
+    else if (delay > 0)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (delay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            [self deliverSyncStatus:apikey];
+        });
+    }
+}
+
+// "syncing,progress,error,apiKey"
+-(void)deliverSyncStatus:(NSString *)apikey
+{
+    SyncStatus status;
+    if (!_syncStatus.flush([apikey UTF8String], CFAbsoluteTimeGetCurrent(), &status) || _context == NULL)
+        return;
+    
+    char level[32];
+    status.format(level, sizeof(level));
+    NSString *event = [NSString stringWithFormat:@"%s,%@", level, apikey];
+    FREDispatchStatusEventAsync(_context, kSyncStatus, (const uint8_t *) [event UTF8String]);
+}
+
+-(void)setSyncStatusInterval:(double)interval
+{
+    _syncStatus.setInterval(interval);
+}
+
+-(NSUInteger)syncCount { return _syncCount; }
+-(unsigned long long)lastSyncBytes { return _lastSyncBytes; }
+-(unsigned long long)totalSyncBytes { return _totalSyncBytes; }
+-(double)lastSyncDuration { return _syncScheduler.lastDuration(); }
+
+-(void)syncFinished:(NSError *)error key:(NSString *)apikey startBytes:(unsigned long long)startBytes
+{
+    {
+        std::lock_guard<std::mutex> guard(_openLock);
+        _syncingScanner = nil;
+    }
+    double now = CFAbsoluteTimeGetCurrent();
+    SyncOutcome outcome = SyncSucceeded;
+    if (error != nil)
+    {
+        NSLog(@"Sync failed with error: %@", [error ms_message]);
+        NSInteger code = [error code];
+        if (code == MSErrorAbort)
+            outcome = _syncInterrupted ? SyncInterrupted : SyncCancelled;
+        else if (code == MSErrorNoConn || code == MSErrorTimeout || code == MSErrorSlowConn)
+            outcome = SyncNetworkFailure;
+        else
+            outcome = SyncOtherFailure;
+    }
+    else
+    {
+        unsigned long long bytes = [self databaseBytesForKey:apikey];
+        _lastSyncBytes = bytes > startBytes ? bytes - startBytes : 0;
+        _totalSyncBytes += _lastSyncBytes;
+        _syncCount++;
+        NSLog(@"Sync succeeded (%llu bytes in %.1f s)", _lastSyncBytes, now - _syncScheduler.startedAt());
+        
+        Timeline::coldStart().mark("sync");
+        [[NSUserDefaults standardUserDefaults] setDouble:now forKey:[self lastSyncKeyForKey:apikey]];
+        
+        // a grown database costs more, and one held back by its sync may go now
+        dispatch_async(_scanQueue, ^{
+            _sceneCache.clear();
+            _pool.setBytes([apikey UTF8String], bytes);
+            [self evictScanners];
+        });
+    }
+    _syncScheduler.finished(now, outcome);
+    _syncInterrupted = NO;
+    
+    if (_syncScheduler.suspended())
+    {
+        // the scanner was only kept open for the sync
+        [self closeIfIdle];
+        [self endSyncBackgroundTask];
+    }
+    
+    for (NSNumber *job in _syncJobs)
+        [self finishJob:[job unsignedIntValue] error:error succeeded:(error == nil)];
+    [_syncJobs removeAllObjects];
+    
+    [self scheduleSync];
+}
+
+//Removes the camView from the main View root View Controller. The scanner
+//stays open for the next presentation; the job completes once the camera
+//has let go of it.
+-(uint32_t)hideCam
+{
+    uint32_t job = _jobs.begin(JobOperationDismiss);
+    if(_scannerUIViewController.view.superview != nil)
+    {
+        NSLog(@"Removing a Cam View");
+        [self stopGovernor];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:@"exitCam" object:_scannerUIViewController];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:@"matchFound" object:_scannerUIViewController];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:@"camReady" object:_scannerUIViewController];
+        
+        MSScanner *scanner = nil;
+        [self openState:&scanner key:NULL secret:NULL];
+        [_scannerUIViewController dismissViewControllerAnimated:TRUE completion:^
+        {
+            // a sync in flight keeps going, it now has the device to itself
+            [scanner cancelApiSearches];
+            [self scheduleSync];
+            dispatch_async(_scanQueue, ^{
+                [self releaseScanner:&_cameraUser];
+                [self finishJob:job error:nil succeeded:YES];
+            });
+        }];
+    }
+    else
+    {
+        [self finishJob:job error:nil succeeded:YES];
+    }
+    return job;
+}
+
+-(uint32_t)showCam:(NSString *)apikey apisecret:(NSString *)apisecret
+{
+    return [self showCam:apikey apisecret:apisecret mode:ScannerModeManual resultTypes:kDefaultResultTypes resultExtras:MSResultExtraNone searchOptions:MSSearchDefault];
+}
+
+// Opens the scanner on the scan queue so the database read never stalls
+// the AIR UI, then presents the camera. The job completes once presented.
+-(uint32_t)showCam:(NSString *)apikey apisecret:(NSString *)apisecret mode:(ScannerMode)mode resultTypes:(int)resultTypes resultExtras:(int)resultExtras searchOptions:(int)searchOptions
+{
+    NSLog(@"Adding a Cam View");
+    
+    uint32_t job = _jobs.begin(JobOperationPresent);
+    _presentTime = CFAbsoluteTimeGetCurrent();
+    _cameraMode = mode;
+    _cameraResultTypes = resultTypes;
+    _cameraResultExtras = resultExtras;
+    _cameraSearchOptions = searchOptions;
+    dispatch_async(_scanQueue, ^{
+        NSError *error = nil;
+        BOOL opened = [self acquireScanner:&_cameraUser key:apikey secret:apisecret error:&error];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (opened)
+                [self presentCam];
+            [self finishJob:job error:error succeeded:opened];
+        });
+    });
+    return job;
+}
+
+// Any thread
+-(NSBundle *)scannerBundle
+{
+    NSBundle * mainBundle = [NSBundle mainBundle];
+    NSString * pathToMyBundle = [mainBundle pathForResource:@"MoodstocksScannerBundle" ofType:@"bundle"];
+    NSAssert(pathToMyBundle, @"bundle not found", nil);
+    return [NSBundle bundleWithPath:pathToMyBundle];
+}
+
+-(void)loadCamController:(NSBundle *)bundle
+{
+    if (_scannerUIViewController != nil)
+        return;
+    
+    MSScanner *scanner = nil;
+    [self openState:&scanner key:NULL secret:NULL];
+    _scannerUIViewController = [[ScannerViewController alloc] initWithNibName:@"ScannerViewController" bundle:bundle];
+    _scannerUIViewController.scanner = scanner;
+    NSAssert(_scannerUIViewController, @"scanner view not found", nil);
+}
+
+-(void)presentCam
+{
+    if (_scannerUIViewController.view.superview != nil)
+        return;
+    
+    // for first time run, unless prewarm did it already
+    if (_scannerUIViewController == nil)
+        [self loadCamController:[self scannerBundle]];
+    Timeline::coldStart().mark("present");
+    
+    // only listen to our own view controller, other contexts may be scanning too
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(exitHandler:) name:@"exitCam" object:_scannerUIViewController];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(matchFound:) name:@"matchFound" object:_scannerUIViewController];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(cameraReady:) name:@"camReady" object:_scannerUIViewController];
+    
+    MSScanner *scanner = nil;
+    [self openState:&scanner key:NULL secret:NULL];
+    _scannerUIViewController.presentTime = _presentTime;
+    _scannerUIViewController.scanner = scanner;
+    _scannerUIViewController.mode = _cameraMode;
+    _scannerUIViewController.resultTypes = _cameraResultTypes;
+    _scannerUIViewController.resultExtras = _cameraResultExtras;
+    _scannerUIViewController.searchOptions = _cameraSearchOptions;
+    _scannerUIViewController.serverDeadline = _fallback.policy().deadline;
+    
+    [[[[UIApplication sharedApplication] keyWindow] rootViewController] presentViewController:_scannerUIViewController animated:YES completion:nil];
+
+
+    //[[[[[UIApplication sharedApplication] windows] objectAtIndex:0] rootViewController].view addSubview:[scannerVC view]];
+    
+    // this code adds view without blocking any UI element at flex side
+    //[[[[UIApplication sharedApplication] keyWindow] rootViewController].view addSubview:[scannerVC view]];   
+}
+
+// Resamples an upright grayscale plane to the cheapest size MSImage accepts
+// for the stage. The workspace belongs to the calling thread.
+-(MSImage *)queryForGray:(const uint8_t *)pixels width:(int)width height:(int)height target:(ScanTarget)target workspace:(ScanWorkspace &)workspace error:(NSError **)error
+{
+    int queryWidth, queryHeight;
+    querySizeFor(width, height, target, &queryWidth, &queryHeight);
+    
+    if (queryWidth != width || queryHeight != height)
+    {
+        std::vector<uint8_t> &plane = workspace.queryPlane;
+        if (plane.size() < (size_t) queryWidth * queryHeight)
+            plane.resize((size_t) queryWidth * queryHeight);
+        
+        GrayView src = { const_cast<uint8_t *>(pixels), width, height, width };
+        GrayView dst = { &plane[0], queryWidth, queryHeight, queryWidth };
+        workspace.resampler.resample(src, dst);
+        
+        pixels = dst.pixels;
+        width = queryWidth;
+        height = queryHeight;
+    }
+    
+    // the SDK treats landscape right as the unrotated orientation
+    return [MSImage imageWithGrayscalePixels:pixels
+                                       width:width
+                                      height:height
+                                      stride:width
+                                 orientation:AVCaptureVideoOrientationLandscapeRight
+                                       error:error];
+}
+
+// Runs one cascade stage on an upright grayscale plane. Each stage gets a
+// query of its own size: image matching never pays for barcode resolution.
+// Once `cancelled` is set another stage has matched, and the SDK is not
+// called at all.
+-(MSResult *)recognizeStage:(CascadeStage)stage gray:(const uint8_t *)pixels width:(int)width height:(int)height resultTypes:(int)resultTypes level:(SearchLevel)level workspace:(ScanWorkspace &)workspace cancelled:(const std::atomic<bool> *)cancelled
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSError *error = nil;
+    MSImage *query = nil;
+    if (cancelled == NULL || !cancelled->load())
+    {
+        query = [self queryForGray:pixels
+                             width:width
+                            height:height
+                            target:(stage == CascadeStageDecode ? ScanTargetBarcode : ScanTargetImage)
+                         workspace:workspace
+                             error:&error];
+        if (query == nil)
+        {
+            MSDLog(@" [MOODSTOCKS SDK] IMAGE ERROR: %@", [error ms_message]);
+            return nil;
+        }
+    }
+    if (cancelled != NULL && cancelled->load())
+    {
+        _cascade.skip(stage);
+        return nil;
+    }
+    
+    MSResult *result;
+    if (stage == CascadeStageDecode)
+        result = [_scanner decodeWithQuery:query formats:(resultTypes & kMSResultAllBarcodes) extras:MSResultExtraCorners error:nil];
+    else
+    {
+        int options = level == SearchLevelSmallTarget ? MSSearchSmallTarget : MSSearchDefault;
+        if (_escalation.policy().noPartial)
+            options |= MSSearchNoPartial;
+        CFAbsoluteTime searchStart = CFAbsoluteTimeGetCurrent();
+        result = [_scanner searchWithQuery:query options:options extras:MSResultExtraCorners error:nil];
+        _escalation.record(level, CFAbsoluteTimeGetCurrent() - searchStart, result != nil);
+    }
+    _cascade.record(stage, CFAbsoluteTimeGetCurrent() - start, result != nil);
+    return result;
+}
+
+// Runs barcode decoding and image matching on an upright grayscale plane,
+// in the cascade order, until one of them matches
+-(MSResult *)recognizeGray:(const uint8_t *)pixels width:(int)width height:(int)height resultTypes:(int)resultTypes level:(SearchLevel)level workspace:(ScanWorkspace &)workspace
+{
+    CascadeStage stages[kCascadeStages];
+    int count = _cascade.stages((resultTypes & kMSResultAllBarcodes) != 0, (resultTypes & MSResultTypeImage) != 0, stages);
+    
+    MSResult *result = nil;
+    for (int i = 0; i < count; i++)
+    {
+        if (result != nil)
+            _cascade.skip(stages[i]);
+        else
+            result = [self recognizeStage:stages[i] gray:pixels width:width height:height resultTypes:resultTypes level:level workspace:workspace cancelled:NULL];
+    }
+    return result;
+}
+
+// Same on the scan queue, with both stages at once on the lane pool: a
+// frame costs its slower stage instead of both, and a match returns while
+// the other stage is still busy. A match of the stage first in the cascade
+// order wins a tie. The plane is read until settleLanes. _scanQueue only.
+-(MSResult *)recognizeGrayInLanes:(const uint8_t *)pixels width:(int)width height:(int)height resultTypes:(int)resultTypes level:(SearchLevel)level
+{
+    FrameLanes &job = *_frameLanes;
+    int count = _cascade.stages((resultTypes & kMSResultAllBarcodes) != 0, (resultTypes & MSResultTypeImage) != 0, job.stages);
+    if (count < 2 || !_parallelLanes)
+        return [self recognizeGray:pixels width:width height:height resultTypes:resultTypes level:level workspace:_workspace];
+    
+    job.pixels = pixels;
+    job.width = width;
+    job.height = height;
+    job.resultTypes = resultTypes;
+    job.level = level;
+    int winner = lanePool().run(&job, count);
+    return winner >= 0 ? job.results[winner] : nil;
+}
+
+// Waits for a stage of this plane that lost to finish and returns the CPU
+// seconds the lanes spent on the plane, _scanQueue only
+-(double)settleLanes
+{
+    double cpu = lanePool().settle(_frameLanes.get());
+    _frameLanes->clear();
+    return cpu;
+}
+
+-(void)setParallelLanes:(BOOL)enabled
+{
+    dispatch_async(_scanQueue, ^{
+        _parallelLanes = enabled;
+    });
+}
+
+-(LaneStats)laneStats
+{
+    return lanePool().stats();
+}
+
+-(void)setCascadeOrder:(CascadeOrder)order
+{
+    _cascade.setOrder(order);
+}
+
+-(StageStats)cascadeStats:(CascadeStage)stage
+{
+    return _cascade.stats(stage);
+}
+
+-(void)resetCascadeStats
+{
+    _cascade.reset();
+}
+
+// Frames fed in a loop mostly repeat the previous scene, those reuse the
+// outcome of its search; of the others, blurred or moving ones are not
+// searched at all and `blurred` is set. The gate sees every frame, cached
+// or not, so its motion and peak sharpness history stay current. A scene
+// that keeps missing is searched for small targets once in a while; full
+// frame fallbacks of the region of interest are not part of its scene.
+// `searched` is set for a fresh search, not a cached outcome. _scanQueue
+// only.
+-(MSResult *)recognizeFrame:(const uint8_t *)gray width:(int)width height:(int)height resultTypes:(int)resultTypes fallback:(BOOL)fallback blurred:(BOOL *)blurred searched:(BOOL *)searched
+{
+    *blurred = NO;
+    *searched = NO;
+    GrayView plane = { const_cast<uint8_t *>(gray), width, height, width };
+    SceneHash hash = sceneHash(plane);
+    double now = CFAbsoluteTimeGetCurrent();
+    
+    BOOL escalate = (resultTypes & MSResultTypeImage) && !fallback;
+    SearchLevel level = SearchLevelDefault;
+    if (escalate)
+        level = _escalation.next(hash);
+    
+    GateVerdict verdict = _frameGate.evaluate(plane, now);
+    
+    // the cached miss of this scene is what the escalation is about
+    int slot = level == SearchLevelDefault ? _sceneCache.lookup(hash, resultTypes, now) : -1;
+    if (slot >= 0)
+    {
+        id cached = [_sceneResults objectAtIndex:slot];
+        return cached != [NSNull null] ? cached : nil;
+    }
+    
+    if (!verdict.pass)
+    {
+        *blurred = YES;
+        return nil;
+    }
+    
+    MSResult *result = [self recognizeGrayInLanes:gray width:width height:height resultTypes:resultTypes level:level];
+    *searched = YES;
+    if (escalate)
+        _escalation.outcome(level, result != nil);
+    slot = _sceneCache.insert(hash, resultTypes, now, CFAbsoluteTimeGetCurrent() - now);
+    if (slot >= 0)
+        [_sceneResults replaceObjectAtIndex:slot withObject:(result != nil ? result : [NSNull null])];
+    return result;
+}
+
+-(void)setEscalationPolicy:(const EscalationPolicy &)policy
+{
+    _escalation.setPolicy(policy);
+}
+
+-(EscalationStats)escalationStats:(BOOL)reset
+{
+    EscalationStats stats = _escalation.stats();
+    if (reset)
+        _escalation.resetStats();
+    return stats;
+}
+
+-(void)configureSceneCache:(double)ttl maxDistance:(int)maxDistance
+{
+    dispatch_async(_scanQueue, ^{
+        _sceneCache.configure(ttl, maxDistance);
+    });
+}
+
+-(void)setGatePolicy:(const GatePolicy &)policy
+{
+    dispatch_async(_scanQueue, ^{
+        _frameGate.setPolicy(policy);
+    });
+}
+
+// Both stats are atomics, read without waiting for the scan queue
+-(GateStats)gateStats
+{
+    return _frameGate.stats();
+}
+
+-(SceneCacheStats)sceneCacheStats
+{
+    return _sceneCache.stats();
+}
+
+// Sends a plane the device missed to the Moodstocks API. Returns NO if the
+// miss is to be reported right away: no fallback, no network, or a request
+// already in flight. Otherwise the server's answer is pushed later, or a
+// ResultFlagTimeout record once the deadline passes, whichever comes first.
+// _scanQueue only.
+-(BOOL)searchServer:(const uint8_t *)gray width:(int)width height:(int)height source:(ResultSource)source tag:(uint32_t)tag timestamp:(double)timestamp region:(RoiRect)region
+{
+    uint32_t request = _fallback.begin(CFAbsoluteTimeGetCurrent());
+    if (request == 0)
+        return NO;
+    
+    // the search outlives the plane, so its query gets pixels of its own
+    int queryWidth, queryHeight;
+    querySizeFor(width, height, ScanTargetImage, &queryWidth, &queryHeight);
+    NSMutableData *pixels = [NSMutableData dataWithLength:(NSUInteger) queryWidth * queryHeight];
+    GrayView src = { const_cast<uint8_t *>(gray), width, height, width };
+    GrayView dst = { (uint8_t *) [pixels mutableBytes], queryWidth, queryHeight, queryWidth };
+    if (queryWidth != width || queryHeight != height)
+        _workspace.resampler.resample(src, dst);
+    else
+        memcpy(dst.pixels, gray, (size_t) width * height);
+    
+    // a weak uplink spends most of the search sending the query. It goes
+    // through a grayscale JPEG unless the quality is 0: MSImage only takes
+    // pixels, so the SDK still encodes the upload itself, but from pixels
+    // with the sensor noise smoothed out
+    NSError *error = nil;
+    MSImage *query = nil;
+    float quality = _fallback.policy().quality;
+    NSData *jpeg = quality > 0 ? [self jpegForGray:(const uint8_t *) [pixels bytes] width:queryWidth height:queryHeight quality:quality] : nil;
+    if (jpeg != nil)
+    {
+        _fallback.prepared(request, [jpeg length]);
+        query = [MSImage imageWithUIImage:[UIImage imageWithData:jpeg] error:&error];
+    }
+    else
+    {
+        query = [MSImage imageWithGrayscalePixels:(const unsigned char *) [pixels bytes]
+                                            width:queryWidth
+                                           height:queryHeight
+                                           stride:queryWidth
+                                      orientation:AVCaptureVideoOrientationLandscapeRight
+                                            error:&error];
+    }
+    if (query == nil)
+    {
+        MSDLog(@" [MOODSTOCKS SDK] IMAGE ERROR: %@", [error ms_message]);
+        _fallback.abandon(request);
+        return NO;
+    }
+    
+    // an operation of our own rather than apiSearchInBackgroundWithQuery:,
+    // so the deadline cancels this search and nothing else on the scanner
+    MSApiSearch *search = [[MSApiSearch alloc] initWithScanner:_scanner query:query];
+    [search setCompletedBlock:^(id operation, NSError *searchError) {
+        (void) pixels; // the query pixels live until the search is over
+        MSResult *result = [(MSApiSearch *) operation result];
+        if (!_fallback.finish(request, CFAbsoluteTimeGetCurrent(), result != nil, searchError != nil))
+            return;
+        if (searchError != nil)
+            MSDLog(@" [MOODSTOCKS SDK] API SEARCH ERROR: %@", [searchError ms_message]);
+        [self pushResult:(searchError == nil ? result : nil) source:source tag:tag timestamp:timestamp region:region];
+    }];
+    [_apiSearchQueue addOperation:search];
+    
+    double deadline = _fallback.policy().deadline;
+    if (deadline > 0)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (deadline * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            if (!_fallback.expire(request))
+                return;
+            // its completion block still runs, finish() drops the answer
+            [search cancel];
+            [self pushDroppedFrame:tag source:source flags:ResultFlagTimeout timestamp:timestamp];
+        });
+    }
+    return YES;
+}
+
+// Upright grayscale plane encoded as a single channel JPEG, nil if ImageIO
+// fails. `quality` is ImageIO's lossy compression quality, 0 to 1.
+-(NSData *)jpegForGray:(const uint8_t *)pixels width:(int)width height:(int)height quality:(float)quality
+{
+    CGColorSpaceRef gray = CGColorSpaceCreateDeviceGray();
+    CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, pixels, (size_t) width * height, NULL);
+    CGImageRef image = CGImageCreate(width, height, 8, 8, width, gray, (CGBitmapInfo) kCGImageAlphaNone,
+                                     provider, NULL, false, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+    CGColorSpaceRelease(gray);
+    if (image == NULL)
+        return nil;
+    
+    NSMutableData *jpeg = [NSMutableData data];
+    BOOL written = NO;
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef) jpeg, CFSTR("public.jpeg"), 1, NULL);
+    if (destination != NULL)
+    {
+        NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithFloat:quality], (id) kCGImageDestinationLossyCompressionQuality, nil];
+        CGImageDestinationAddImage(destination, image, (__bridge CFDictionaryRef) options);
+        written = CGImageDestinationFinalize(destination);
+        CFRelease(destination);
+    }
+    CGImageRelease(image);
+    return written ? jpeg : nil;
+}
+
+// The SDK only takes proxy settings before a scanner opens, pooled ones
+// keep theirs until evicted or closed
+-(void)setProxyHost:(NSString *)host port:(NSNumber *)port
+{
+    dispatch_async(_scanQueue, ^{
+        _proxyHost = host;
+        _proxyPort = port;
+    });
+}
+
+-(void)setFallbackPolicy:(const FallbackPolicy &)policy
+{
+    _fallback.setPolicy(policy);
+}
+
+-(FallbackStats)fallbackStats
+{
+    return _fallback.stats();
+}
+
+// Scans the plane, `region` of the frame, off the main thread and hands it
+// back to the buffer pool. `fallback` marks a full frame scanned after
+// region misses. A record is always pushed so ActionScript can
+// tell a miss (type 0) from a match for the given tag; a fresh miss may
+// first be searched on the server.
+-(void)scanGray:(uint8_t *)gray width:(int)width height:(int)height region:(RoiRect)region fallback:(BOOL)fallback resultTypes:(int)resultTypes source:(ResultSource)source tag:(uint32_t)tag
+{
+    bool cropped = region.width < 1 || region.height < 1;
+    double timestamp = CFAbsoluteTimeGetCurrent();
+    
+    dispatch_async(_scanQueue, ^{
+        // the governor budgets CPU, not time spent waiting for the lanes;
+        // other contexts share the lane pool, only this plane's lanes count
+        double cpu = threadCpuTime();
+        BOOL blurred, searched;
+        MSResult *result = [self recognizeFrame:gray width:width height:height resultTypes:resultTypes fallback:fallback blurred:&blurred searched:&searched];
+        if (blurred)
+            [self pushDroppedFrame:tag source:source flags:ResultFlagBlurred timestamp:timestamp];
+        else
+        {
+            _region.scanned(cropped, result != nil);
+            BOOL deferred = result == nil && searched && (resultTypes & MSResultTypeImage) &&
+                            [self searchServer:gray width:width height:height source:source tag:tag timestamp:timestamp region:region];
+            if (!deferred)
+                [self pushResult:result source:source tag:tag timestamp:timestamp region:region];
+        }
+        
+        // the result is out, the plane goes back once the losing stage is done
+        double lanes = [self settleLanes];
+        _frameGovernor.processed(threadCpuTime() - cpu + lanes);
+        BufferPool::shared().release(gray, (size_t) width * height);
+    });
+}
+
+// Decodes a JPEG or PNG straight to a luma plane no larger than needed.
+// JPEGs are asked for at a DCT scaled size so ImageIO never reconstructs the
+// full resolution image; our area resampler does the last step. The plane
+// lands in the workspace's decodePlane and is valid until the next decode.
+-(BOOL)decodeEncoded:(const uint8_t *)bytes length:(size_t)length resultTypes:(int)resultTypes workspace:(ScanWorkspace &)workspace width:(int *)width height:(int *)height
+{
+    ImageHeader header;
+    if (!readImageHeader(bytes, length, &header))
+        return NO;
+    
+    int queryWidth, queryHeight;
+    ScanTarget target = (resultTypes & kMSResultAllBarcodes) ? ScanTargetBarcode : ScanTargetImage;
+    querySizeFor(header.width, header.height, target, &queryWidth, &queryHeight);
+    int decodeSide = scaledDecodeSide(header, queryWidth > queryHeight ? queryWidth : queryHeight);
+    
+    NSData *encoded = [NSData dataWithBytesNoCopy:(void *) bytes length:length freeWhenDone:NO];
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef) encoded, NULL);
+    if (source == NULL)
+        return NO;
+    
+    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
+                             (id) kCFBooleanTrue, (id) kCGImageSourceCreateThumbnailFromImageAlways,
+                             (id) kCFBooleanTrue, (id) kCGImageSourceCreateThumbnailWithTransform,
+                             (id) kCFBooleanFalse, (id) kCGImageSourceShouldCache,
+                             [NSNumber numberWithInt:decodeSide], (id) kCGImageSourceThumbnailMaxPixelSize, nil];
+    CGImageRef image = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef) options);
+    CFRelease(source);
+    if (image == NULL)
+        return NO;
+    
+    *width = (int) CGImageGetWidth(image);
+    *height = (int) CGImageGetHeight(image);
+    std::vector<uint8_t> &plane = workspace.decodePlane;
+    if (plane.size() < (size_t) *width * *height)
+        plane.resize((size_t) *width * *height);
+    
+    // drawing into a DeviceGray context keeps only luma
+    CGColorSpaceRef gray = CGColorSpaceCreateDeviceGray();
+    CGContextRef context = CGBitmapContextCreate(&plane[0], *width, *height, 8, *width, gray, (CGBitmapInfo) kCGImageAlphaNone);
+    CGColorSpaceRelease(gray);
+    if (context != NULL)
+    {
+        CGContextSetInterpolationQuality(context, kCGInterpolationNone);
+        CGContextDrawImage(context, CGRectMake(0, 0, *width, *height), image);
+        CGContextRelease(context);
+    }
+    CGImageRelease(image);
+    return context != NULL;
+}
+
+// Takes ownership of `encoded`, a BufferPool buffer of `length` bytes
+-(BOOL)scanEncoded:(uint8_t *)encoded length:(size_t)length resultTypes:(int)resultTypes tag:(uint32_t)tag
+{
+    if (![self openState:NULL key:NULL secret:NULL])
+    {
+        BufferPool::shared().release(encoded, length);
+        return NO;
+    }
+    
+    double timestamp = CFAbsoluteTimeGetCurrent();
+    dispatch_async(_scanQueue, ^{
+        MSResult *result = nil;
+        BOOL deferred = NO;
+        BOOL decoded = NO;
+        int width, height;
+        if ([self decodeEncoded:encoded length:length resultTypes:resultTypes workspace:_workspace width:&width height:&height])
+        {
+            decoded = YES;
+            const uint8_t *plane = &_workspace.decodePlane[0];
+            result = [self recognizeGrayInLanes:plane width:width height:height resultTypes:resultTypes level:SearchLevelDefault];
+            RoiRect frame = { 0, 0, 1, 1 };
+            deferred = result == nil && (resultTypes & MSResultTypeImage) &&
+                       [self searchServer:plane width:width height:height source:ResultSourceEncoded tag:tag timestamp:timestamp region:frame];
+        }
+        BufferPool::shared().release(encoded, length);
+        if (!decoded)
+            [self pushDroppedFrame:tag source:ResultSourceEncoded flags:ResultFlagError timestamp:timestamp];
+        else if (!deferred)
+            [self pushResult:result source:ResultSourceEncoded tag:tag timestamp:timestamp];
+        [self settleLanes];
+    });
+    return YES;
+}
+
+// Fans the batch out over the shared worker pool. Results are pushed as
+// they complete, tagged with the item's index; only one batch runs at a time.
+-(BOOL)scanBatch:(const std::shared_ptr<ScanBatchJob> &)job
+{
+    if (![self openState:NULL key:NULL secret:NULL])
+        return NO;
+    
+    if (!batchPool().run(job, job->items.size()))
+        return NO;
+    _batch = job;
+    return YES;
+}
+
+-(void)cancelBatch
+{
+    if (!_batch.expired())
+        batchPool().cancel();
+}
+
+// Called on a batch worker. An image that could not be read or decoded is
+// reported as a ResultFlagError record, not as a miss.
+-(void)scanBatchItem:(const BatchItem &)item index:(uint32_t)index resultTypes:(int)resultTypes workspace:(ScanWorkspace &)workspace
+{
+    double timestamp = CFAbsoluteTimeGetCurrent();
+    MSResult *result = nil;
+    BOOL scanned = NO;
+    
+    if (item.bytes != NULL && item.width > 0)
+    {
+        result = [self recognizeGray:item.bytes width:item.width height:item.height resultTypes:resultTypes level:SearchLevelDefault workspace:workspace];
+        scanned = YES;
+    }
+    else if (item.bytes != NULL)
+    {
+        int width, height;
+        if ([self decodeEncoded:item.bytes length:item.length resultTypes:resultTypes workspace:workspace width:&width height:&height])
+        {
+            result = [self recognizeGray:&workspace.decodePlane[0] width:width height:height resultTypes:resultTypes level:SearchLevelDefault workspace:workspace];
+            scanned = YES;
+        }
+    }
+    
+    if (scanned)
+        [self pushResult:result source:ResultSourceBatch tag:index timestamp:timestamp];
+    else
+        [self pushDroppedFrame:index source:ResultSourceBatch flags:ResultFlagError timestamp:timestamp];
+}
+
+// Called on the last batch worker, after every result of the batch was pushed
+-(void)batchFinished:(size_t)processed cancelled:(bool)cancelled
+{
+    if (_context == NULL)
+        return;
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self scheduleSync];
+    });
+    
+    NSString *level = [NSString stringWithFormat:@"%lu", (unsigned long) processed];
+    FREDispatchStatusEventAsync(_context, cancelled ? kBatchCancelled : kBatchComplete, (const uint8_t *) [level UTF8String]);
+}
+
+-(BOOL)scanBitmap:(const BitmapView &)bitmap resultTypes:(int)resultTypes tag:(uint32_t)tag
+{
+    if (![self openState:NULL key:NULL secret:NULL])
+        return NO;
+    
+    // frames over the CPU budget are not even converted
+    double timestamp = CFAbsoluteTimeGetCurrent();
+    if (!_frameGovernor.admit(timestamp))
+    {
+        [self pushDroppedFrame:tag source:ResultSourceBitmap flags:ResultFlagSkipped timestamp:timestamp];
+        return YES;
+    }
+    
+    // only the region of interest is converted and searched
+    CropRect crop;
+    bool fallback;
+    _region.next(bitmap.width, bitmap.height, &crop, &fallback);
+    RoiRect region = {
+        (double) crop.x / bitmap.width, (double) crop.y / bitmap.height,
+        (double) crop.width / bitmap.width, (double) crop.height / bitmap.height
+    };
+    
+    uint8_t *gray = (uint8_t *) BufferPool::shared().acquire((size_t) crop.width * crop.height);
+    if (gray == NULL)
+        return NO;
+    GrayView view = { gray, crop.width, crop.height, crop.width };
+    convertBitmapToGray(bitmap, crop, view);
+    
+    [self scanGray:gray width:crop.width height:crop.height region:region fallback:fallback resultTypes:resultTypes source:ResultSourceBitmap tag:tag];
+    return YES;
+}
+
+-(void)setRegionPolicy:(const RoiPolicy &)policy
+{
+    _region.setPolicy(policy);
+}
+
+-(RoiStats)regionStats
+{
+    return _region.stats();
+}
+
+// Time to first frame, from runScanner to a running capture session
+-(void)cameraReady:(NSNotification *)notification
+{
+    double elapsed = [[[notification userInfo] objectForKey:@"elapsed"] doubleValue];
+    Timeline::coldStart().mark("camera");
+    NSLog(@"[MOODSTOCKS] CAMERA READY IN %.0f ms", elapsed * 1000.0);
+    
+    if (_context != NULL)
+    {
+        NSString *level = [NSString stringWithFormat:@"%.1f", elapsed * 1000.0];
+        FREDispatchStatusEventAsync(_context, kCameraReady, (const uint8_t *) [level UTF8String]);
+    }
+    
+    if (_cameraMode == ScannerModeAuto)
+        [self startGovernor];
+}
+
+//
+//  Frame governor of the auto mode camera, main thread
+//
+//  The auto session scans inside the SDK with no per frame hook, so
+//  processing is duty cycled instead: short bursts of scanning are
+//  measured as the process CPU time they add on top of the idle rate
+//  (preview and UI alone, measured between bursts), and the governor spaces
+//  the bursts so scanning stays within budget. The display link also feeds
+//  it the UI frame times.
+//
+
+static const double kBurstLength = 0.1;
+
+-(void)startGovernor
+{
+    if (_displayLink != nil)
+        return;
+    
+    _cameraGovernor.reset();
+    _cameraProcessing = YES;
+    _burstStart = CACurrentMediaTime();
+    _burstCpu = processCpuTime();
+    _lastDisplayTime = 0;
+    
+    _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayTick:)];
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+-(void)stopGovernor
+{
+    [_displayLink invalidate];
+    _displayLink = nil;
+    if (!_cameraProcessing)
+        [_scannerUIViewController setProcessing:YES];
+    _cameraProcessing = NO;
+}
+
+-(void)displayTick:(CADisplayLink *)link
+{
+    double now = [link timestamp];
+    if (_lastDisplayTime > 0)
+        _cameraGovernor.uiFrame(now - _lastDisplayTime);
+    _lastDisplayTime = now;
+    
+    double cpu = processCpuTime();
+    if (_cameraProcessing)
+    {
+        if (now - _burstStart < kBurstLength)
+            return;
+        
+        _cameraGovernor.processed((cpu - _burstCpu) - _idleCpuRate * (now - _burstStart));
+        _cameraProcessing = NO;
+        _idleStart = now;
+        _idleCpu = cpu;
+        [_scannerUIViewController setProcessing:NO];
+    }
+    else if (_cameraGovernor.admit(now))
+    {
+        if (now > _idleStart)
+        {
+            double rate = (cpu - _idleCpu) / (now - _idleStart);
+            _idleCpuRate = _idleCpuRate == 0 ? rate : _idleCpuRate + 0.2 * (rate - _idleCpuRate);
+        }
+        _cameraProcessing = YES;
+        _burstStart = now;
+        _burstCpu = cpu;
+        [_scannerUIViewController setProcessing:YES];
+    }
+}
+
+-(void)setGovernorPolicy:(const GovernorPolicy &)policy
+{
+    _cameraGovernor.setPolicy(policy);
+    _frameGovernor.setPolicy(policy);
+}
+
+-(GovernorStats)cameraGovernorStats
+{
+    return _cameraGovernor.stats();
+}
+
+-(GovernorStats)frameGovernorStats
+{
+    return _frameGovernor.stats();
+}
+
+-(void)exitHandler:(NSNotification *)notification
+{
+    [self hideCam];
+}
+
+-(void)matchFound:(NSNotification *)notification
+{
+    MSResult *result = [[notification userInfo] objectForKey:@"result"];
+    NSNumber *timestamp = [[notification userInfo] objectForKey:@"timestamp"];
+    if ([[[notification userInfo] objectForKey:@"timedOut"] boolValue])
+        [self pushDroppedFrame:0 source:ResultSourceCamera flags:ResultFlagTimeout timestamp:[timestamp doubleValue]];
+    else
+        [self pushResult:result source:ResultSourceCamera tag:0 timestamp:[timestamp doubleValue]];
+}
+
+@end
+
+
+//
+//  Public Methods
+//  Exposed to ActionScript
+//
+
+static UIViewExtension *extensionForContext(FREContext ctx)
+{
+    void *nativeData = NULL;
+    FREGetContextNativeData(ctx, &nativeData);
+    return (__bridge UIViewExtension *) nativeData;
+}
+
+static uint32_t uintArgument(uint32_t argc, FREObject argv[], uint32_t index, uint32_t fallback)
+{
+    uint32_t value;
+    if (index < argc && FREGetObjectAsUint32(argv[index], &value) == FRE_OK)
+        return value;
+    return fallback;
+}
+
+static BitmapView bitmapViewOf(const FREBitmapData2 &bitmapData)
+{
+    BitmapView bitmap;
+    bitmap.bits = bitmapData.bits32;
+    bitmap.width = (int) bitmapData.width;
+    bitmap.height = (int) bitmapData.height;
+    bitmap.lineStride32 = (int) bitmapData.lineStride32;
+    bitmap.invertedY = bitmapData.isInvertedY != 0;
+    bitmap.premultiplied = bitmapData.isPremultiplied != 0;
+    bitmap.hasAlpha = bitmapData.hasAlpha != 0;
+    return bitmap;
+}
+
+static FREObject boolObject(bool value)
+{
+    FREObject object = NULL;
+    FRENewObjectFromBool(value ? 1 : 0, &object);
+    return object;
+}
+
+static FREObject uintObject(uint32_t value)
+{
+    FREObject object = NULL;
+    FRENewObjectFromUint32(value, &object);
+    return object;
+}
+
+// runScanner(apiKey, apiSecret[, mode, resultTypes, resultExtras,
+// searchOptions]): returns a job id right away, the camera shows once the
+// scanner is open
+FREObject runScanner(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    NSLog(@"Run Scanner being called.");
+    Timeline::coldStart().mark("runScanner");
+    
+    uint32_t urlLength;
+    const uint8_t *apikey;
+    const uint8_t *apisecret;
+    FREGetObjectAsUTF8(argv[0], &urlLength, &apikey);
+    FREGetObjectAsUTF8(argv[1], &urlLength, &apisecret);
+    NSString *nsapikey = [NSString stringWithUTF8String:(char*)apikey];
+    NSString *nsapisecret = [NSString stringWithUTF8String:(char*)apisecret];
+    
+    ScannerMode mode = (ScannerMode) uintArgument(argc, argv, 2, ScannerModeManual);
+    int resultTypes = (int) uintArgument(argc, argv, 3, kDefaultResultTypes);
+    int resultExtras = (int) uintArgument(argc, argv, 4, MSResultExtraNone);
+    int searchOptions = (int) uintArgument(argc, argv, 5, MSSearchDefault);
+    
+    return uintObject([extensionForContext(ctx) showCam:nsapikey apisecret:nsapisecret mode:mode resultTypes:resultTypes resultExtras:resultExtras searchOptions:searchOptions]);
+}
+
+FREObject releaseScanner(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    return uintObject([extensionForContext(ctx) hideCam]);
+}
+
+// Opens the scanner without presenting the camera UI, for headless
+// scanning. Blocks until the database is open; openScannerAsync does not.
+FREObject openScanner(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t length;
+    const uint8_t *apikey;
+    const uint8_t *apisecret;
+    if (FREGetObjectAsUTF8(argv[0], &length, &apikey) != FRE_OK ||
+        FREGetObjectAsUTF8(argv[1], &length, &apisecret) != FRE_OK)
+        return boolObject(false);
+    
+    NSString *nsapikey = [NSString stringWithUTF8String:(char*)apikey];
+    NSString *nsapisecret = [NSString stringWithUTF8String:(char*)apisecret];
+    return boolObject([extensionForContext(ctx) openWithKey:nsapikey secret:nsapisecret]);
+}
+
+FREObject openScannerAsync(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t length;
+    const uint8_t *apikey;
+    const uint8_t *apisecret;
+    if (FREGetObjectAsUTF8(argv[0], &length, &apikey) != FRE_OK ||
+        FREGetObjectAsUTF8(argv[1], &length, &apisecret) != FRE_OK)
+        return uintObject(0);
+    
+    NSString *nsapikey = [NSString stringWithUTF8String:(char*)apikey];
+    NSString *nsapisecret = [NSString stringWithUTF8String:(char*)apisecret];
+    return uintObject([extensionForContext(ctx) openAsyncWithKey:nsapikey secret:nsapisecret]);
+}
+
+FREObject closeScanner(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    return uintObject([extensionForContext(ctx) closeAsync]);
+}
+
+FREObject syncScanner(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    return uintObject([extensionForContext(ctx) syncAsync]);
+}
+
+// importBundle(path): imports the signatures of a bundle shipped with the
+// app into the open scanner, returns the job id
+FREObject importBundle(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t length;
+    const uint8_t *path;
+    if (argc < 1 || FREGetObjectAsUTF8(argv[0], &length, &path) != FRE_OK)
+        return uintObject(0);
+    return uintObject([extensionForContext(ctx) importAsyncFromBundle:[NSString stringWithUTF8String:(const char *) path]]);
+}
+
+// scanBitmapData(bitmapData, resultTypes, tag): converts the BitmapData to
+// grayscale while it is acquired and scans it in the background. The result,
+// or a type 0 record on a miss, arrives through the result ring with `tag`.
+FREObject scanBitmapData(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t resultTypes = uintArgument(argc, argv, 1, kDefaultResultTypes);
+    uint32_t tag = uintArgument(argc, argv, 2, 0);
+    
+    FREBitmapData2 bitmapData;
+    if (FREAcquireBitmapData2(argv[0], &bitmapData) != FRE_OK)
+        return boolObject(false);
+    
+    BitmapView bitmap = bitmapViewOf(bitmapData);
+    BOOL queued = [extensionForContext(ctx) scanBitmap:bitmap resultTypes:(int) resultTypes tag:tag];
+    FREReleaseBitmapData(argv[0]);
+    return boolObject(queued);
+}
+
+// scanEncodedBytes(byteArray, resultTypes, tag): scans a JPEG or PNG file
+// image. Only the compressed bytes are copied during the call, decoding and
+// recognition run in the background.
+FREObject scanEncodedBytes(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t resultTypes = uintArgument(argc, argv, 1, kDefaultResultTypes);
+    uint32_t tag = uintArgument(argc, argv, 2, 0);
+    
+    FREByteArray bytes;
+    if (FREAcquireByteArray(argv[0], &bytes) != FRE_OK)
+        return boolObject(false);
+    
+    ImageHeader header;
+    size_t length = bytes.length;
+    uint8_t *encoded = NULL;
+    if (readImageHeader(bytes.bytes, length, &header))
+        encoded = (uint8_t *) BufferPool::shared().acquire(length);
+    if (encoded != NULL)
+        memcpy(encoded, bytes.bytes, length);
+    FREReleaseByteArray(argv[0]);
+    
+    if (encoded == NULL)
+        return boolObject(false);
+    return boolObject([extensionForContext(ctx) scanEncoded:encoded length:length resultTypes:(int) resultTypes tag:tag]);
+}
+
+// scanBatch(images, resultTypes): `images` is a Vector.<BitmapData> or a
+// Vector.<ByteArray> of JPEG/PNG files. Bitmaps are converted to grayscale
+// and files copied during the call, everything else runs on the worker pool.
+// Each result carries its index as tag; batchComplete or batchCancelled
+// follows the last one with the number of images processed.
+FREObject scanBatch(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t resultTypes = uintArgument(argc, argv, 1, kDefaultResultTypes);
+    uint32_t count;
+    if (FREGetArrayLength(argv[0], &count) != FRE_OK || count == 0)
+        return boolObject(false);
+    
+    UIViewExtension *ext = extensionForContext(ctx);
+    std::shared_ptr<ScanBatchJob> job = std::make_shared<ScanBatchJob>(ext, (int) resultTypes);
+    job->items.resize(count);
+    
+    for (uint32_t i = 0; i < count; i++)
+    {
+        BatchItem &item = job->items[i];
+        item.bytes = NULL;
+        item.length = 0;
+        item.width = 0;
+        item.height = 0;
+        
+        FREObject element;
+        if (FREGetArrayElementAt(argv[0], i, &element) != FRE_OK)
+            continue;
+        
+        FREBitmapData2 bitmapData;
+        FREByteArray bytes;
+        if (FREAcquireBitmapData2(element, &bitmapData) == FRE_OK)
+        {
+            BitmapView bitmap = bitmapViewOf(bitmapData);
+            item.length = (size_t) bitmap.width * bitmap.height;
+            item.bytes = (uint8_t *) BufferPool::shared().acquire(item.length);
+            if (item.bytes != NULL)
+            {
+                GrayView view = { item.bytes, bitmap.width, bitmap.height, bitmap.width };
+                convertBitmapToGray(bitmap, view);
+                item.width = bitmap.width;
+                item.height = bitmap.height;
+            }
+            FREReleaseBitmapData(element);
+        }
+        else if (FREAcquireByteArray(element, &bytes) == FRE_OK)
+        {
+            ImageHeader header;
+            if (readImageHeader(bytes.bytes, bytes.length, &header))
+            {
+                item.length = bytes.length;
+                item.bytes = (uint8_t *) BufferPool::shared().acquire(item.length);
+                if (item.bytes != NULL)
+                    memcpy(item.bytes, bytes.bytes, item.length);
+            }
+            FREReleaseByteArray(element);
+        }
+    }
+    
+    return boolObject([ext scanBatch:job]);
+}
+
+FREObject cancelBatch(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    [extensionForContext(ctx) cancelBatch];
+    return NULL;
+}
+
+// Copies every pending packed result into the ByteArray passed in argv[0],
+// growing it only when it is too small, and returns the number of bytes written
+FREObject drainResults(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    UIViewExtension *ext = extensionForContext(ctx);
+    FREObject byteCount = NULL;
+    FREByteArray bytes;
+    
+    size_t pending = [ext pendingResultBytes];
+    if (FREAcquireByteArray(argv[0], &bytes) != FRE_OK)
+        return NULL;
+    uint32_t capacity = bytes.length;
+    FREReleaseByteArray(argv[0]);
+    
+    if (capacity < pending)
+    {
+        // grow in powers of two so a busy scan loop settles on one buffer
+        capacity = 256;
+        while (capacity < pending) capacity <<= 1;
+        
+        FREObject length;
+        FREObject exception;
+        FRENewObjectFromUint32(capacity, &length);
+        FRESetObjectProperty(argv[0], (const uint8_t *) "length", length, &exception);
+    }
+    
+    bool hasMore = false;
+    size_t written = 0;
+    if (FREAcquireByteArray(argv[0], &bytes) == FRE_OK)
+    {
+        written = [ext drainResults:bytes.bytes length:bytes.length hasMore:&hasMore];
+        FREReleaseByteArray(argv[0]);
+    }
+    
+    // results that landed after we sized the buffer are announced again
+    if (hasMore)
+        FREDispatchStatusEventAsync(ctx, kResultsAvailable, (const uint8_t *) "");
+    
+    FRENewObjectFromUint32((uint32_t) written, &byteCount);
+    return byteCount;
+}
+
+static void setNumberProperty(FREObject object, const char *name, double value)
+{
+    FREObject number;
+    FREObject exception;
+    if (FRENewObjectFromDouble(value, &number) == FRE_OK)
+        FRESetObjectProperty(object, (const uint8_t *) name, number, &exception);
+}
+
+// Returns the shared buffer pool counters as a plain Object
+FREObject bufferPoolStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    BufferPoolStats stats = BufferPool::shared().stats();
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "allocations", (double) stats.allocations);
+    setNumberProperty(object, "reuses", (double) stats.reuses);
+    setNumberProperty(object, "bytesInUse", (double) stats.bytesInUse);
+    setNumberProperty(object, "bytesCached", (double) stats.bytesCached);
+    setNumberProperty(object, "highWaterInUse", (double) stats.highWaterInUse);
+    setNumberProperty(object, "highWaterTotal", (double) stats.highWaterTotal);
+    setNumberProperty(object, "capacity", (double) stats.capacity);
+    return object;
+}
+
+// setBufferPoolCapacity(bytes): idle buffers above the cap are freed
+FREObject setBufferPoolCapacity(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t capacity;
+    if (FREGetObjectAsUint32(argv[0], &capacity) == FRE_OK)
+        BufferPool::shared().setCapacity(capacity);
+    return NULL;
+}
+
+// prewarm(apiKey, apiSecret): returns a job id, see prewarmWithKey
+FREObject prewarm(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t length;
+    const uint8_t *apikey;
+    const uint8_t *apisecret;
+    if (FREGetObjectAsUTF8(argv[0], &length, &apikey) != FRE_OK ||
+        FREGetObjectAsUTF8(argv[1], &length, &apisecret) != FRE_OK)
+        return uintObject(0);
+    
+    NSString *nsapikey = [NSString stringWithUTF8String:(char*)apikey];
+    NSString *nsapisecret = [NSString stringWithUTF8String:(char*)apisecret];
+    return uintObject([extensionForContext(ctx) prewarmWithKey:nsapikey secret:nsapisecret]);
+}
+
+// Returns the cold start milestones as an Object of milliseconds since the
+// extension was initialized
+FREObject coldStartTimeline(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    std::vector<Timeline::Mark> marks = Timeline::coldStart().marks();
+    for (size_t i = 0; i < marks.size(); i++)
+        setNumberProperty(object, marks[i].name.c_str(), marks[i].milliseconds);
+    return object;
+}
+
+// setSyncPolicy(minInterval, unmeteredOnly, idleOnly)
+FREObject setSyncPolicy(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    SyncPolicy policy;
+    double minInterval;
+    uint32_t unmeteredOnly, idleOnly;
+    if (argc > 0 && FREGetObjectAsDouble(argv[0], &minInterval) == FRE_OK && minInterval >= 0)
+        policy.minInterval = minInterval;
+    if (argc > 1 && FREGetObjectAsBool(argv[1], &unmeteredOnly) == FRE_OK)
+        policy.unmeteredOnly = unmeteredOnly != 0;
+    if (argc > 2 && FREGetObjectAsBool(argv[2], &idleOnly) == FRE_OK)
+        policy.idleOnly = idleOnly != 0;
+    
+    [extensionForContext(ctx) setSyncPolicy:policy];
+    return NULL;
+}
+
+// setSyncStatusInterval(seconds): minimum time between two syncStatus events
+FREObject setSyncStatusInterval(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    double interval;
+    if (FREGetObjectAsDouble(argv[0], &interval) == FRE_OK)
+        [extensionForContext(ctx) setSyncStatusInterval:interval];
+    return NULL;
+}
+
+// Returns what successful syncs of this context downloaded so far
+FREObject syncStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    UIViewExtension *ext = extensionForContext(ctx);
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "syncCount", (double) [ext syncCount]);
+    setNumberProperty(object, "lastSyncBytes", (double) [ext lastSyncBytes]);
+    setNumberProperty(object, "totalSyncBytes", (double) [ext totalSyncBytes]);
+    setNumberProperty(object, "lastSyncDuration", [ext lastSyncDuration]);
+    return object;
+}
+
+// setScannerPoolLimits(maxScanners, maxBytes): least recently used
+// scanners above either limit are closed
+FREObject setScannerPoolLimits(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t maxScanners;
+    double maxBytes;
+    if (FREGetObjectAsUint32(argv[0], &maxScanners) == FRE_OK &&
+        FREGetObjectAsDouble(argv[1], &maxBytes) == FRE_OK)
+        [extensionForContext(ctx) setPoolLimits:maxScanners bytes:(uint64_t) maxBytes];
+    return NULL;
+}
+
+FREObject scannerPoolStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    double lastSwitch;
+    BOOL pooled;
+    ScannerPoolStats stats = [extensionForContext(ctx) poolStats:&lastSwitch pooled:&pooled];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "open", (double) stats.open);
+    setNumberProperty(object, "bytes", (double) stats.bytes);
+    setNumberProperty(object, "hits", (double) stats.hits);
+    setNumberProperty(object, "misses", (double) stats.misses);
+    setNumberProperty(object, "evictions", (double) stats.evictions);
+    setNumberProperty(object, "lastSwitchTime", lastSwitch * 1000);
+    if (FRESetObjectProperty(object, (const uint8_t *) "lastSwitchPooled", boolObject(pooled), &exception) != FRE_OK)
+        return NULL;
+    return object;
+}
+
+// setSceneCache(ttl, maxDistance): frames within maxDistance bits of one
+// scanned less than ttl seconds ago reuse its result, a ttl of 0 turns this off
+FREObject setSceneCache(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    double ttl;
+    uint32_t maxDistance;
+    if (FREGetObjectAsDouble(argv[0], &ttl) == FRE_OK &&
+        FREGetObjectAsUint32(argv[1], &maxDistance) == FRE_OK)
+        [extensionForContext(ctx) configureSceneCache:ttl maxDistance:(int) maxDistance];
+    return NULL;
+}
+
+FREObject sceneCacheStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    SceneCacheStats stats = [extensionForContext(ctx) sceneCacheStats];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "lookups", (double) stats.lookups);
+    setNumberProperty(object, "hits", (double) stats.hits);
+    setNumberProperty(object, "savedTime", stats.savedTime * 1000);
+    return object;
+}
+
+// setFrameGovernor(cpuBudget, uiFrameTime): share of a core continuous
+// scanning may use, 0 to scan every frame, and the UI frame time to protect
+FREObject setFrameGovernor(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    GovernorPolicy policy;
+    double cpuBudget, uiFrameTime;
+    if (argc > 0 && FREGetObjectAsDouble(argv[0], &cpuBudget) == FRE_OK && cpuBudget >= 0)
+        policy.cpuBudget = cpuBudget;
+    if (argc > 1 && FREGetObjectAsDouble(argv[1], &uiFrameTime) == FRE_OK && uiFrameTime >= 0)
+        policy.uiFrameTime = uiFrameTime;
+    
+    [extensionForContext(ctx) setGovernorPolicy:policy];
+    return NULL;
+}
+
+static FREObject governorStatsObject(const GovernorStats &stats)
+{
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "admitted", (double) stats.admitted);
+    setNumberProperty(object, "skipped", (double) stats.skipped);
+    setNumberProperty(object, "averageCost", stats.averageCost * 1000);
+    setNumberProperty(object, "interval", stats.interval * 1000);
+    setNumberProperty(object, "budget", stats.budget);
+    return object;
+}
+
+// Returns { camera, frames }: the governors of the auto mode camera and of
+// scanBitmapData, times in milliseconds
+FREObject frameGovernorStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    UIViewExtension *ext = extensionForContext(ctx);
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    FRESetObjectProperty(object, (const uint8_t *) "camera", governorStatsObject([ext cameraGovernorStats]), &exception);
+    FRESetObjectProperty(object, (const uint8_t *) "frames", governorStatsObject([ext frameGovernorStats]), &exception);
+    return object;
+}
+
+// setFrameGate(enabled, sharpnessRatio, maxMotion): which scanBitmapData
+// frames are too blurred or moving to be searched
+FREObject setFrameGate(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    GatePolicy policy;
+    uint32_t enabled;
+    double sharpnessRatio, maxMotion;
+    if (argc > 0 && FREGetObjectAsBool(argv[0], &enabled) == FRE_OK)
+        policy.enabled = enabled != 0;
+    if (argc > 1 && FREGetObjectAsDouble(argv[1], &sharpnessRatio) == FRE_OK && sharpnessRatio >= 0)
+        policy.sharpnessRatio = sharpnessRatio;
+    if (argc > 2 && FREGetObjectAsDouble(argv[2], &maxMotion) == FRE_OK && maxMotion > 0)
+        policy.maxMotion = maxMotion;
+    
+    [extensionForContext(ctx) setGatePolicy:policy];
+    return NULL;
+}
+
+FREObject frameGateStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    GateStats stats = [extensionForContext(ctx) gateStats];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "frames", (double) stats.frames);
+    setNumberProperty(object, "passed", (double) stats.passed);
+    setNumberProperty(object, "blurred", (double) stats.blurred);
+    setNumberProperty(object, "moving", (double) stats.moving);
+    return object;
+}
+
+// setRegionOfInterest(enabled, x, y, width, height, fallbackMisses): the
+// part of scanBitmapData frames that is scanned, normalized to the bitmap
+FREObject setRegionOfInterest(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    RoiPolicy policy;
+    
+    uint32_t enabled;
+    double x, y, width, height;
+    if (argc > 0 && FREGetObjectAsBool(argv[0], &enabled) == FRE_OK)
+        policy.enabled = enabled != 0;
+    if (argc > 4 &&
+        FREGetObjectAsDouble(argv[1], &x) == FRE_OK &&
+        FREGetObjectAsDouble(argv[2], &y) == FRE_OK &&
+        FREGetObjectAsDouble(argv[3], &width) == FRE_OK &&
+        FREGetObjectAsDouble(argv[4], &height) == FRE_OK)
+    {
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > 1 || y + height > 1)
+            return NULL;
+        RoiRect rect = { x, y, width, height };
+        policy.rect = rect;
+    }
+    policy.fallbackMisses = (int) uintArgument(argc, argv, 5, (uint32_t) policy.fallbackMisses);
+    
+    [extensionForContext(ctx) setRegionPolicy:policy];
+    return NULL;
+}
+
+FREObject regionOfInterestStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    RoiStats stats = [extensionForContext(ctx) regionStats];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "frames", (double) stats.frames);
+    setNumberProperty(object, "cropped", (double) stats.cropped);
+    setNumberProperty(object, "fallbacks", (double) stats.fallbacks);
+    setNumberProperty(object, "fallbackHits", (double) stats.fallbackHits);
+    setNumberProperty(object, "pixelRatio", stats.framePixels > 0 ? (double) stats.pixels / stats.framePixels : 1);
+    return object;
+}
+
+// setSearchEscalation(enabled, misses, noPartial): after how many misses in a
+// row a scene is searched with MSSearchSmallTarget, and whether every search
+// adds MSSearchNoPartial
+FREObject setSearchEscalation(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    EscalationPolicy policy;
+    
+    uint32_t enabled, noPartial;
+    if (argc > 0 && FREGetObjectAsBool(argv[0], &enabled) == FRE_OK)
+        policy.enabled = enabled != 0;
+    policy.misses = (int) uintArgument(argc, argv, 1, (uint32_t) policy.misses);
+    if (argc > 2 && FREGetObjectAsBool(argv[2], &noPartial) == FRE_OK)
+        policy.noPartial = noPartial != 0;
+    
+    [extensionForContext(ctx) setEscalationPolicy:policy];
+    return NULL;
+}
+
+static FREObject levelStatsObject(const LevelStats &stats)
+{
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "runs", (double) stats.runs);
+    setNumberProperty(object, "hits", (double) stats.hits);
+    setNumberProperty(object, "time", stats.time * 1000);
+    return object;
+}
+
+// Returns { standard, smallTarget, sceneChanges }, one { runs, hits, time }
+// per search option, times in milliseconds. Passing true resets them
+// afterwards.
+FREObject searchStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t reset = 0;
+    if (argc > 0)
+        FREGetObjectAsBool(argv[0], &reset);
+    EscalationStats stats = [extensionForContext(ctx) escalationStats:reset != 0];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    FRESetObjectProperty(object, (const uint8_t *) "standard", levelStatsObject(stats.levels[SearchLevelDefault]), &exception);
+    FRESetObjectProperty(object, (const uint8_t *) "smallTarget", levelStatsObject(stats.levels[SearchLevelSmallTarget]), &exception);
+    setNumberProperty(object, "sceneChanges", (double) stats.sceneChanges);
+    return object;
+}
+
+// setServerFallback(enabled, deadline, quality): whether headless misses are
+// searched on the server, how many seconds a server search may take there
+// and in the camera UI, and the JPEG quality the query goes through
+FREObject setServerFallback(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    FallbackPolicy policy;
+    
+    uint32_t enabled;
+    double deadline;
+    if (argc > 0 && FREGetObjectAsBool(argv[0], &enabled) == FRE_OK)
+        policy.enabled = enabled != 0;
+    if (argc > 1 && FREGetObjectAsDouble(argv[1], &deadline) == FRE_OK && deadline >= 0)
+        policy.deadline = deadline;
+    
+    double quality;
+    if (argc > 2 && FREGetObjectAsDouble(argv[2], &quality) == FRE_OK && quality >= 0 && quality <= 1)
+        policy.quality = (float) quality;
+    
+    [extensionForContext(ctx) setFallbackPolicy:policy];
+    return NULL;
+}
+
+FREObject serverFallbackStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    FallbackStats stats = [extensionForContext(ctx) fallbackStats];
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    uint64_t answered = stats.hits + stats.misses;
+    setNumberProperty(object, "requests", (double) stats.requests);
+    setNumberProperty(object, "hits", (double) stats.hits);
+    setNumberProperty(object, "misses", (double) stats.misses);
+    setNumberProperty(object, "errors", (double) stats.errors);
+    setNumberProperty(object, "timeouts", (double) stats.timeouts);
+    setNumberProperty(object, "busy", (double) stats.busy);
+    setNumberProperty(object, "offline", (double) stats.offline);
+    setNumberProperty(object, "averageTime", answered > 0 ? stats.time * 1000 / answered : 0);
+    setNumberProperty(object, "prepared", (double) stats.prepared);
+    setNumberProperty(object, "averagePreparedBytes", stats.prepared > 0 ? (double) stats.preparedBytes / stats.prepared : 0);
+    return object;
+}
+
+// setProxy(host, port): HTTP proxy of the scanners opened afterwards, an
+// empty host for none
+FREObject setProxy(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t length;
+    const uint8_t *host;
+    if (FREGetObjectAsUTF8(argv[0], &length, &host) != FRE_OK)
+        return NULL;
+    
+    NSString *nshost = length > 0 ? [NSString stringWithUTF8String:(char*)host] : nil;
+    NSNumber *port = [NSNumber numberWithUnsignedInt:uintArgument(argc, argv, 1, 80)];
+    [extensionForContext(ctx) setProxyHost:nshost port:(nshost != nil ? port : nil)];
+    return NULL;
+}
+
+// setCascadeOrder(order): 0 decodes barcodes first, 1 matches images first
+FREObject setCascadeOrder(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t order;
+    if (FREGetObjectAsUint32(argv[0], &order) == FRE_OK && order <= CascadeImageFirst)
+        [extensionForContext(ctx) setCascadeOrder:(CascadeOrder) order];
+    return NULL;
+}
+
+static FREObject stageStatsObject(const StageStats &stats)
+{
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    setNumberProperty(object, "runs", (double) stats.runs);
+    setNumberProperty(object, "hits", (double) stats.hits);
+    setNumberProperty(object, "skipped", (double) stats.skipped);
+    setNumberProperty(object, "time", stats.time * 1000);
+    return object;
+}
+
+// setParallelLanes(enabled): whether scanBitmapData and scanEncodedBytes
+// decode and match at the same time
+FREObject setParallelLanes(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    uint32_t enabled;
+    if (FREGetObjectAsBool(argv[0], &enabled) == FRE_OK)
+        [extensionForContext(ctx) setParallelLanes:enabled != 0];
+    return NULL;
+}
+
+// Returns { decode, search } stage counters, times in milliseconds, and
+// { runs, early } of the lane pool. Passing true resets the stage counters
+// afterwards.
+FREObject cascadeStats(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    UIViewExtension *ext = extensionForContext(ctx);
+    
+    FREObject object = NULL;
+    FREObject exception;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &object, &exception) != FRE_OK)
+        return NULL;
+    
+    FRESetObjectProperty(object, (const uint8_t *) "decode", stageStatsObject([ext cascadeStats:CascadeStageDecode]), &exception);
+    FRESetObjectProperty(object, (const uint8_t *) "search", stageStatsObject([ext cascadeStats:CascadeStageSearch]), &exception);
+    
+    LaneStats lanes = [ext laneStats];
+    FREObject lanesObject = NULL;
+    if (FRENewObject((const uint8_t *) "Object", 0, NULL, &lanesObject, &exception) == FRE_OK)
+    {
+        setNumberProperty(lanesObject, "runs", (double) lanes.runs);
+        setNumberProperty(lanesObject, "early", (double) lanes.early);
+        FRESetObjectProperty(object, (const uint8_t *) "lanes", lanesObject, &exception);
+    }
+    
+    uint32_t reset;
+    if (argc > 0 && FREGetObjectAsBool(argv[0], &reset) == FRE_OK && reset)
+        [ext resetCascadeStats];
+    return object;
+}
+
+// Copies pending job completions into the ByteArray passed in argv[0], as
+// packed JobCompletion records, and returns the number of bytes written
+FREObject drainJobs(FREContext ctx, void* funcData, uint32_t argc, FREObject argv[])
+{
+    UIViewExtension *ext = extensionForContext(ctx);
+    FREByteArray bytes;
+    
+    uint32_t wanted = (uint32_t) ([ext completedJobCount] * kJobCompletionSize);
+    if (FREAcquireByteArray(argv[0], &bytes) != FRE_OK)
+        return uintObject(0);
+    uint32_t capacity = bytes.length;
+    FREReleaseByteArray(argv[0]);
+    
+    if (capacity < wanted)
+    {
+        FREObject length;
+        FREObject exception;
+        FRENewObjectFromUint32(wanted, &length);
+        FRESetObjectProperty(argv[0], (const uint8_t *) "length", length, &exception);
+    }
+    
+    bool hasMore = false;
+    size_t count = 0;
+    if (FREAcquireByteArray(argv[0], &bytes) == FRE_OK)
+    {
+        count = [ext drainJobs:(JobCompletion *) bytes.bytes count:bytes.length / kJobCompletionSize hasMore:&hasMore];
+        FREReleaseByteArray(argv[0]);
+    }
+    
+    if (hasMore)
+        FREDispatchStatusEventAsync(ctx, kJobsCompleted, (const uint8_t *) "");
+    return uintObject((uint32_t) (count * kJobCompletionSize));
+}
+
+
+//
+//  Required API
+//  To Build AIR/ObjectiveC Bridge
+//
+
+extern "C" void MoodstocksExtContextInitializer(void* extData, const uint8_t* ctxType, FREContext ctx, uint32_t* numFunctionsToTest, const FRENamedFunction** functionsToSet)
+{
+    NSLog(@"ExtConInit Called");
+    Timeline::coldStart().mark("context");
+    
+    // every context drives its own scanners; in the default context the
+    // first key opened takes over the scanner.db of earlier versions, see
+    // adoptLegacyDatabaseForKey
+    UIViewExtension *ext = [[UIViewExtension alloc] initWithContext:ctx];
+    if (ctxType != NULL && ctxType[0] != '\0')
+        ext.dbName = [NSString stringWithFormat:@"scanner-%s.db", (const char *) ctxType];
+    FRESetContextNativeData(ctx, (__bridge_retained void *) ext);
+    
+    *numFunctionsToTest = 38;
+    FRENamedFunction* func = (FRENamedFunction*) malloc(sizeof(FRENamedFunction) * *numFunctionsToTest);
+    
+    func[0].name = (const uint8_t*) "runScanner";
+    func[0].functionData = NULL;
+    func[0].function = &runScanner;
+    
+    func[1].name = (const uint8_t*) "releaseScanner";
+    func[1].functionData = NULL;
+    func[1].function = &releaseScanner;
+    
+    func[2].name = (const uint8_t*) "drainResults";
+    func[2].functionData = NULL;
+    func[2].function = &drainResults;
+    
+    func[3].name = (const uint8_t*) "openScanner";
+    func[3].functionData = NULL;
+    func[3].function = &openScanner;
+    
+    func[4].name = (const uint8_t*) "scanBitmapData";
+    func[4].functionData = NULL;
+    func[4].function = &scanBitmapData;
+    
+    func[5].name = (const uint8_t*) "scanEncodedBytes";
+    func[5].functionData = NULL;
+    func[5].function = &scanEncodedBytes;
+    
+    func[6].name = (const uint8_t*) "scanBatch";
+    func[6].functionData = NULL;
+    func[6].function = &scanBatch;
+    
+    func[7].name = (const uint8_t*) "cancelBatch";
+    func[7].functionData = NULL;
+    func[7].function = &cancelBatch;
+    
+    func[8].name = (const uint8_t*) "openScannerAsync";
+    func[8].functionData = NULL;
+    func[8].function = &openScannerAsync;
+    
+    func[9].name = (const uint8_t*) "closeScanner";
+    func[9].functionData = NULL;
+    func[9].function = &closeScanner;
+    
+    func[10].name = (const uint8_t*) "syncScanner";
+    func[10].functionData = NULL;
+    func[10].function = &syncScanner;
+    
+    func[11].name = (const uint8_t*) "drainJobs";
+    func[11].functionData = NULL;
+    func[11].function = &drainJobs;
+    
+    func[12].name = (const uint8_t*) "bufferPoolStats";
+    func[12].functionData = NULL;
+    func[12].function = &bufferPoolStats;
+    
+    func[13].name = (const uint8_t*) "setBufferPoolCapacity";
+    func[13].functionData = NULL;
+    func[13].function = &setBufferPoolCapacity;
+    
+    func[14].name = (const uint8_t*) "prewarm";
+    func[14].functionData = NULL;
+    func[14].function = &prewarm;
+    
+    func[15].name = (const uint8_t*) "coldStartTimeline";
+    func[15].functionData = NULL;
+    func[15].function = &coldStartTimeline;
+    
+    func[16].name = (const uint8_t*) "setSyncPolicy";
+    func[16].functionData = NULL;
+    func[16].function = &setSyncPolicy;
+    
+    func[17].name = (const uint8_t*) "setSyncStatusInterval";
+    func[17].functionData = NULL;
+    func[17].function = &setSyncStatusInterval;
+    
+    func[18].name = (const uint8_t*) "syncStats";
+    func[18].functionData = NULL;
+    func[18].function = &syncStats;
+    
+    func[19].name = (const uint8_t*) "setScannerPoolLimits";
+    func[19].functionData = NULL;
+    func[19].function = &setScannerPoolLimits;
+    
+    func[20].name = (const uint8_t*) "scannerPoolStats";
+    func[20].functionData = NULL;
+    func[20].function = &scannerPoolStats;
+    
+    func[21].name = (const uint8_t*) "setSceneCache";
+    func[21].functionData = NULL;
+    func[21].function = &setSceneCache;
+    
+    func[22].name = (const uint8_t*) "sceneCacheStats";
+    func[22].functionData = NULL;
+    func[22].function = &sceneCacheStats;
+    
+    func[23].name = (const uint8_t*) "setFrameGovernor";
+    func[23].functionData = NULL;
+    func[23].function = &setFrameGovernor;
+    
+    func[24].name = (const uint8_t*) "frameGovernorStats";
+    func[24].functionData = NULL;
+    func[24].function = &frameGovernorStats;
+    
+    func[25].name = (const uint8_t*) "setFrameGate";
+    func[25].functionData = NULL;
+    func[25].function = &setFrameGate;
+    
+    func[26].name = (const uint8_t*) "frameGateStats";
+    func[26].functionData = NULL;
+    func[26].function = &frameGateStats;
+    
+    func[27].name = (const uint8_t*) "setCascadeOrder";
+    func[27].functionData = NULL;
+    func[27].function = &setCascadeOrder;
+    
+    func[28].name = (const uint8_t*) "cascadeStats";
+    func[28].functionData = NULL;
+    func[28].function = &cascadeStats;
+    
+    func[29].name = (const uint8_t*) "setRegionOfInterest";
+    func[29].functionData = NULL;
+    func[29].function = &setRegionOfInterest;
+    
+    func[30].name = (const uint8_t*) "regionOfInterestStats";
+    func[30].functionData = NULL;
+    func[30].function = &regionOfInterestStats;
+    
+    func[31].name = (const uint8_t*) "setParallelLanes";
+    func[31].functionData = NULL;
+    func[31].function = &setParallelLanes;
+    
+    func[32].name = (const uint8_t*) "setSearchEscalation";
+    func[32].functionData = NULL;
+    func[32].function = &setSearchEscalation;
+    
+    func[33].name = (const uint8_t*) "searchStats";
+    func[33].functionData = NULL;
+    func[33].function = &searchStats;
+    
+    func[34].name = (const uint8_t*) "setServerFallback";
+    func[34].functionData = NULL;
+    func[34].function = &setServerFallback;
+    
+    func[35].name = (const uint8_t*) "serverFallbackStats";
+    func[35].functionData = NULL;
+    func[35].function = &serverFallbackStats;
+    
+    func[36].name = (const uint8_t*) "setProxy";
+    func[36].functionData = NULL;
+    func[36].function = &setProxy;
+    
+    func[37].name = (const uint8_t*) "importBundle";
+    func[37].functionData = NULL;
+    func[37].function = &importBundle;
+
+    *functionsToSet = func;
+}
+
+extern "C" void MoodstocksExtContextFinalizer(FREContext ctx)
+{
+    NSLog(@"ExtConFinal Called");
+    void *nativeData = NULL;
+    FREGetContextNativeData(ctx, &nativeData);
+    if (nativeData == NULL)
+        return;
+    
+    UIViewExtension *ext = (__bridge_transfer UIViewExtension *) nativeData;
+    [ext dispose];
+    FRESetContextNativeData(ctx, NULL);
+}
+
+extern "C" void MoodstocksExtensionInitializer(void** extDataToSet, FREContextInitializer* ctxInitializerToSet, FREContextFinalizer* ctxFinalizerToSet)
+{
+    NSLog(@"ExtInit Called");
+    Timeline::coldStart().start();
+    Timeline::coldStart().mark("extension");
+    *extDataToSet = NULL;
+    *ctxInitializerToSet = &MoodstocksExtContextInitializer;
+    *ctxFinalizerToSet = &MoodstocksExtContextFinalizer;
+}
@@ -0,0 +1,338 @@
+//
+//  PixelConvert.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "PixelConvert.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MSANE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MSANE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace msane {
+
+// Converts `count` 32 bit pixels to luma. `w` holds the weights of bytes 0,
+// 1 and 2 of each pixel, byte 3 is ignored.
+typedef void (*LumaRowFunction)(const uint8_t *src, uint8_t *dst, int count, const uint8_t *w);
+
+static const uint8_t kWeightsBGRA[3] = { 15, 75, 38 };
+static const uint8_t kWeightsRGBA[3] = { 38, 75, 15 };
+
+// pixels converted per kernel call, small enough for a tile to stay in L1
+static const int kChunk = 128;
+static const int kTileRows = 16;
+
+//
+//  Row kernels
+//
+
+static void lumaRowScalar(const uint8_t *src, uint8_t *dst, int count, const uint8_t *w)
+{
+    for (int i = 0; i < count; i++, src += 4)
+        dst[i] = (uint8_t) ((w[0] * src[0] + w[1] * src[1] + w[2] * src[2] + 64) >> 7);
+}
+
+#if MSANE_X86
+
+// 16 pixels per iteration: pmaddubsw gives the two weighted pairs of every
+// pixel, phaddw adds them up
+__attribute__((target("sse4.1")))
+static void lumaRowSSE4(const uint8_t *src, uint8_t *dst, int count, const uint8_t *w)
+{
+    const __m128i weights = _mm_setr_epi8((char) w[0], (char) w[1], (char) w[2], 0,
+                                          (char) w[0], (char) w[1], (char) w[2], 0,
+                                          (char) w[0], (char) w[1], (char) w[2], 0,
+                                          (char) w[0], (char) w[1], (char) w[2], 0);
+    const __m128i round = _mm_set1_epi16(64);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i *in = reinterpret_cast<const __m128i *>(src + i * 4);
+        __m128i s0 = _mm_maddubs_epi16(_mm_loadu_si128(in), weights);
+        __m128i s1 = _mm_maddubs_epi16(_mm_loadu_si128(in + 1), weights);
+        __m128i s2 = _mm_maddubs_epi16(_mm_loadu_si128(in + 2), weights);
+        __m128i s3 = _mm_maddubs_epi16(_mm_loadu_si128(in + 3), weights);
+
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(s0, s1), round), 7);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(s2, s3), round), 7);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    lumaRowScalar(src + i * 4, dst + i, count - i, w);
+}
+
+// Same as SSE4 on 32 pixels. The in-lane hadd and pack leave groups of four
+// pixels interleaved across the two lanes, one permute puts them back.
+__attribute__((target("avx2")))
+static void lumaRowAVX2(const uint8_t *src, uint8_t *dst, int count, const uint8_t *w)
+{
+    const __m256i weights = _mm256_setr_epi8((char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0,
+                                             (char) w[0], (char) w[1], (char) w[2], 0);
+    const __m256i round = _mm256_set1_epi16(64);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i *in = reinterpret_cast<const __m256i *>(src + i * 4);
+        __m256i s0 = _mm256_maddubs_epi16(_mm256_loadu_si256(in), weights);
+        __m256i s1 = _mm256_maddubs_epi16(_mm256_loadu_si256(in + 1), weights);
+        __m256i s2 = _mm256_maddubs_epi16(_mm256_loadu_si256(in + 2), weights);
+        __m256i s3 = _mm256_maddubs_epi16(_mm256_loadu_si256(in + 3), weights);
+
+        __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(s0, s1), round), 7);
+        __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(s2, s3), round), 7);
+        __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    }
+    lumaRowScalar(src + i * 4, dst + i, count - i, w);
+}
+
+#endif
+
+#if MSANE_NEON
+
+// 16 pixels per iteration, vld4 deinterleaves the channels for free
+static void lumaRowNEON(const uint8_t *src, uint8_t *dst, int count, const uint8_t *w)
+{
+    const uint8x8_t w0 = vdup_n_u8(w[0]);
+    const uint8x8_t w1 = vdup_n_u8(w[1]);
+    const uint8x8_t w2 = vdup_n_u8(w[2]);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t px = vld4q_u8(src + i * 4);
+
+        uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), w0);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[1]), w1);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), w2);
+
+        uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), w0);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[1]), w1);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), w2);
+
+        vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 7), vrshrn_n_u16(hi, 7)));
+    }
+    lumaRowScalar(src + i * 4, dst + i, count - i, w);
+}
+
+#endif
+
+//
+//  Kernel selection
+//
+
+static bool kernelSupported(ConvertKernel kernel)
+{
+    switch (kernel) {
+        case ConvertKernelScalar:
+            return true;
+#if MSANE_X86
+        case ConvertKernelSSE4:
+            return __builtin_cpu_supports("sse4.1");
+        case ConvertKernelAVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if MSANE_NEON
+        case ConvertKernelNEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+static LumaRowFunction kernelFunction(ConvertKernel kernel)
+{
+    switch (kernel) {
+#if MSANE_X86
+        case ConvertKernelSSE4:
+            return &lumaRowSSE4;
+        case ConvertKernelAVX2:
+            return &lumaRowAVX2;
+#endif
+#if MSANE_NEON
+        case ConvertKernelNEON:
+            return &lumaRowNEON;
+#endif
+        default:
+            return &lumaRowScalar;
+    }
+}
+
+static ConvertKernel bestKernel()
+{
+    static const ConvertKernel preferred[] = {
+        ConvertKernelAVX2, ConvertKernelSSE4, ConvertKernelNEON
+    };
+    for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++) {
+        if (kernelSupported(preferred[i]))
+            return preferred[i];
+    }
+    return ConvertKernelScalar;
+}
+
+static std::atomic<int> &currentKernel()
+{
+    static std::atomic<int> kernel(bestKernel());
+    return kernel;
+}
+
+ConvertKernel activeKernel()
+{
+    return static_cast<ConvertKernel>(currentKernel().load());
+}
+
+bool selectKernel(ConvertKernel kernel)
+{
+    if (!kernelSupported(kernel))
+        return false;
+    currentKernel().store(kernel);
+    return true;
+}
+
+const char *kernelName(ConvertKernel kernel)
+{
+    switch (kernel) {
+        case ConvertKernelSSE4: return "sse4";
+        case ConvertKernelAVX2: return "avx2";
+        case ConvertKernelNEON: return "neon";
+        default:                return "scalar";
+    }
+}
+
+//
+//  Conversion
+//
+
+Rotation rotationForVideoOrientation(int orientation)
+{
+    switch (orientation) {
+        case VideoOrientationPortrait:           return Rotation90;
+        case VideoOrientationPortraitUpsideDown: return Rotation270;
+        case VideoOrientationLandscapeLeft:      return Rotation180;
+        default:                                 return Rotation0;
+    }
+}
+
+// Luma of translucent premultiplied pixels is scaled back up by alpha
+static void unpremultiplyRow(const uint8_t *src, uint8_t *luma, int count)
+{
+    for (int i = 0; i < count; i++) {
+        uint32_t alpha = src[i * 4 + 3];
+        if (alpha != 0 && alpha != 255) {
+            uint32_t value = (luma[i] * 255 + alpha / 2) / alpha;
+            luma[i] = (uint8_t) (value > 255 ? 255 : value);
+        }
+    }
+}
+
+bool convertToGray(const ColorView &src, const CropRect &crop, Rotation rotation,
+                   const GrayView &dst)
+{
+    if (crop.width <= 0 || crop.height <= 0 || crop.x < 0 || crop.y < 0 ||
+        crop.x + crop.width > src.width || crop.y + crop.height > src.height)
+        return false;
+
+    bool swapped = rotation == Rotation90 || rotation == Rotation270;
+    int outWidth = swapped ? crop.height : crop.width;
+    int outHeight = swapped ? crop.width : crop.height;
+    if (dst.width < outWidth || dst.height < outHeight)
+        return false;
+
+    LumaRowFunction lumaRow = kernelFunction(activeKernel());
+    const uint8_t *weights = src.layout == PixelLayoutBGRA ? kWeightsBGRA : kWeightsRGBA;
+
+    uint8_t tile[kTileRows][kChunk];
+
+    for (int y0 = 0; y0 < crop.height; y0 += kTileRows) {
+        int rows = crop.height - y0 < kTileRows ? crop.height - y0 : kTileRows;
+
+        for (int x0 = 0; x0 < crop.width; x0 += kChunk) {
+            int count = crop.width - x0 < kChunk ? crop.width - x0 : kChunk;
+
+            for (int r = 0; r < rows; r++) {
+                int y = crop.y + y0 + r;
+                int row = src.invertedY ? src.height - 1 - y : y;
+                const uint8_t *in = src.pixels + (size_t) row * src.stride + (size_t) (crop.x + x0) * 4;
+
+                // the unrotated case converts straight into the destination
+                uint8_t *out = rotation == Rotation0
+                    ? dst.pixels + (size_t) (y0 + r) * dst.stride + x0
+                    : tile[r];
+                lumaRow(in, out, count, weights);
+                if (src.premultiplied)
+                    unpremultiplyRow(in, out, count);
+            }
+
+            switch (rotation) {
+                case Rotation0:
+                    break;
+
+                case Rotation180:
+                    for (int r = 0; r < rows; r++) {
+                        uint8_t *out = dst.pixels + (size_t) (outHeight - 1 - y0 - r) * dst.stride
+                                     + (outWidth - 1 - x0);
+                        for (int c = 0; c < count; c++)
+                            out[-c] = tile[r][c];
+                    }
+                    break;
+
+                case Rotation90:
+                    // source column x becomes destination row x, read bottom up
+                    for (int c = 0; c < count; c++) {
+                        uint8_t *out = dst.pixels + (size_t) (x0 + c) * dst.stride
+                                     + (outWidth - y0 - rows);
+                        for (int r = 0; r < rows; r++)
+                            out[rows - 1 - r] = tile[r][c];
+                    }
+                    break;
+
+                case Rotation270:
+                    for (int c = 0; c < count; c++) {
+                        uint8_t *out = dst.pixels + (size_t) (outHeight - 1 - x0 - c) * dst.stride + y0;
+                        for (int r = 0; r < rows; r++)
+                            out[r] = tile[r][c];
+                    }
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+void convertBitmapToGray(const BitmapView &src, const GrayView &dst)
+{
+    CropRect all = { 0, 0, src.width, src.height };
+    convertBitmapToGray(src, all, dst);
+}
+
+bool convertBitmapToGray(const BitmapView &src, const CropRect &crop, const GrayView &dst)
+{
+    ColorView view;
+    view.pixels = reinterpret_cast<const uint8_t *>(src.bits);
+    view.width = src.width;
+    view.height = src.height;
+    view.stride = src.lineStride32 * 4;
+    view.layout = PixelLayoutBGRA;
+    view.invertedY = src.invertedY;
+    view.premultiplied = src.premultiplied && src.hasAlpha;
+
+    return convertToGray(view, crop, Rotation0, dst);
+}
+
+} // namespace msane
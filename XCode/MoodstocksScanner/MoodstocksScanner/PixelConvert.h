@@ -0,0 +1,139 @@
+//
+//  PixelConvert.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_PixelConvert_h
+#define MoodstocksScanner_PixelConvert_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace msane {
+
+// Byte order of 32 bit source pixels in memory. Camera frames
+// (kCVPixelFormatType_32BGRA) and FREBitmapData2 (ARGB32 in host
+// endianness on ARM and x86) are both BGRA.
+enum PixelLayout {
+    PixelLayoutBGRA,
+    PixelLayoutRGBA
+};
+
+// Clockwise rotation applied while converting
+enum Rotation {
+    Rotation0   = 0,
+    Rotation90  = 1,
+    Rotation180 = 2,
+    Rotation270 = 3
+};
+
+// Values of AVCaptureVideoOrientation, mirrored so this file stays free of
+// AVFoundation
+enum VideoOrientation {
+    VideoOrientationPortrait           = 1,
+    VideoOrientationPortraitUpsideDown = 2,
+    VideoOrientationLandscapeRight     = 3,
+    VideoOrientationLandscapeLeft      = 4
+};
+
+enum ConvertKernel {
+    ConvertKernelScalar,
+    ConvertKernelSSE4,
+    ConvertKernelAVX2,
+    ConvertKernelNEON
+};
+
+// 32 bit pixels as FREBitmapData2 hands them over: ARGB32 in host
+// endianness, i.e. B, G, R, A bytes in memory on ARM and x86.
+struct BitmapView {
+    const uint32_t *bits;
+    int width;
+    int height;
+    int lineStride32;    // row pitch in pixels
+    bool invertedY;      // last row first, as Stage3D backed bitmaps are
+    bool premultiplied;
+    bool hasAlpha;
+};
+
+// Any 32 bit source: a locked CVPixelBuffer, a BitmapData, a CGBitmapContext
+struct ColorView {
+    const uint8_t *pixels;
+    int width;
+    int height;
+    int stride;          // row pitch in bytes
+    PixelLayout layout;
+    bool invertedY;
+    bool premultiplied;  // only honoured for translucent pixels
+};
+
+struct GrayView {
+    uint8_t *pixels;
+    int width;
+    int height;
+    int stride;          // row pitch in bytes
+};
+
+struct CropRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// BT.601 luma with 7 bit weights summing to 128. Every kernel produces
+// exactly this value, the weights fit the signed byte multiplies of SSSE3.
+static inline uint8_t lumaOf(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (uint8_t) ((38 * r + 75 * g + 15 * b + 64) >> 7);
+}
+
+// Rotation that makes a camera frame delivered in the sensor's native
+// landscape right orientation upright for `orientation`
+Rotation rotationForVideoOrientation(int orientation);
+
+// Converts `crop` of `src` to luma and rotates it into `dst` in a single
+// pass. `dst` must hold crop.width x crop.height pixels, swapped for 90 and
+// 270 degrees. Returns false if the crop or destination is out of bounds.
+bool convertToGray(const ColorView &src, const CropRect &crop, Rotation rotation,
+                   const GrayView &dst);
+
+// Writes the upright grayscale version of `src` into `dst`, which must be at
+// least as large. Premultiplied translucent pixels are unpremultiplied so a
+// faded logo keeps its contrast.
+void convertBitmapToGray(const BitmapView &src, const GrayView &dst);
+
+// Same for `crop` of `src` only, in upright coordinates. Returns false if
+// the crop or destination is out of bounds.
+bool convertBitmapToGray(const BitmapView &src, const CropRect &crop, const GrayView &dst);
+
+// Row kernel picked at first use from what the CPU supports. selectKernel()
+// forces another one for comparisons and fails if the CPU lacks it.
+ConvertKernel activeKernel();
+bool selectKernel(ConvertKernel kernel);
+const char *kernelName(ConvertKernel kernel);
+
+} // namespace msane
+
+#endif
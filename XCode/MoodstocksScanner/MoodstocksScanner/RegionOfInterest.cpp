@@ -0,0 +1,109 @@
+//
+//  RegionOfInterest.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "RegionOfInterest.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace msane {
+
+static int clampInt(int value, int low, int high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+CropRect cropOf(const RoiRect &rect, int width, int height)
+{
+    CropRect crop;
+    crop.x = clampInt((int) floor(rect.x * width + 0.5), 0, width - 1);
+    crop.y = clampInt((int) floor(rect.y * height + 0.5), 0, height - 1);
+    int right = clampInt((int) floor((rect.x + rect.width) * width + 0.5), crop.x + 1, width);
+    int bottom = clampInt((int) floor((rect.y + rect.height) * height + 0.5), crop.y + 1, height);
+    crop.width = right - crop.x;
+    crop.height = bottom - crop.y;
+    return crop;
+}
+
+void mapToFrame(const RoiRect &region, float *points, int count)
+{
+    for (int i = 0; i < count; i++) {
+        float &x = points[i * 2];
+        float &y = points[i * 2 + 1];
+        x = (float) (2 * (region.x + (x + 1) * 0.5 * region.width) - 1);
+        y = (float) (2 * (region.y + (y + 1) * 0.5 * region.height) - 1);
+    }
+}
+
+RegionOfInterest::RegionOfInterest(const RoiPolicy &policy)
+    : _policy(policy), _misses(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void RegionOfInterest::setPolicy(const RoiPolicy &policy)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _policy = policy;
+    _misses = 0;
+}
+
+RoiPolicy RegionOfInterest::policy() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _policy;
+}
+
+bool RegionOfInterest::next(int width, int height, CropRect *crop, bool *fallback)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    CropRect all = { 0, 0, width, height };
+    *crop = all;
+    if (fallback != NULL)
+        *fallback = false;
+    _stats.frames++;
+    _stats.framePixels += (uint64_t) width * height;
+
+    if (_policy.enabled) {
+        if (_policy.fallbackMisses > 0 && _misses >= _policy.fallbackMisses) {
+            // frames already in flight may still miss, start counting anew
+            _misses = 0;
+            _stats.fallbacks++;
+            if (fallback != NULL)
+                *fallback = true;
+        } else {
+            *crop = cropOf(_policy.rect, width, height);
+        }
+    }
+
+    bool cropped = crop->width < width || crop->height < height;
+    if (cropped)
+        _stats.cropped++;
+    _stats.pixels += (uint64_t) crop->width * crop->height;
+    return cropped;
+}
+
+void RegionOfInterest::scanned(bool cropped, bool matched)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (matched)
+        _misses = 0;
+    else if (cropped)
+        _misses++;
+    if (!cropped && matched && _policy.enabled)
+        _stats.fallbackHits++;
+}
+
+RoiStats RegionOfInterest::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+} // namespace msane
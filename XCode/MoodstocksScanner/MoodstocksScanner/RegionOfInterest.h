@@ -0,0 +1,112 @@
+//
+//  RegionOfInterest.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_RegionOfInterest_h
+#define MoodstocksScanner_RegionOfInterest_h
+
+#include <stdint.h>
+
+#include <mutex>
+
+#include "PixelConvert.h"
+
+namespace msane {
+
+// Part of a frame, normalized to its size (0-1, top left origin)
+struct RoiRect {
+    double x;
+    double y;
+    double width;
+    double height;
+};
+
+struct RoiPolicy {
+    bool enabled;
+    RoiRect rect;
+    int fallbackMisses;         // region misses in a row before a full frame is scanned, 0 never
+
+    RoiPolicy()
+        : enabled(true), fallbackMisses(5)
+    {
+        // centre viewfinder
+        rect.x = rect.y = 0.2;
+        rect.width = rect.height = 0.6;
+    }
+};
+
+struct RoiStats {
+    uint64_t frames;
+    uint64_t cropped;
+    uint64_t fallbacks;         // full frames scanned after region misses
+    uint64_t fallbackHits;      // of those, the ones that matched
+    uint64_t pixels;            // pixels converted
+    uint64_t framePixels;       // pixels the full frames had
+};
+
+// Pixels of `rect` in a width x height frame, clamped to the frame and at
+// least one pixel wide and high
+CropRect cropOf(const RoiRect &rect, int width, int height);
+
+// Maps `count` points from the [-1, 1] range of a query cropped to
+// `region` back to the [-1, 1] range of the whole frame
+void mapToFrame(const RoiRect &region, float *points, int count);
+
+// Decides which part of each bitmap frame is converted and searched. Users
+// aim at the centre of the preview, so most frames only need the region;
+// after a number of misses in a row one full frame is scanned in case the
+// item sits elsewhere. Frames are cropped on the caller's thread and their
+// outcome comes back from the scan queue, hence the lock.
+class RegionOfInterest {
+public:
+    explicit RegionOfInterest(const RoiPolicy &policy = RoiPolicy());
+
+    void setPolicy(const RoiPolicy &policy);
+    RoiPolicy policy() const;
+
+    // Sets `crop` to the part of the next width x height frame to scan and
+    // returns true if that is less than the whole frame. `fallback` is set
+    // for a full frame scanned after region misses.
+    bool next(int width, int height, CropRect *crop, bool *fallback = NULL);
+
+    // Outcome of a frame that was searched
+    void scanned(bool cropped, bool matched);
+
+    RoiStats stats() const;
+
+private:
+    RegionOfInterest(const RegionOfInterest &);
+    RegionOfInterest &operator=(const RegionOfInterest &);
+
+    RoiPolicy _policy;
+    int _misses;
+    RoiStats _stats;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,243 @@
+//
+//  Resample.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "Resample.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace msane {
+
+void querySizeFor(int width, int height, ScanTarget target, int *queryWidth, int *queryHeight)
+{
+    int longest = width > height ? width : height;
+    int wanted = kQueryMinLongestSide;
+    if (target == ScanTargetBarcode)
+        wanted = longest < kQueryMinLongestSide ? kQueryMinLongestSide
+               : longest > kQueryMaxSide ? kQueryMaxSide : longest;
+
+    if (longest == wanted) {
+        *queryWidth = width;
+        *queryHeight = height;
+        return;
+    }
+
+    double scale = (double) wanted / longest;
+    *queryWidth = width >= height ? wanted : (int) floor(width * scale + 0.5);
+    *queryHeight = height > width ? wanted : (int) floor(height * scale + 0.5);
+    if (*queryWidth < 1) *queryWidth = 1;
+    if (*queryHeight < 1) *queryHeight = 1;
+}
+
+// Exact 2x2 box average, odd trailing columns and rows are dropped
+static void halve(const GrayView &src, const GrayView &dst)
+{
+    for (int y = 0; y < dst.height; y++) {
+        const uint8_t *a = src.pixels + (size_t) (2 * y) * src.stride;
+        const uint8_t *b = a + src.stride;
+        uint8_t *out = dst.pixels + (size_t) y * dst.stride;
+
+        int x = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; x + 16 <= dst.width; x += 16) {
+            uint16x8_t lo = vpadalq_u8(vpaddlq_u8(vld1q_u8(a + 2 * x)), vld1q_u8(b + 2 * x));
+            uint16x8_t hi = vpadalq_u8(vpaddlq_u8(vld1q_u8(a + 2 * x + 16)), vld1q_u8(b + 2 * x + 16));
+            vst1q_u8(out + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+        }
+#elif defined(__SSE2__)
+        const __m128i low = _mm_set1_epi16(0xff);
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 16 <= dst.width; x += 16) {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 2 * x));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 2 * x + 16));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 2 * x));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 2 * x + 16));
+
+            __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a0, low), _mm_srli_epi16(a0, 8)),
+                                       _mm_add_epi16(_mm_and_si128(b0, low), _mm_srli_epi16(b0, 8)));
+            __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a1, low), _mm_srli_epi16(a1, 8)),
+                                       _mm_add_epi16(_mm_and_si128(b1, low), _mm_srli_epi16(b1, 8)));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x < dst.width; x++)
+            out[x] = (uint8_t) ((a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1] + 2) >> 2);
+    }
+}
+
+Resampler::Resampler()
+    : _xTaps(0), _spanSrcWidth(0), _spanDstWidth(0), _spanSrcHeight(0), _spanDstHeight(0)
+{
+}
+
+size_t Resampler::scratchBytes() const
+{
+    return _levels[0].capacity() + _levels[1].capacity()
+         + (_xSpans.capacity() + _ySpans.capacity()) * sizeof(Span)
+         + (_xWeights.capacity() + _yWeights.capacity() + _row.capacity()) * sizeof(uint16_t);
+}
+
+bool Resampler::resample(const GrayView &src, const GrayView &dst)
+{
+    if (src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0)
+        return false;
+
+    if (dst.width > src.width || dst.height > src.height) {
+        upscale(src, dst);
+        return true;
+    }
+
+    GrayView current = src;
+    int level = 0;
+    while (current.width >= 2 * dst.width && current.height >= 2 * dst.height) {
+        GrayView half = { NULL, current.width / 2, current.height / 2, current.width / 2 };
+        std::vector<uint8_t> &plane = _levels[level];
+        if (plane.size() < (size_t) half.stride * half.height)
+            plane.resize((size_t) half.stride * half.height);
+        half.pixels = &plane[0];
+
+        halve(current, half);
+        current = half;
+        level ^= 1;
+    }
+
+    if (current.width == dst.width && current.height == dst.height) {
+        for (int y = 0; y < dst.height; y++)
+            memcpy(dst.pixels + (size_t) y * dst.stride, current.pixels + (size_t) y * current.stride, dst.width);
+        return true;
+    }
+
+    areaAverage(current, dst);
+    return true;
+}
+
+// Coverage of every source pixel by each destination pixel, in 1/256th
+// that add up to exactly 256 per destination pixel. Every span is padded
+// with zero weights to the same tap count so the filter loops have a fixed
+// trip count. Returns that tap count.
+int Resampler::buildSpans(int srcSize, int dstSize, std::vector<Span> &spans, std::vector<uint16_t> &weights)
+{
+    double scale = (double) srcSize / dstSize;
+    int taps = (int) ceil(scale) + 1;
+    spans.resize(dstSize);
+    weights.assign((size_t) dstSize * taps, 0);
+
+    for (int d = 0; d < dstSize; d++) {
+        double start = d * scale;
+        double end = (d + 1) * scale;
+        int first = (int) floor(start);
+        int last = (int) ceil(end) - 1;
+        if (last >= srcSize) last = srcSize - 1;
+
+        Span &span = spans[d];
+        span.first = first;
+        span.count = last - first + 1;
+        span.weights = d * taps;
+
+        double cumulative = 0;
+        int assigned = 0;
+        for (int i = first; i <= last; i++) {
+            double covered = (i + 1 < end ? i + 1 : end) - (i > start ? i : start);
+            cumulative += covered / scale;
+            int total = i == last ? 256 : (int) floor(cumulative * 256 + 0.5);
+            weights[span.weights + i - first] = (uint16_t) (total - assigned);
+            assigned = total;
+        }
+    }
+    return taps;
+}
+
+void Resampler::areaAverage(const GrayView &src, const GrayView &dst)
+{
+    if (_spanSrcWidth != src.width || _spanDstWidth != dst.width) {
+        _xTaps = buildSpans(src.width, dst.width, _xSpans, _xWeights);
+        _spanSrcWidth = src.width;
+        _spanDstWidth = dst.width;
+    }
+    if (_spanSrcHeight != src.height || _spanDstHeight != dst.height) {
+        buildSpans(src.height, dst.height, _ySpans, _yWeights);
+        _spanSrcHeight = src.height;
+        _spanDstHeight = dst.height;
+    }
+    // zero padding lets the last spans read their unused taps safely
+    if (_row.size() < (size_t) src.width + _xTaps) _row.resize(src.width + _xTaps);
+
+    // vertical first: one weight per source row keeps the inner loop
+    // uniform so the compiler vectorizes it, and the irregular horizontal
+    // spans only run once per destination row
+    for (int y = 0; y < dst.height; y++) {
+        const Span &ySpan = _ySpans[y];
+        uint16_t *row = &_row[0];
+
+        for (int j = 0; j < ySpan.count; j++) {
+            const uint8_t *in = src.pixels + (size_t) (ySpan.first + j) * src.stride;
+            uint16_t weight = _yWeights[ySpan.weights + j];
+            if (j == 0) {
+                for (int x = 0; x < src.width; x++)
+                    row[x] = (uint16_t) (weight * in[x]);
+            } else {
+                for (int x = 0; x < src.width; x++)
+                    row[x] = (uint16_t) (row[x] + weight * in[x]);
+            }
+        }
+
+        uint8_t *out = dst.pixels + (size_t) y * dst.stride;
+        const uint16_t *w = &_xWeights[0];
+        if (_xTaps == 3) {
+            // every ratio below 2, i.e. anything left after halving
+            for (int x = 0; x < dst.width; x++, w += 3) {
+                const uint16_t *p = row + _xSpans[x].first;
+                uint32_t sum = (uint32_t) w[0] * p[0] + (uint32_t) w[1] * p[1] + (uint32_t) w[2] * p[2];
+                out[x] = (uint8_t) ((sum + 32768) >> 16);
+            }
+        } else {
+            for (int x = 0; x < dst.width; x++, w += _xTaps) {
+                const uint16_t *p = row + _xSpans[x].first;
+                uint32_t sum = 0;
+                for (int i = 0; i < _xTaps; i++)
+                    sum += (uint32_t) w[i] * p[i];
+                out[x] = (uint8_t) ((sum + 32768) >> 16);
+            }
+        }
+    }
+}
+
+void Resampler::upscale(const GrayView &src, const GrayView &dst)
+{
+    for (int y = 0; y < dst.height; y++) {
+        int fy = dst.height > 1 ? (int) ((int64_t) y * (src.height - 1) * 256 / (dst.height - 1)) : 0;
+        int y0 = fy >> 8;
+        int y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+        int wy = fy & 0xff;
+        const uint8_t *a = src.pixels + (size_t) y0 * src.stride;
+        const uint8_t *b = src.pixels + (size_t) y1 * src.stride;
+        uint8_t *out = dst.pixels + (size_t) y * dst.stride;
+
+        for (int x = 0; x < dst.width; x++) {
+            int fx = dst.width > 1 ? (int) ((int64_t) x * (src.width - 1) * 256 / (dst.width - 1)) : 0;
+            int x0 = fx >> 8;
+            int x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+            int wx = fx & 0xff;
+
+            int top = a[x0] * (256 - wx) + a[x1] * wx;
+            int bottom = b[x0] * (256 - wx) + b[x1] * wx;
+            out[x] = (uint8_t) ((top * (256 - wy) + bottom * wy + 32768) >> 16);
+        }
+    }
+}
+
+} // namespace msane
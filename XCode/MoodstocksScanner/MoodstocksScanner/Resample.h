@@ -0,0 +1,91 @@
+//
+//  Resample.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_Resample_h
+#define MoodstocksScanner_Resample_h
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "PixelConvert.h"
+
+namespace msane {
+
+// MSImage rejects inputs whose longest side is under 480 pixels or that do
+// not fit in 1280x1280 (MSErrorImg)
+static const int kQueryMinLongestSide = 480;
+static const int kQueryMaxSide = 1280;
+
+enum ScanTarget {
+    ScanTargetImage,     // image matching is happy at the minimum size
+    ScanTargetBarcode    // barcodes keep as much resolution as allowed
+};
+
+// Cheapest size MSImage accepts for a `width` x `height` input, keeping the
+// aspect ratio
+void querySizeFor(int width, int height, ScanTarget target, int *queryWidth, int *queryHeight);
+
+// Area averaging resampler. Large ratios are first halved with an exact 2x2
+// box filter (NEON/SSE2), the remaining ratio below 2 is averaged with
+// fixed point coverage weights. Weight tables and intermediate planes are
+// kept between calls, so frames of a steady size never allocate.
+// Inputs smaller than the destination are bilinearly upscaled.
+class Resampler {
+public:
+    Resampler();
+
+    bool resample(const GrayView &src, const GrayView &dst);
+
+    // bytes currently held in scratch buffers
+    size_t scratchBytes() const;
+
+private:
+    Resampler(const Resampler &);
+    Resampler &operator=(const Resampler &);
+
+    struct Span {
+        int first;
+        int count;
+        int weights;   // offset into the weight table
+    };
+
+    int buildSpans(int srcSize, int dstSize, std::vector<Span> &spans, std::vector<uint16_t> &weights);
+    void areaAverage(const GrayView &src, const GrayView &dst);
+    void upscale(const GrayView &src, const GrayView &dst);
+
+    std::vector<uint8_t> _levels[2];
+    std::vector<Span> _xSpans, _ySpans;
+    std::vector<uint16_t> _xWeights, _yWeights;
+    std::vector<uint16_t> _row;
+    int _xTaps;
+    int _spanSrcWidth, _spanDstWidth, _spanSrcHeight, _spanDstHeight;
+};
+
+} // namespace msane
+
+#endif
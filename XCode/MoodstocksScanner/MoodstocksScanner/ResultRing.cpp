@@ -0,0 +1,154 @@
+//
+//  ResultRing.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "ResultRing.h"
+
+#include <string.h>
+
+namespace msane {
+
+static_assert(sizeof(ResultHeader) == kResultHeaderSize, "packed result header layout changed");
+
+ResultRing::ResultRing(size_t capacity)
+    : _buffer(capacity), _head(0), _used(0), _count(0), _dropped(0), _notifyPending(false)
+{
+}
+
+size_t ResultRing::recordSize(const ResultHeader &header)
+{
+    size_t size = kResultHeaderSize + header.idLength;
+    if (header.flags & ResultFlagCorners)
+        size += kResultCornersSize;
+    return size;
+}
+
+bool ResultRing::push(const ResultHeader &header, const float *corners,
+                      const uint8_t *idBytes)
+{
+    ResultHeader stored = header;
+    if (corners == NULL)
+        stored.flags &= ~ResultFlagCorners;
+
+    size_t size = recordSize(stored);
+
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (size > _buffer.size()) {
+        // can never fit, count it as lost rather than wiping the ring
+        _dropped++;
+        return false;
+    }
+
+    while (_buffer.size() - _used < size)
+        dropOldest();
+
+    write(&stored, kResultHeaderSize);
+    if (stored.flags & ResultFlagCorners)
+        write(corners, kResultCornersSize);
+    write(idBytes, stored.idLength);
+    _count++;
+
+    bool notify = !_notifyPending;
+    _notifyPending = true;
+    return notify;
+}
+
+size_t ResultRing::drain(uint8_t *dst, size_t dstCapacity, bool *hasMore)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    size_t written = 0;
+    while (_count > 0) {
+        ResultHeader header;
+        peek(0, &header, kResultHeaderSize);
+        size_t size = recordSize(header);
+        if (written + size > dstCapacity)
+            break;
+
+        peek(0, dst + written, size);
+        written += size;
+        _head = (_head + size) % _buffer.size();
+        _used -= size;
+        _count--;
+    }
+
+    _notifyPending = _count > 0;
+    if (hasMore)
+        *hasMore = _notifyPending;
+    return written;
+}
+
+size_t ResultRing::pendingBytes() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _used;
+}
+
+size_t ResultRing::pendingCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _count;
+}
+
+uint32_t ResultRing::droppedCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _dropped;
+}
+
+void ResultRing::clear()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _head = 0;
+    _used = 0;
+    _count = 0;
+    _notifyPending = false;
+}
+
+//
+//  Private, called with _lock held
+//
+
+void ResultRing::write(const void *src, size_t length)
+{
+    if (length == 0)
+        return;
+
+    size_t capacity = _buffer.size();
+    size_t tail = (_head + _used) % capacity;
+    size_t first = capacity - tail < length ? capacity - tail : length;
+
+    memcpy(&_buffer[tail], src, first);
+    if (first < length)
+        memcpy(&_buffer[0], static_cast<const uint8_t *>(src) + first, length - first);
+    _used += length;
+}
+
+void ResultRing::peek(size_t offset, void *dst, size_t length) const
+{
+    size_t capacity = _buffer.size();
+    size_t start = (_head + offset) % capacity;
+    size_t first = capacity - start < length ? capacity - start : length;
+
+    memcpy(dst, &_buffer[start], first);
+    if (first < length)
+        memcpy(static_cast<uint8_t *>(dst) + first, &_buffer[0], length - first);
+}
+
+void ResultRing::dropOldest()
+{
+    ResultHeader header;
+    peek(0, &header, kResultHeaderSize);
+    size_t size = recordSize(header);
+
+    _head = (_head + size) % _buffer.size();
+    _used -= size;
+    _count--;
+    _dropped++;
+}
+
+} // namespace msane
@@ -0,0 +1,116 @@
+//
+//  ResultRing.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_ResultRing_h
+#define MoodstocksScanner_ResultRing_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+namespace msane {
+
+// Where a result came from on the native side.
+enum ResultSource {
+    ResultSourceCamera  = 0,
+    ResultSourceBitmap  = 1,
+    ResultSourceEncoded = 2,
+    ResultSourceBatch   = 3
+};
+
+enum ResultFlags {
+    ResultFlagCorners = 1 << 0,
+    ResultFlagSkipped = 1 << 1,     // frame dropped by the governor, not scanned
+    ResultFlagBlurred = 1 << 2,     // too blurred or moving to match, not searched
+    ResultFlagTimeout = 1 << 3,     // missed on the device, no server answer by the deadline
+    ResultFlagError   = 1 << 4      // input could not be read or decoded, not scanned
+};
+
+// Fixed part of every packed record, stored little endian exactly as laid
+// out here and followed by 8 floats of corners (if ResultFlagCorners) and
+// then `idLength` raw id bytes. MoodstocksScanner.as reads the same layout.
+struct ResultHeader {
+    uint32_t type;      // MSResultType
+    uint8_t  origin;    // MSResultOrigin
+    uint8_t  source;    // ResultSource
+    uint8_t  flags;     // ResultFlags
+    uint8_t  reserved;
+    uint32_t tag;       // caller supplied, e.g. a job id or batch index
+    uint32_t idLength;
+    double   timestamp; // capture time, seconds
+};
+
+static const size_t kResultHeaderSize = 24;
+static const size_t kResultCornersSize = 8 * sizeof(float);
+
+// Fixed capacity byte ring holding packed scan results until ActionScript
+// drains them. Producers may run on any thread; push() and drain() never
+// allocate once the ring is constructed. When the ring is full the oldest
+// records are dropped, since the latest match is what the app cares about.
+class ResultRing {
+public:
+    explicit ResultRing(size_t capacity = 64 * 1024);
+
+    // Appends one record. Returns true if the consumer has to be notified,
+    // i.e. no notification is outstanding since the last drain.
+    bool push(const ResultHeader &header, const float *corners,
+              const uint8_t *idBytes);
+
+    // Copies as many whole records as fit into `dst`, oldest first, and
+    // returns the number of bytes written. `hasMore` is set when records are
+    // left behind, in which case the notification stays outstanding.
+    size_t drain(uint8_t *dst, size_t dstCapacity, bool *hasMore);
+
+    size_t pendingBytes() const;
+    size_t pendingCount() const;
+    uint32_t droppedCount() const;
+    void clear();
+
+    static size_t recordSize(const ResultHeader &header);
+
+private:
+    ResultRing(const ResultRing &);
+    ResultRing &operator=(const ResultRing &);
+
+    void write(const void *src, size_t length);
+    void peek(size_t offset, void *dst, size_t length) const;
+    void dropOldest();
+
+    std::vector<uint8_t> _buffer;
+    size_t _head;           // read position
+    size_t _used;
+    size_t _count;
+    uint32_t _dropped;
+    bool _notifyPending;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,127 @@
+//
+//  ScannerPool.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "ScannerPool.h"
+
+namespace msane {
+
+ScannerPool::ScannerPool(size_t maxScanners, uint64_t maxBytes)
+    : _maxScanners(maxScanners > 0 ? maxScanners : 1), _maxBytes(maxBytes),
+      _open(0), _bytes(0), _hits(0), _misses(0), _evictions(0)
+{
+}
+
+void ScannerPool::setLimits(size_t maxScanners, uint64_t maxBytes)
+{
+    _maxScanners = maxScanners > 0 ? maxScanners : 1;
+    _maxBytes = maxBytes;
+}
+
+bool ScannerPool::touch(const std::string &key)
+{
+    Iterator it = find(key);
+    if (it == _entries.end()) {
+        _misses++;
+        return false;
+    }
+
+    _entries.splice(_entries.begin(), _entries, it);
+    _hits++;
+    return true;
+}
+
+void ScannerPool::insert(const std::string &key, uint64_t bytes)
+{
+    remove(key);
+
+    Entry entry;
+    entry.key = key;
+    entry.bytes = bytes;
+    entry.busy = false;
+    _entries.push_front(entry);
+    _open = _entries.size();
+    _bytes += bytes;
+}
+
+void ScannerPool::setBytes(const std::string &key, uint64_t bytes)
+{
+    Iterator it = find(key);
+    if (it == _entries.end())
+        return;
+    _bytes = _bytes - it->bytes + bytes;
+    it->bytes = bytes;
+}
+
+void ScannerPool::setBusy(const std::string &key, bool busy)
+{
+    Iterator it = find(key);
+    if (it != _entries.end())
+        it->busy = busy;
+}
+
+bool ScannerPool::remove(const std::string &key)
+{
+    Iterator it = find(key);
+    if (it == _entries.end())
+        return false;
+    _bytes -= it->bytes;
+    _entries.erase(it);
+    _open = _entries.size();
+    return true;
+}
+
+void ScannerPool::evict(std::vector<std::string> *evicted)
+{
+    if (_entries.empty())
+        return;
+
+    // oldest first, stopping short of the front entry
+    Iterator it = _entries.end();
+    --it;
+    while (it != _entries.begin() &&
+           (_entries.size() > _maxScanners || _bytes > _maxBytes)) {
+        Iterator victim = it--;
+        if (victim->busy)
+            continue;
+
+        evicted->push_back(victim->key);
+        _bytes -= victim->bytes;
+        _entries.erase(victim);
+        _evictions++;
+    }
+    _open = _entries.size();
+}
+
+bool ScannerPool::contains(const std::string &key) const
+{
+    for (std::list<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+        if (it->key == key)
+            return true;
+    return false;
+}
+
+ScannerPoolStats ScannerPool::stats() const
+{
+    ScannerPoolStats stats;
+    stats.open = _open;
+    stats.bytes = _bytes;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+    return stats;
+}
+
+// a few entries at most, a linear search beats maintaining an index
+ScannerPool::Iterator ScannerPool::find(const std::string &key)
+{
+    for (Iterator it = _entries.begin(); it != _entries.end(); ++it)
+        if (it->key == key)
+            return it;
+    return _entries.end();
+}
+
+} // namespace msane
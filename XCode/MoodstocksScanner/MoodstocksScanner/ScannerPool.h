@@ -0,0 +1,109 @@
+//
+//  ScannerPool.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_ScannerPool_h
+#define MoodstocksScanner_ScannerPool_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace msane {
+
+struct ScannerPoolStats {
+    size_t open;                // scanners in the pool
+    uint64_t bytes;             // their databases
+    uint64_t hits;              // opens served by a pooled scanner
+    uint64_t misses;            // opens that had to read a database
+    uint64_t evictions;
+};
+
+// Bookkeeping of the open scanners of one context, one per API key, most
+// recently used first. The extension owns the scanner objects and closes
+// whatever evict() hands back; the pool only decides which ones. A scanner
+// costs the size of its database, which the SDK keeps mapped. Not thread
+// safe, the extension uses it on its scan queue; only stats() may be read
+// from any thread.
+class ScannerPool {
+public:
+    explicit ScannerPool(size_t maxScanners = 4, uint64_t maxBytes = 64 * 1024 * 1024);
+
+    void setLimits(size_t maxScanners, uint64_t maxBytes);
+
+    // Moves `key` to the front and counts a hit, or counts a miss if it is
+    // not pooled
+    bool touch(const std::string &key);
+
+    // Adds a scanner just opened at the front
+    void insert(const std::string &key, uint64_t bytes);
+
+    // Updates the cost of a pooled scanner, e.g. after a sync
+    void setBytes(const std::string &key, uint64_t bytes);
+
+    // A busy scanner (syncing) is never evicted
+    void setBusy(const std::string &key, bool busy);
+
+    bool remove(const std::string &key);
+
+    // Appends the least recently used keys to `evicted` until the pool fits
+    // its limits again, and forgets them. The front scanner, the one in use,
+    // always stays.
+    void evict(std::vector<std::string> *evicted);
+
+    bool contains(const std::string &key) const;
+    ScannerPoolStats stats() const;
+
+private:
+    ScannerPool(const ScannerPool &);
+    ScannerPool &operator=(const ScannerPool &);
+
+    struct Entry {
+        std::string key;
+        uint64_t bytes;
+        bool busy;
+    };
+
+    typedef std::list<Entry>::iterator Iterator;
+    Iterator find(const std::string &key);
+
+    std::list<Entry> _entries;  // most recently used first
+    size_t _maxScanners;
+    uint64_t _maxBytes;
+    std::atomic<size_t> _open;  // _entries.size() for stats()
+    std::atomic<uint64_t> _bytes;
+    std::atomic<uint64_t> _hits;
+    std::atomic<uint64_t> _misses;
+    std::atomic<uint64_t> _evictions;
+};
+
+} // namespace msane
+
+#endif
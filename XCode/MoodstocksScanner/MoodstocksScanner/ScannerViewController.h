@@ -29,11 +29,33 @@
 
 @class MSScanner;
 
+typedef NS_ENUM(int, ScannerMode) {
+    ScannerModeManual = 0,      // tap to snap, searched on the server on a miss
+    ScannerModeAuto   = 1       // every frame searched on the device, results streamed
+};
+
 @interface ScannerViewController : UIViewController
 
 -(void)showOpeningAlert;
 
+// Lets the frame governor pause and resume scanning in ScannerModeAuto
+-(void)setProcessing:(BOOL)processing;
+
+// Set before each presentation; "camReady" is posted with the time elapsed
+// since, once the camera delivers frames
+@property (assign, nonatomic) CFAbsoluteTime presentTime;
+
 @property (weak, nonatomic) MSScanner *scanner;
+
+// Taken into account each time the view appears. resultExtras and
+// searchOptions only apply to ScannerModeAuto.
+@property (assign, nonatomic) ScannerMode mode;
+@property (assign, nonatomic) int resultTypes;
+@property (assign, nonatomic) int resultExtras;
+@property (assign, nonatomic) int searchOptions;
+
+// Seconds a ScannerModeManual snap may wait for the server, 0 for no limit
+@property (assign, nonatomic) NSTimeInterval serverDeadline;
 @property (weak, nonatomic) NSString *APIKEY;
 @property (weak, nonatomic) NSString *APISECRET;
 
@@ -16,8 +16,19 @@ static int kMSResultTypes = MSResultTypeImage  |
                             MSResultTypeEAN13;
 
 
-@interface ScannerViewController () <MSManualScannerSessionDelegate, UIActionSheetDelegate, UIAlertViewDelegate> {
-    MSManualScannerSession *_scannerSession;
+// an object still in view is not reported again by the auto session
+static const CFAbsoluteTime kRepeatInterval = 1.0;
+
+
+@interface ScannerViewController () <MSManualScannerSessionDelegate, MSAutoScannerSessionDelegate, UIActionSheetDelegate, UIAlertViewDelegate> {
+    id _scannerSession;         // MSManualScannerSession or MSAutoScannerSession
+    ScannerMode _sessionMode;
+    __weak MSScanner *_sessionScanner;
+    CFAbsoluteTime _snapTime;
+    BOOL _sessionStarted;
+    
+    MSResult *_lastResult;      // auto mode
+    CFAbsoluteTime _lastResultTime;
 }
 
 @property (weak, nonatomic) IBOutlet UIView *previewVideo;
@@ -28,26 +39,136 @@ static int kMSResultTypes = MSResultTypeImage  |
 
 UIActionSheet *aSheet;
 
+- (id)initWithNibName:(NSString *)nibNameOrNil bundle:(NSBundle *)nibBundleOrNil
+{
+    self = [super initWithNibName:nibNameOrNil bundle:nibBundleOrNil];
+    if (self)
+    {
+        _mode = ScannerModeManual;
+        _resultTypes = kMSResultTypes;
+        _resultExtras = MSResultExtraNone;
+        _searchOptions = MSSearchDefault;
+    }
+    return self;
+}
+
 - (void)viewDidLoad
 {
     [super viewDidLoad];
     
-    _scannerSession = [[MSManualScannerSession alloc] initWithScanner:_scanner];
-    _scannerSession.delegate = self;
-    _scannerSession.resultTypes = kMSResultTypes;
-
     CALayer *videoPreviewLayer = [self.previewVideo layer];
     [videoPreviewLayer setFrame:[[UIScreen mainScreen] bounds]];
     [videoPreviewLayer setMasksToBounds:YES];
     
-    CALayer *captureLayer = [_scannerSession captureLayer];
-    [captureLayer setFrame:[[UIScreen mainScreen] bounds]];
+    [self configureSession];
+}
+
+// Creates the session for the current mode and scanner, replacing the one
+// of another mode or catalog, and applies the scan options
+- (void)configureSession
+{
+    if (_scannerSession == nil || _sessionMode != _mode || _sessionScanner != _scanner)
+    {
+        if (_scannerSession != nil)
+        {
+            [_scannerSession stopRunning];
+            [[_scannerSession captureLayer] removeFromSuperlayer];
+            _sessionStarted = NO;
+        }
+        
+        if (_mode == ScannerModeAuto)
+        {
+            MSAutoScannerSession *session = [[MSAutoScannerSession alloc] initWithScanner:_scanner];
+            session.delegate = self;
+            _scannerSession = session;
+        }
+        else
+        {
+            MSManualScannerSession *session = [[MSManualScannerSession alloc] initWithScanner:_scanner];
+            session.delegate = self;
+            _scannerSession = session;
+        }
+        _sessionMode = _mode;
+        _sessionScanner = _scanner;
+        
+        CALayer *videoPreviewLayer = [self.previewVideo layer];
+        CALayer *captureLayer = [_scannerSession captureLayer];
+        [captureLayer setFrame:[[UIScreen mainScreen] bounds]];
+        [videoPreviewLayer insertSublayer:captureLayer
+                                    below:[[videoPreviewLayer sublayers] objectAtIndex:0]];
+    }
+    
+    [_scannerSession setResultTypes:_resultTypes];
+    if (_mode == ScannerModeAuto)
+    {
+        MSAutoScannerSession *session = _scannerSession;
+        session.resultExtras = _resultExtras;
+        session.searchOptions = _searchOptions;
+    }
+}
+
+// The view may be loaded ahead of time by prewarm, so the camera only
+// starts once we are actually shown
+- (void)viewWillAppear:(BOOL)animated
+{
+    [super viewWillAppear:animated];
     
-    [videoPreviewLayer insertSublayer:captureLayer
-                                below:[[videoPreviewLayer sublayers] objectAtIndex:0]];
+    [self configureSession];
+    if (!_sessionStarted)
+    {
+        [_scannerSession startRunning];
+        _sessionStarted = YES;
+    }
+    _lastResult = nil;
+    [_scannerSession resumeProcessing];
+}
 
-    [_scannerSession startRunning];
-    [self showOpeningAlert];
+// The capture keeps running for the next presentation, but nothing is
+// scanned while we are not shown
+- (void)viewDidDisappear:(BOOL)animated
+{
+    [super viewDidDisappear:animated];
+    [_scannerSession pauseProcessing];
+}
+
+- (void)viewDidAppear:(BOOL)animated
+{
+    [super viewDidAppear:animated];
+    if (_mode == ScannerModeManual)
+        [self showOpeningAlert];
+    
+    // on repeat presentations the session is usually still running
+    AVCaptureSession *session = [(AVCaptureVideoPreviewLayer *) [_scannerSession captureLayer] session];
+    if ([session isRunning])
+        [self reportCameraReady];
+    else
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(captureDidStart:) name:AVCaptureSessionDidStartRunningNotification object:session];
+}
+
+- (void)captureDidStart:(NSNotification *)notification
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:AVCaptureSessionDidStartRunningNotification object:nil];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self reportCameraReady];
+    });
+}
+
+- (void)reportCameraReady
+{
+    if (_presentTime == 0)
+        return;
+    
+    NSDictionary *info = [NSDictionary dictionaryWithObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent() - _presentTime] forKey:@"elapsed"];
+    _presentTime = 0;
+    [[NSNotificationCenter defaultCenter] postNotificationName:@"camReady" object:self userInfo:info];
+}
+
+-(void)setProcessing:(BOOL)processing
+{
+    if (processing)
+        [_scannerSession resumeProcessing];
+    else
+        [_scannerSession pauseProcessing];
 }
 
 -(void)showOpeningAlert
@@ -83,6 +204,10 @@ UIActionSheet *aSheet;
 
 - (IBAction)previewTapped:(id)sender
 {
+    if (_mode != ScannerModeManual)
+        return;
+    
+    _snapTime = CFAbsoluteTimeGetCurrent();
     [_scannerSession snap];
 }
 
@@ -130,19 +255,62 @@ UIActionSheet *aSheet;
 {
     MBProgressHUD *hud = [MBProgressHUD showHUDAddedTo:self.view animated:YES];
     hud.labelText = @"Searching...";
+    
+    if (_serverDeadline > 0)
+        [self performSelector:@selector(serverDeadlinePassed) withObject:nil afterDelay:_serverDeadline];
+}
+
+// A cancelled snap reports nothing, so the timeout is reported here
+- (void)serverDeadlinePassed
+{
+    if (![_scannerSession cancel])
+        return;
+    
+    [MBProgressHUD hideHUDForView:self.view animated:YES];
+    NSDictionary *info = [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithBool:YES], @"timedOut",
+                          [NSNumber numberWithDouble:_snapTime], @"timestamp", nil];
+    [[NSNotificationCenter defaultCenter] postNotificationName:@"matchFound" object:self userInfo:info];
+    
+    aSheet = [[UIActionSheet alloc] initWithTitle:@"The server did not answer in time."
+                                         delegate:self
+                                cancelButtonTitle:nil
+                           destructiveButtonTitle:nil
+                                otherButtonTitles:@"Continue", @"Exit Scan", nil];
+    [aSheet showInView:self.view];
+}
+
+// Auto mode: results stream to the app while the camera stays up
+- (void)session:(id)scannerSession didFindResult:(MSResult *)result
+{
+    if (result == nil)
+        return;
+    
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    BOOL repeated = _lastResult != nil && [_lastResult type] == [result type] &&
+                    [[_lastResult data] isEqualToData:[result data]] &&
+                    now - _lastResultTime < kRepeatInterval;
+    _lastResult = result;
+    _lastResultTime = now;
+    if (repeated)
+        return;
+    
+    NSDictionary *info = [NSDictionary dictionaryWithObjectsAndKeys:result, @"result",
+                          [NSNumber numberWithDouble:now], @"timestamp", nil];
+    [[NSNotificationCenter defaultCenter] postNotificationName:@"matchFound" object:self userInfo:info];
 }
 
 - (void)session:(id)scannerSession didFindResult:(MSResult *)result optionalQuery:(UIImage *)query
 {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(serverDeadlinePassed) object:nil];
     [MBProgressHUD hideHUDForView:self.view animated:YES];
     
     NSString *title = nil;
     
     if (result)
     {
-        NSString *type = [result type] == MSResultTypeImage ? @"Image" : @"Barcode";
-        title = [NSString stringWithFormat:@"%@:\n%@", type, [result string]];
-        [[NSNotificationCenter defaultCenter] postNotificationName:@"matchFound" object:title];
+        NSDictionary *info = [NSDictionary dictionaryWithObjectsAndKeys:result, @"result",
+                              [NSNumber numberWithDouble:_snapTime], @"timestamp", nil];
+        [[NSNotificationCenter defaultCenter] postNotificationName:@"matchFound" object:self userInfo:info];
         aSheet = [[UIActionSheet alloc] initWithTitle:@"Match Found! You're returning to the Application."
                                                             delegate:self
                                                    cancelButtonTitle:nil
@@ -168,11 +336,12 @@ UIActionSheet *aSheet;
 -(void)onTick:(NSTimer *)timer
 {
     [aSheet dismissWithClickedButtonIndex:0 animated:YES];
-    [[NSNotificationCenter defaultCenter] postNotificationName:@"exitCam" object:nil];
+    [[NSNotificationCenter defaultCenter] postNotificationName:@"exitCam" object:self];
 }
 
 - (void)session:(id)scannerSession didFailWithError:(NSError *)error
 {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(serverDeadlinePassed) object:nil];
     [MBProgressHUD hideHUDForView:self.view animated:YES];
     
     [[[UIAlertView alloc] initWithTitle:@"An error occurred:"
@@ -200,7 +369,7 @@ UIActionSheet *aSheet;
 {
     if (buttonIndex == 1)
     {
-        [[NSNotificationCenter defaultCenter] postNotificationName:@"exitCam" object:nil];
+        [[NSNotificationCenter defaultCenter] postNotificationName:@"exitCam" object:self];
     }
 }
 
@@ -0,0 +1,183 @@
+//
+//  SceneCache.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SceneCache.h"
+
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace msane {
+
+static const int kGridColumns = 9;
+static const int kGridRows = 8;
+static const int kMaxMeanDelta = 12;
+
+static uint32_t sumRun(const uint8_t *p, int count)
+{
+    uint32_t sum = 0;
+    int x = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; x + 16 <= count; x += 16)
+        acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(p + x)));
+    uint64x2_t wide = vpaddlq_u32(acc);
+    sum = (uint32_t) (vgetq_lane_u64(wide, 0) + vgetq_lane_u64(wide, 1));
+#elif defined(__SSE2__)
+    // sum of absolute differences against zero adds 8 bytes per lane
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= count; x += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + x)), zero));
+    sum = (uint32_t) (_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#endif
+    for (; x < count; x++)
+        sum += p[x];
+    return sum;
+}
+
+SceneHash sceneHash(const GrayView &plane)
+{
+    SceneHash hash = { 0, 0, 0, 0 };
+    if (plane.width < 2 * kGridColumns || plane.height < 2 * kGridRows)
+        return hash;
+
+    uint32_t cells[kGridRows][kGridColumns];
+    uint32_t areas[kGridRows][kGridColumns];
+    uint64_t total = 0;
+    uint64_t totalArea = 0;
+
+    for (int gy = 0; gy < kGridRows; gy++) {
+        int y0 = gy * plane.height / kGridRows;
+        int y1 = (gy + 1) * plane.height / kGridRows;
+        for (int gx = 0; gx < kGridColumns; gx++) {
+            int x0 = gx * plane.width / kGridColumns;
+            int x1 = (gx + 1) * plane.width / kGridColumns;
+
+            uint32_t sum = 0;
+            int rows = 0;
+            for (int y = y0; y < y1; y += 2, rows++)
+                sum += sumRun(plane.pixels + (size_t) y * plane.stride + x0, x1 - x0);
+            cells[gy][gx] = sum;
+            areas[gy][gx] = (uint32_t) rows * (x1 - x0);
+            total += sum;
+            totalArea += areas[gy][gx];
+        }
+    }
+
+    // compare means by cross multiplying, cells differ in size by a pixel
+    for (int gy = 0; gy < kGridRows; gy++)
+        for (int gx = 0; gx < kGridColumns - 1; gx++)
+            if ((uint64_t) cells[gy][gx] * areas[gy][gx + 1] > (uint64_t) cells[gy][gx + 1] * areas[gy][gx])
+                hash.bits |= (uint64_t) 1 << (gy * (kGridColumns - 1) + gx);
+
+    hash.mean = (uint8_t) (total / totalArea);
+    hash.width = plane.width;
+    hash.height = plane.height;
+    return hash;
+}
+
+int hammingDistance(uint64_t a, uint64_t b)
+{
+    uint64_t x = a ^ b;
+    int count = 0;
+    while (x) {
+        x &= x - 1;
+        count++;
+    }
+    return count;
+}
+
+SceneCache::SceneCache(double ttl, int maxDistance)
+    : _ttl(ttl), _maxDistance(maxDistance), _lookups(0), _hits(0), _savedTime(0)
+{
+    clear();
+}
+
+void SceneCache::configure(double ttl, int maxDistance)
+{
+    _ttl = ttl;
+    _maxDistance = maxDistance;
+    clear();
+}
+
+int SceneCache::lookup(const SceneHash &hash, int resultTypes, double now)
+{
+    if (_ttl <= 0 || hash.width == 0)
+        return -1;
+
+    _lookups++;
+    int best = -1;
+    int bestDistance = _maxDistance + 1;
+    for (int i = 0; i < kCapacity; i++) {
+        const Entry &entry = _entries[i];
+        if (!entry.used || entry.resultTypes != resultTypes || now - entry.time > _ttl ||
+            entry.hash.width != hash.width || entry.hash.height != hash.height ||
+            abs(entry.hash.mean - hash.mean) > kMaxMeanDelta)
+            continue;
+
+        int distance = hammingDistance(entry.hash.bits, hash.bits);
+        if (distance < bestDistance) {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+
+    if (best >= 0) {
+        _hits++;
+        _savedTime = _savedTime + _entries[best].cost;
+    }
+    return best;
+}
+
+int SceneCache::insert(const SceneHash &hash, int resultTypes, double now, double cost)
+{
+    if (_ttl <= 0 || hash.width == 0)
+        return -1;
+
+    // a free or expired slot, else the oldest one
+    int slot = 0;
+    for (int i = 0; i < kCapacity; i++) {
+        if (!_entries[i].used || now - _entries[i].time > _ttl) {
+            slot = i;
+            break;
+        }
+        if (_entries[i].time < _entries[slot].time)
+            slot = i;
+    }
+
+    Entry &entry = _entries[slot];
+    entry.hash = hash;
+    entry.resultTypes = resultTypes;
+    entry.time = now;
+    entry.cost = cost;
+    entry.used = true;
+    return slot;
+}
+
+void SceneCache::clear()
+{
+    for (int i = 0; i < kCapacity; i++)
+        _entries[i].used = false;
+}
+
+SceneCacheStats SceneCache::stats() const
+{
+    SceneCacheStats stats;
+    stats.lookups = _lookups;
+    stats.hits = _hits;
+    stats.savedTime = _savedTime;
+    return stats;
+}
+
+} // namespace msane
@@ -0,0 +1,114 @@
+//
+//  SceneCache.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_SceneCache_h
+#define MoodstocksScanner_SceneCache_h
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "PixelConvert.h"
+
+namespace msane {
+
+// Perceptual fingerprint of a luma plane: a 64 bit difference hash of its
+// 9x8 grid of cell means, plus the overall mean since the hash alone cannot
+// tell a white wall from a black one. `width` is 0 for planes too small to
+// be hashed.
+struct SceneHash {
+    uint64_t bits;
+    uint8_t mean;
+    int width;
+    int height;
+};
+
+// Every other row is summed with SSE2/NEON, a 640x480 frame takes a few
+// microseconds
+SceneHash sceneHash(const GrayView &plane);
+
+int hammingDistance(uint64_t a, uint64_t b);
+
+struct SceneCacheStats {
+    uint64_t lookups;
+    uint64_t hits;
+    double savedTime;           // seconds of search the hits replaced
+};
+
+// Outcomes of the last few searches, keyed by the fingerprint of their
+// query frame. A camera held on the same scene produces near duplicate
+// frames whose search would only repeat the last one, so a frame within
+// `maxDistance` bits of a fresh entry reuses its outcome, miss or match.
+// Entries are never refreshed by hits: a stationary scene is searched again
+// at least once per `ttl`. The cache only stores slot indexes, the caller
+// keeps the results in a parallel array. Not thread safe, except stats()
+// which may be read from any thread.
+class SceneCache {
+public:
+    static const int kCapacity = 8;
+
+    explicit SceneCache(double ttl = 1.0, int maxDistance = 4);
+
+    // A ttl of 0 turns the cache off
+    void configure(double ttl, int maxDistance);
+
+    // Slot of a fresh entry for a near duplicate scanned for the same
+    // result types, -1 if none
+    int lookup(const SceneHash &hash, int resultTypes, double now);
+
+    // Slot in which to keep the outcome of a search that took `cost`
+    // seconds, -1 if it is not to be cached
+    int insert(const SceneHash &hash, int resultTypes, double now, double cost);
+
+    // Cached outcomes go stale when the database changes
+    void clear();
+
+    SceneCacheStats stats() const;
+
+private:
+    SceneCache(const SceneCache &);
+    SceneCache &operator=(const SceneCache &);
+
+    struct Entry {
+        SceneHash hash;
+        int resultTypes;
+        double time;
+        double cost;
+        bool used;
+    };
+
+    Entry _entries[kCapacity];
+    double _ttl;
+    int _maxDistance;
+    std::atomic<uint64_t> _lookups;
+    std::atomic<uint64_t> _hits;
+    std::atomic<double> _savedTime;     // only written by lookup()
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,94 @@
+//
+//  SearchEscalation.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SearchEscalation.h"
+
+#include <string.h>
+
+namespace msane {
+
+SearchEscalation::SearchEscalation(const EscalationPolicy &policy)
+    : _policy(policy), _hasScene(false), _misses(0), _threshold(policy.misses)
+{
+    memset(&_scene, 0, sizeof(_scene));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void SearchEscalation::setPolicy(const EscalationPolicy &policy)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _policy = policy;
+    _hasScene = false;
+    _misses = 0;
+    _threshold = policy.misses;
+}
+
+EscalationPolicy SearchEscalation::policy() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _policy;
+}
+
+SearchLevel SearchEscalation::next(const SceneHash &hash)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (!_policy.enabled || hash.width == 0)
+        return SearchLevelDefault;
+
+    bool same = _hasScene && hash.width == _scene.width && hash.height == _scene.height &&
+                hammingDistance(hash.bits, _scene.bits) <= _policy.maxDistance;
+    if (!same) {
+        if (_hasScene)
+            _stats.sceneChanges++;
+        _scene = hash;
+        _hasScene = true;
+        _misses = 0;
+        _threshold = _policy.misses;
+    }
+    return _misses >= _threshold ? SearchLevelSmallTarget : SearchLevelDefault;
+}
+
+void SearchEscalation::outcome(SearchLevel level, bool matched)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (matched) {
+        _misses = 0;
+        _threshold = _policy.misses;
+    } else if (level == SearchLevelSmallTarget) {
+        _misses = 0;
+        if (_threshold < 1 << 20)
+            _threshold = _threshold > 0 ? _threshold * 2 : 1;
+    } else {
+        _misses++;
+    }
+}
+
+void SearchEscalation::record(SearchLevel level, double seconds, bool hit)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    LevelStats &stats = _stats.levels[level];
+    stats.runs++;
+    if (hit)
+        stats.hits++;
+    stats.time += seconds;
+}
+
+EscalationStats SearchEscalation::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+void SearchEscalation::resetStats()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+} // namespace msane
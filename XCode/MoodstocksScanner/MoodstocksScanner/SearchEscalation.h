@@ -0,0 +1,109 @@
+//
+//  SearchEscalation.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_SearchEscalation_h
+#define MoodstocksScanner_SearchEscalation_h
+
+#include <stdint.h>
+
+#include <mutex>
+
+#include "SceneCache.h"
+
+namespace msane {
+
+// How hard image matching looks, mapped to MSSearchOption by the caller
+enum SearchLevel {
+    SearchLevelDefault     = 0,     // MSSearchDefault
+    SearchLevelSmallTarget = 1,     // MSSearchSmallTarget, slower
+    kSearchLevels = 2
+};
+
+struct EscalationPolicy {
+    bool enabled;
+    int misses;                 // default searches missed in a row before a small target one
+    int maxDistance;            // hash bits a frame may differ by and still be the same scene
+    bool noPartial;             // add MSSearchNoPartial to every search
+
+    EscalationPolicy()
+        : enabled(true), misses(3), maxDistance(10), noPartial(false) {}
+};
+
+struct LevelStats {
+    uint64_t runs;
+    uint64_t hits;
+    double time;                // seconds
+};
+
+struct EscalationStats {
+    LevelStats levels[kSearchLevels];
+    uint64_t sceneChanges;
+};
+
+// Searches with the default options until a scene has missed `misses`
+// times in a row, then once with the small target option, which finds
+// distant or small items at a higher cost. Each small target miss doubles
+// the misses the scene needs for the next one, so an empty scene costs
+// little more than default searches. Only frames the frame gate let
+// through are counted, and a new scene starts from scratch. The latency
+// and hit rate of each level are recorded for every search, including
+// batches.
+class SearchEscalation {
+public:
+    explicit SearchEscalation(const EscalationPolicy &policy = EscalationPolicy());
+
+    void setPolicy(const EscalationPolicy &policy);
+    EscalationPolicy policy() const;
+
+    // Level to search the scene of `hash` with
+    SearchLevel next(const SceneHash &hash);
+
+    // Outcome of the recognition of a frame searched at `level`
+    void outcome(SearchLevel level, bool matched);
+
+    // One search at `level` that took `seconds`
+    void record(SearchLevel level, double seconds, bool hit);
+
+    EscalationStats stats() const;
+    void resetStats();
+
+private:
+    SearchEscalation(const SearchEscalation &);
+    SearchEscalation &operator=(const SearchEscalation &);
+
+    EscalationPolicy _policy;
+    SceneHash _scene;           // first frame of the scene the misses count for
+    bool _hasScene;
+    int _misses;
+    int _threshold;             // misses before the next small target search
+    EscalationStats _stats;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,118 @@
+//
+//  ServerFallback.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "ServerFallback.h"
+
+#include <string.h>
+
+namespace msane {
+
+ServerFallback::ServerFallback(const FallbackPolicy &policy)
+    : _policy(policy), _reachable(true), _nextId(0), _pending(0), _pendingStart(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void ServerFallback::setPolicy(const FallbackPolicy &policy)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _policy = policy;
+}
+
+FallbackPolicy ServerFallback::policy() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _policy;
+}
+
+void ServerFallback::setNetwork(bool reachable)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _reachable = reachable;
+}
+
+uint32_t ServerFallback::begin(double now)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (!_policy.enabled)
+        return 0;
+    if (!_reachable) {
+        _stats.offline++;
+        return 0;
+    }
+    if (_pending != 0) {
+        _stats.busy++;
+        return 0;
+    }
+
+    if (++_nextId == 0)
+        _nextId = 1;
+    _pending = _nextId;
+    _pendingStart = now;
+    _stats.requests++;
+    return _pending;
+}
+
+bool ServerFallback::finish(uint32_t id, double now, bool hit, bool error)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (id == 0 || id != _pending)
+        return false;
+    _pending = 0;
+
+    if (error) {
+        _stats.errors++;
+    } else {
+        if (hit)
+            _stats.hits++;
+        else
+            _stats.misses++;
+        _stats.time += now - _pendingStart;
+    }
+    return true;
+}
+
+bool ServerFallback::expire(uint32_t id)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (id == 0 || id != _pending)
+        return false;
+    _pending = 0;
+    _stats.timeouts++;
+    return true;
+}
+
+void ServerFallback::prepared(uint32_t id, size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (id != 0 && id == _pending) {
+        _stats.prepared++;
+        _stats.preparedBytes += bytes;
+    }
+}
+
+void ServerFallback::abandon(uint32_t id)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (id != 0 && id == _pending) {
+        _pending = 0;
+        _stats.requests--;
+    }
+}
+
+FallbackStats ServerFallback::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+} // namespace msane
@@ -0,0 +1,111 @@
+//
+//  ServerFallback.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef MoodstocksScanner_ServerFallback_h
+#define MoodstocksScanner_ServerFallback_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+
+namespace msane {
+
+struct FallbackPolicy {
+    bool enabled;               // headless scans; the camera UI always asks the server
+    double deadline;            // seconds a server search may take, 0 for none
+    float quality;              // grayscale JPEG quality the query goes through, 0 to hand the SDK raw pixels
+
+    FallbackPolicy()
+        : enabled(false), deadline(4.0), quality(0.7f) {}
+};
+
+struct FallbackStats {
+    uint64_t requests;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t errors;            // failed or cancelled by someone else
+    uint64_t timeouts;
+    uint64_t busy;              // local misses reported as is, a request was in flight
+    uint64_t offline;           // local misses reported as is, no network
+    double time;                // seconds until the answers that made it in time
+    uint64_t prepared;          // queries run through a JPEG
+    uint64_t preparedBytes;     // the size of those JPEGs, not of the upload
+};
+
+// Bookkeeping of the server search that backs up a local miss. Only one
+// request is in flight, so a stream of frames cannot queue up searches
+// behind a slow network; frames missed meanwhile are reported as misses.
+// Whichever comes first of the answer and the deadline settles a request,
+// the other one is then ignored. Called from the scan queue, the SDK's
+// completion blocks and the deadline timer.
+class ServerFallback {
+public:
+    explicit ServerFallback(const FallbackPolicy &policy = FallbackPolicy());
+
+    void setPolicy(const FallbackPolicy &policy);
+    FallbackPolicy policy() const;
+
+    void setNetwork(bool reachable);
+
+    // Id of a new request for a local miss at `now`, 0 if the miss is to
+    // be reported as is
+    uint32_t begin(double now);
+
+    // The server answered request `id`. Returns false if it was settled
+    // already, the answer is then dropped.
+    bool finish(uint32_t id, double now, bool hit, bool error);
+
+    // The deadline of request `id` passed. Returns true if it was still in
+    // flight: the caller cancels it and reports a timeout.
+    bool expire(uint32_t id);
+
+    // The query of request `id` was run through `bytes` of JPEG. MSImage
+    // only takes pixels, so the SDK decodes it and encodes its own upload.
+    void prepared(uint32_t id, size_t bytes);
+
+    // Request `id` could not be sent after all
+    void abandon(uint32_t id);
+
+    FallbackStats stats() const;
+
+private:
+    ServerFallback(const ServerFallback &);
+    ServerFallback &operator=(const ServerFallback &);
+
+    FallbackPolicy _policy;
+    bool _reachable;
+    uint32_t _nextId;
+    uint32_t _pending;          // 0 when none
+    double _pendingStart;
+    FallbackStats _stats;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
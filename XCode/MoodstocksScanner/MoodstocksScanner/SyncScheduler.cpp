@@ -0,0 +1,83 @@
+//
+//  SyncScheduler.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SyncScheduler.h"
+
+namespace msane {
+
+SyncScheduler::SyncScheduler(const SyncPolicy &policy)
+    : _policy(policy), _lastSuccess(0), _retryAt(0), _startedAt(0), _lastDuration(0), _failures(0),
+      _reachable(true), _unmetered(true), _busy(false), _suspended(false), _requested(false),
+      _running(false)
+{
+}
+
+void SyncScheduler::setNetwork(bool reachable, bool unmetered)
+{
+    _reachable = reachable;
+    _unmetered = reachable && unmetered;
+}
+
+double SyncScheduler::nextAllowed() const
+{
+    double due = _lastSuccess > 0 ? _lastSuccess + _policy.minInterval : 0;
+    return _retryAt > due ? _retryAt : due;
+}
+
+bool SyncScheduler::shouldStart(double now) const
+{
+    if (_running || _suspended || !_reachable)
+        return false;
+    if (_policy.unmeteredOnly && !_unmetered)
+        return false;
+    if (_requested)
+        return true;
+    if (_policy.idleOnly && _busy)
+        return false;
+    return now >= nextAllowed();
+}
+
+void SyncScheduler::started(double now)
+{
+    _startedAt = now;
+    _running = true;
+    _requested = false;
+}
+
+void SyncScheduler::finished(double now, SyncOutcome outcome)
+{
+    _running = false;
+
+    switch (outcome) {
+        case SyncSucceeded:
+            _lastSuccess = now;
+            _lastDuration = now - _startedAt;
+            _retryAt = 0;
+            _failures = 0;
+            break;
+        case SyncNetworkFailure: {
+            double backoff = _policy.backoffInitial;
+            for (unsigned i = 0; i < _failures && backoff < _policy.backoffMax; i++)
+                backoff *= 2;
+            _retryAt = now + (backoff < _policy.backoffMax ? backoff : _policy.backoffMax);
+            _failures++;
+            break;
+        }
+        case SyncOtherFailure:
+            // no point in hammering the server, wait a full interval
+            _retryAt = now + _policy.minInterval;
+            _failures = 0;
+            break;
+        case SyncCancelled:
+            break;
+        case SyncInterrupted:
+            _requested = true;
+            break;
+    }
+}
+
+} // namespace msane
@@ -0,0 +1,112 @@
+//
+//  SyncScheduler.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_SyncScheduler_h
+#define MoodstocksScanner_SyncScheduler_h
+
+namespace msane {
+
+struct SyncPolicy {
+    double minInterval;         // seconds after a successful sync
+    bool unmeteredOnly;         // Wi-Fi, never over the cellular network
+    bool idleOnly;              // not while the camera or a batch is scanning
+    double backoffInitial;      // seconds, doubled after every network failure
+    double backoffMax;
+
+    SyncPolicy()
+        : minInterval(60 * 60), unmeteredOnly(false), idleOnly(false),
+          backoffInitial(30), backoffMax(60 * 60) {}
+};
+
+enum SyncOutcome {
+    SyncSucceeded,
+    SyncNetworkFailure,         // no connection or timeout, backs off
+    SyncOtherFailure,           // retried after the minimum interval
+    SyncCancelled,              // as if it never ran
+    SyncInterrupted             // cut short by suspension, resumed first thing
+};
+
+// Decides when the local database is synced. Time is passed in by the
+// caller (seconds, any epoch as long as it is the same one the last success
+// is persisted in), so the policy can be run in virtual time. Not thread
+// safe, the extension drives it from the main thread.
+class SyncScheduler {
+public:
+    explicit SyncScheduler(const SyncPolicy &policy = SyncPolicy());
+
+    void setPolicy(const SyncPolicy &policy) { _policy = policy; }
+    const SyncPolicy &policy() const { return _policy; }
+
+    void setLastSuccess(double time) { _lastSuccess = time; }
+    double lastSuccess() const { return _lastSuccess; }
+
+    void setNetwork(bool reachable, bool unmetered);
+    void setBusy(bool busy) { _busy = busy; }
+
+    // No sync starts while the app is suspended
+    void setSuspended(bool suspended) { _suspended = suspended; }
+    bool suspended() const { return _suspended; }
+
+    // Asks for a sync as soon as the network allows, regardless of the
+    // interval, backoff and idle policies
+    void request() { _requested = true; }
+
+    bool shouldStart(double now) const;
+
+    // Earliest time at which the interval or backoff lets a sync start;
+    // network and idle conditions are signalled by their own callbacks
+    double nextAllowed() const;
+
+    void started(double now);
+    void finished(double now, SyncOutcome outcome);
+
+    bool running() const { return _running; }
+    unsigned failures() const { return _failures; }
+    double startedAt() const { return _startedAt; }
+
+    // Seconds from started() to finished() of the last successful sync
+    double lastDuration() const { return _lastDuration; }
+
+private:
+    SyncPolicy _policy;
+    double _lastSuccess;
+    double _retryAt;            // after a failure, 0 if none
+    double _startedAt;
+    double _lastDuration;
+    unsigned _failures;         // network failures in a row
+    bool _reachable;
+    bool _unmetered;
+    bool _busy;
+    bool _suspended;
+    bool _requested;
+    bool _running;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,135 @@
+//
+//  SyncStatus.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SyncStatus.h"
+
+#include <stdio.h>
+
+namespace msane {
+
+size_t SyncStatus::format(char *dst, size_t capacity) const
+{
+    int length = snprintf(dst, capacity, "%d,%d,%d", syncing ? 1 : 0, progress, error);
+    if (length < 0)
+        return 0;
+    return (size_t) length < capacity ? (size_t) length : capacity - 1;
+}
+
+SyncStatusThrottle::SyncStatusThrottle(double interval)
+    : _interval(interval), _lastDelivery(-1e9), _flushScheduled(false),
+      _updates(0), _deliveries(0)
+{
+    SyncStatus idle = { false, -1, 0 };
+    _latest = idle;
+    _delivered = idle;
+}
+
+void SyncStatusThrottle::setInterval(double interval)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _interval = interval > 0 ? interval : 0;
+}
+
+double SyncStatusThrottle::update(const SyncStatus &status, double now)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _updates++;
+    _latest = status;
+
+    if (_flushScheduled || _latest == _delivered)
+        return -1;
+
+    _flushScheduled = true;
+    double wait = _lastDelivery + _interval - now;
+    return wait > 0 ? wait : 0;
+}
+
+bool SyncStatusThrottle::flush(double now, SyncStatus *status)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _flushScheduled = false;
+    if (_latest == _delivered)
+        return false;
+
+    _delivered = _latest;
+    _lastDelivery = now;
+    _deliveries++;
+    *status = _delivered;
+    return true;
+}
+
+SyncStatus SyncStatusThrottle::latest() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _latest;
+}
+
+uint64_t SyncStatusThrottle::updateCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _updates;
+}
+
+uint64_t SyncStatusThrottle::deliveryCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _deliveries;
+}
+
+SyncStatusBoard::SyncStatusBoard(double interval)
+    : _interval(interval)
+{
+}
+
+void SyncStatusBoard::setInterval(double interval)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _interval = interval;
+    for (Throttles::iterator it = _throttles.begin(); it != _throttles.end(); ++it)
+        it->second->setInterval(interval);
+}
+
+SyncStatusThrottle &SyncStatusBoard::throttle(const std::string &key)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    std::unique_ptr<SyncStatusThrottle> &throttle = _throttles[key];
+    if (!throttle) {
+        throttle.reset(new SyncStatusThrottle());
+        throttle->setInterval(_interval);
+    }
+    return *throttle;
+}
+
+double SyncStatusBoard::update(const std::string &key, const SyncStatus &status, double now)
+{
+    return throttle(key).update(status, now);
+}
+
+bool SyncStatusBoard::flush(const std::string &key, double now, SyncStatus *status)
+{
+    return throttle(key).flush(now, status);
+}
+
+uint64_t SyncStatusBoard::updateCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    uint64_t count = 0;
+    for (Throttles::const_iterator it = _throttles.begin(); it != _throttles.end(); ++it)
+        count += it->second->updateCount();
+    return count;
+}
+
+uint64_t SyncStatusBoard::deliveryCount() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    uint64_t count = 0;
+    for (Throttles::const_iterator it = _throttles.begin(); it != _throttles.end(); ++it)
+        count += it->second->deliveryCount();
+    return count;
+}
+
+} // namespace msane
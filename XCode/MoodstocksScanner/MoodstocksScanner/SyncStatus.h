@@ -0,0 +1,126 @@
+//
+//  SyncStatus.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_SyncStatus_h
+#define MoodstocksScanner_SyncStatus_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace msane {
+
+// What ActionScript sees of MSScanner's isSyncing, syncProgress and syncError
+struct SyncStatus {
+    bool syncing;
+    int progress;       // 0..100, -1 if unknown
+    int error;          // MSErrorCode of the last sync, 0 if none
+
+    bool operator==(const SyncStatus &other) const
+    {
+        return syncing == other.syncing && progress == other.progress && error == other.error;
+    }
+    bool operator!=(const SyncStatus &other) const { return !(*this == other); }
+
+    // "syncing,progress,error", e.g. "1,42,0"; returns the length
+    size_t format(char *dst, size_t capacity) const;
+};
+
+// Rate limits status deliveries while keeping only the latest status, so a
+// burst of progress notifications costs at most one event per interval and
+// the final state is never lost. Any thread; time is passed in seconds.
+class SyncStatusThrottle {
+public:
+    explicit SyncStatusThrottle(double interval = 0.25);
+
+    void setInterval(double interval);
+
+    // Records `status`. Returns the delay in seconds after which flush()
+    // has to be called, 0 to call it right away, or a negative value when
+    // nothing is to be done (unchanged, or a flush is already scheduled).
+    double update(const SyncStatus &status, double now);
+
+    // Hands out the latest status if it differs from the last delivered one
+    bool flush(double now, SyncStatus *status);
+
+    SyncStatus latest() const;
+    uint64_t updateCount() const;
+    uint64_t deliveryCount() const;
+
+private:
+    SyncStatusThrottle(const SyncStatusThrottle &);
+    SyncStatusThrottle &operator=(const SyncStatusThrottle &);
+
+    double _interval;
+    double _lastDelivery;
+    SyncStatus _latest;
+    SyncStatus _delivered;
+    bool _flushScheduled;
+    uint64_t _updates;
+    uint64_t _deliveries;
+    mutable std::mutex _lock;
+};
+
+// One throttle per API key. Pooled scanners sync independently, so one
+// catalog's progress must not coalesce away another one's final state.
+// Any thread.
+class SyncStatusBoard {
+public:
+    explicit SyncStatusBoard(double interval = 0.25);
+
+    // Applies to every key, present and future
+    void setInterval(double interval);
+
+    // Same as SyncStatusThrottle, for the throttle of `key`
+    double update(const std::string &key, const SyncStatus &status, double now);
+    bool flush(const std::string &key, double now, SyncStatus *status);
+
+    // Totals over all keys
+    uint64_t updateCount() const;
+    uint64_t deliveryCount() const;
+
+private:
+    SyncStatusBoard(const SyncStatusBoard &);
+    SyncStatusBoard &operator=(const SyncStatusBoard &);
+
+    SyncStatusThrottle &throttle(const std::string &key);
+
+    // throttles are never removed, there are only a few catalogs
+    typedef std::map<std::string, std::unique_ptr<SyncStatusThrottle> > Throttles;
+    Throttles _throttles;
+    double _interval;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
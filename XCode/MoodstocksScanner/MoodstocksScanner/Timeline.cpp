@@ -0,0 +1,52 @@
+//
+//  Timeline.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "Timeline.h"
+
+namespace msane {
+
+Timeline::Timeline()
+    : _origin(std::chrono::steady_clock::now())
+{
+}
+
+Timeline &Timeline::coldStart()
+{
+    static Timeline *timeline = new Timeline();
+    return *timeline;
+}
+
+void Timeline::start()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _origin = std::chrono::steady_clock::now();
+    _marks.clear();
+}
+
+void Timeline::mark(const char *name)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> guard(_lock);
+    for (size_t i = 0; i < _marks.size(); i++) {
+        if (_marks[i].name == name)
+            return;
+    }
+
+    Mark mark;
+    mark.name = name;
+    mark.milliseconds = std::chrono::duration<double, std::milli>(now - _origin).count();
+    _marks.push_back(mark);
+}
+
+std::vector<Timeline::Mark> Timeline::marks() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _marks;
+}
+
+} // namespace msane
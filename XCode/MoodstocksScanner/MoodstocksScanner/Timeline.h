@@ -0,0 +1,71 @@
+//
+//  Timeline.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_Timeline_h
+#define MoodstocksScanner_Timeline_h
+
+#include <stddef.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace msane {
+
+// Named milestones in milliseconds since start(), e.g. the cold start of
+// the extension. Only the first occurrence of a name is kept, so marks may
+// be dropped on hot paths without growing the list.
+class Timeline {
+public:
+    struct Mark {
+        std::string name;
+        double milliseconds;
+    };
+
+    Timeline();
+
+    void start();
+    void mark(const char *name);
+    std::vector<Mark> marks() const;
+
+    // The extension's cold start timeline, started by the extension initializer
+    static Timeline &coldStart();
+
+private:
+    Timeline(const Timeline &);
+    Timeline &operator=(const Timeline &);
+
+    std::chrono::steady_clock::time_point _origin;
+    std::vector<Mark> _marks;
+    mutable std::mutex _lock;
+};
+
+} // namespace msane
+
+#endif
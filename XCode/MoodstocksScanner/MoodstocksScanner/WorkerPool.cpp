@@ -0,0 +1,118 @@
+//
+//  WorkerPool.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "WorkerPool.h"
+
+namespace msane {
+
+WorkerPool::WorkerPool(unsigned threads)
+    : _count(0), _generation(0), _active(0), _stopping(false),
+      _next(0), _processed(0), _cancelled(false)
+{
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; i++)
+        _threads.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+}
+
+WorkerPool::~WorkerPool()
+{
+    cancel();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (size_t i = 0; i < _threads.size(); i++)
+        _threads[i].join();
+}
+
+bool WorkerPool::run(const std::shared_ptr<BatchJob> &job, size_t count)
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_job || _stopping)
+            return false;
+
+        _job = job;
+        _count = count;
+        _next = 0;
+        _processed = 0;
+        _cancelled = false;
+        _active = (unsigned) _threads.size();
+        _generation++;
+    }
+    _wake.notify_all();
+    return true;
+}
+
+void WorkerPool::cancel()
+{
+    _cancelled = true;
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while (_job)
+        _idle.wait(lock);
+}
+
+bool WorkerPool::busy() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return (bool) _job;
+}
+
+void WorkerPool::workerLoop(unsigned worker)
+{
+    unsigned seen = 0;
+    for (;;) {
+        std::shared_ptr<BatchJob> job;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            while (!_stopping && (!_job || _generation == seen))
+                _wake.wait(lock);
+            if (_stopping)
+                return;
+            seen = _generation;
+            job = _job;
+            count = _count;
+        }
+
+        // items are claimed one at a time, so a slow photo does not hold
+        // back a whole slice of the batch
+        while (!_cancelled.load(std::memory_order_relaxed)) {
+            size_t index = _next.fetch_add(1);
+            if (index >= count)
+                break;
+            job->process(index, worker);
+            _processed.fetch_add(1);
+        }
+
+        bool last;
+        size_t processed = 0;
+        bool cancelled = false;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            last = --_active == 0;
+            if (last) {
+                // read before run() can reset them for the next batch
+                processed = _processed.load();
+                cancelled = _cancelled.load();
+                _job.reset();
+            }
+        }
+        if (last) {
+            _idle.notify_all();
+            job->finished(processed, cancelled);
+        }
+    }
+}
+
+} // namespace msane
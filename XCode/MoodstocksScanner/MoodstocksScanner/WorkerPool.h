@@ -0,0 +1,101 @@
+//
+//  WorkerPool.h
+//  MoodstocksScanner
+//
+
+// This code is distributed under the terms and conditions of the MIT license.
+
+// Copyright (c) 2014 Santanu Karar
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef MoodstocksScanner_WorkerPool_h
+#define MoodstocksScanner_WorkerPool_h
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msane {
+
+// One batch of `count` independent items, e.g. photos to recognize.
+class BatchJob {
+public:
+    virtual ~BatchJob() {}
+
+    // Handles item `index` on worker `worker` (0 .. threads - 1). Items are
+    // handed out in order but complete in any order; per worker scratch
+    // state may be indexed by `worker` without locking.
+    virtual void process(size_t index, unsigned worker) = 0;
+
+    // Called once on the last worker to finish, after the pool is idle again
+    // so a new batch may be started from here.
+    virtual void finished(size_t processed, bool cancelled) = 0;
+};
+
+// Fixed number of threads working through one batch at a time. Threads are
+// started once and sleep between batches.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool(); // cancels the running batch and joins
+
+    unsigned threads() const { return (unsigned) _threads.size(); }
+
+    // Starts a batch. Returns false if one is still running.
+    bool run(const std::shared_ptr<BatchJob> &job, size_t count);
+
+    // Items not yet handed to a worker are skipped, items in progress finish.
+    void cancel();
+
+    // Blocks until the running batch, if any, is done.
+    void wait();
+
+    bool busy() const;
+    size_t processed() const { return _processed.load(); }
+
+private:
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator=(const WorkerPool &);
+
+    void workerLoop(unsigned worker);
+
+    std::vector<std::thread> _threads;
+    std::shared_ptr<BatchJob> _job;
+    size_t _count;
+    unsigned _generation;
+    unsigned _active;       // workers still on the current batch
+    bool _stopping;
+    std::atomic<size_t> _next;
+    std::atomic<size_t> _processed;
+    std::atomic<bool> _cancelled;
+    mutable std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+};
+
+} // namespace msane
+
+#endif
@@ -0,0 +1,123 @@
+//
+//  Allocations.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "TestHarness.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Counts heap allocations per thread, so tests and benchmarks can prove a
+// hot path never touches the heap. operator new is replaceable everywhere;
+// malloc is wrapped through glibc's internal entry points where they exist.
+
+namespace msanetest {
+
+static __thread uint64_t allocations = 0;
+static std::atomic<size_t> liveBytes(0);
+static std::atomic<size_t> peakBytes(0);
+
+uint64_t allocationCount()
+{
+    return allocations;
+}
+
+size_t heapPeak()
+{
+    return peakBytes.load();
+}
+
+void resetHeapPeak()
+{
+    peakBytes.store(liveBytes.load());
+}
+
+static void *counted(void *p)
+{
+    if (p != NULL) {
+#if defined(__GLIBC__)
+        size_t live = liveBytes += malloc_usable_size(p);
+        size_t peak = peakBytes.load();
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {}
+#endif
+    }
+    return p;
+}
+
+static void uncounted(void *p)
+{
+#if defined(__GLIBC__)
+    if (p != NULL)
+        liveBytes -= malloc_usable_size(p);
+#else
+    (void) p;
+#endif
+}
+
+} // namespace msanetest
+
+void *operator new(size_t size)
+{
+#if !defined(__GLIBC__)
+    msanetest::allocations++;   // counted by malloc below otherwise
+#endif
+    void *p = malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+extern "C" void *malloc(size_t size)
+{
+    msanetest::allocations++;
+    return msanetest::counted(__libc_malloc(size));
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    msanetest::allocations++;
+    return msanetest::counted(__libc_calloc(count, size));
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    msanetest::allocations++;
+    size_t old = p != NULL ? malloc_usable_size(p) : 0;
+    void *q = __libc_realloc(p, size);
+    if (q == NULL)
+        return NULL;
+    msanetest::liveBytes -= old;
+    return msanetest::counted(q);
+}
+
+extern "C" void free(void *p)
+{
+    msanetest::uncounted(p);
+    __libc_free(p);
+}
+#endif
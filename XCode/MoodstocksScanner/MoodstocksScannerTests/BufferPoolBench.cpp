@@ -0,0 +1,59 @@
+//
+//  BufferPoolBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "BufferPool.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// Cost of getting and returning one frame buffer, pooled and straight from
+// malloc, and heap allocations per frame, for a few frame sizes. Each buffer
+// is touched once so malloc cannot hand back pages it never maps.
+int main()
+{
+    const int frames = 20000;
+    const size_t sizes[] = { 320 * 240, 640 * 480, 1280 * 720, 1920 * 1080 };
+
+    printf("%10s %14s %14s %16s\n", "bytes", "pool ns/frame", "malloc ns/frame", "pool allocs/frame");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        size_t bytes = sizes[i];
+        BufferPool pool;
+        unsigned sum = 0;
+
+        uint64_t allocations = allocationCount();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            uint8_t *buffer = (uint8_t *) pool.acquire(bytes);
+            buffer[(f * 4096) % bytes] = (uint8_t) f;
+            sum += buffer[bytes / 2];
+            pool.release(buffer, bytes);
+        }
+        double pooled = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double perFrame = (double) (allocationCount() - allocations) / frames;
+
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            uint8_t *buffer = (uint8_t *) malloc(bytes);
+            buffer[(f * 4096) % bytes] = (uint8_t) f;
+            sum += buffer[bytes / 2];
+            free(buffer);
+        }
+        double direct = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printf("%10zu %14.1f %14.1f %16.4f\n", bytes, pooled * 1e9 / frames, direct * 1e9 / frames, perFrame);
+        if (sum == 1)
+            printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+//
+//  BufferPoolTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "BufferPool.h"
+#include "PixelConvert.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+TEST(sizesRoundUpToClasses)
+{
+    CHECK_EQ(BufferPool::classSize(1), 4096u);
+    CHECK_EQ(BufferPool::classSize(4096), 4096u);
+    CHECK_EQ(BufferPool::classSize(4097), 8192u);
+    CHECK_EQ(BufferPool::classSize(640 * 480), 512u * 1024);
+    // beyond the largest class the exact size is allocated
+    CHECK_EQ(BufferPool::classSize(20 * 1024 * 1024), 20u * 1024 * 1024);
+}
+
+TEST(releasedBuffersAreReused)
+{
+    BufferPool pool;
+    void *first = pool.acquire(1000);
+    pool.release(first, 1000);
+    CHECK_EQ(pool.stats().bytesCached, 4096u);
+
+    void *second = pool.acquire(3000);
+    CHECK(second == first);
+    BufferPoolStats stats = pool.stats();
+    CHECK_EQ(stats.allocations, 1u);
+    CHECK_EQ(stats.reuses, 1u);
+    CHECK_EQ(stats.bytesInUse, 4096u);
+    CHECK_EQ(stats.bytesCached, 0u);
+    pool.release(second, 3000);
+}
+
+TEST(capacityBoundsTheCache)
+{
+    BufferPool pool(16384);
+    void *buffers[5];
+    for (int i = 0; i < 5; i++)
+        buffers[i] = pool.acquire(4096);
+    for (int i = 0; i < 5; i++)
+        pool.release(buffers[i], 4096);
+
+    BufferPoolStats stats = pool.stats();
+    CHECK_EQ(stats.bytesInUse, 0u);
+    CHECK_EQ(stats.bytesCached, 16384u);
+    CHECK_EQ(stats.highWaterInUse, 5u * 4096);
+    CHECK_EQ(stats.highWaterTotal, 5u * 4096);
+
+    pool.setCapacity(4096);
+    CHECK_EQ(pool.stats().bytesCached, 0u);
+    pool.trim();
+    CHECK_EQ(pool.stats().bytesCached, 0u);
+}
+
+TEST(fullSlotsFreeTheBuffer)
+{
+    // eight slots per class, the ninth buffer cannot be cached
+    BufferPool pool;
+    void *buffers[9];
+    for (int i = 0; i < 9; i++)
+        buffers[i] = pool.acquire(4096);
+    for (int i = 0; i < 9; i++)
+        pool.release(buffers[i], 4096);
+    CHECK_EQ(pool.stats().bytesCached, 8u * 4096);
+}
+
+// The scanning hot path per frame: a luma plane for the crop, converted and
+// handed back once scanned. After the first frames no heap allocation may
+// happen at all; a regression here shows up as a non-zero count.
+TEST(steadyStateFramesDoNotAllocate)
+{
+    const int width = 640, height = 480;
+    std::vector<uint32_t> bits((size_t) width * height, 0xff808080);
+    BitmapView bitmap = { &bits[0], width, height, width, false, false, false };
+    CropRect crop = { 80, 60, 480, 360 };
+    BufferPool pool;
+
+    uint64_t before = 0;
+    for (int frame = 0; frame < 1004; frame++) {
+        if (frame == 4)
+            before = allocationCount();
+        uint8_t *gray = (uint8_t *) pool.acquire((size_t) crop.width * crop.height);
+        GrayView view = { gray, crop.width, crop.height, crop.width };
+        convertBitmapToGray(bitmap, crop, view);
+        // a batch of encoded bytes alongside, as scanEncodedBytes() copies them
+        uint8_t *encoded = (uint8_t *) pool.acquire(30000);
+        memset(encoded, frame & 255, 30000);
+        pool.release(encoded, 30000);
+        pool.release(gray, (size_t) crop.width * crop.height);
+    }
+    CHECK_EQ(allocationCount() - before, 0u);
+    CHECK_EQ(pool.stats().allocations, 2u);
+}
+
+// Releases racing acquires must never let the cached byte count wrap around
+// or drift: once every thread is done it equals what sits in the slots.
+TEST(accountingSurvivesContention)
+{
+    BufferPool pool(3 * 8192);
+    std::atomic<bool> wrapped(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&pool, &wrapped, t] {
+            for (int i = 0; i < 20000; i++) {
+                size_t bytes = (i + t) % 3 == 0 ? 8192 : 4096;
+                void *buffer = pool.acquire(bytes);
+                BufferPoolStats stats = pool.stats();
+                if (stats.bytesCached > stats.capacity)
+                    wrapped = true;
+                pool.release(buffer, bytes);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    CHECK(!wrapped);
+    BufferPoolStats stats = pool.stats();
+    CHECK_EQ(stats.bytesInUse, 0u);
+    CHECK(stats.bytesCached <= stats.capacity);
+    size_t cached = stats.bytesCached;
+    pool.trim();
+    CHECK_EQ(pool.stats().bytesCached, 0u);
+    CHECK(cached % 4096 == 0);
+}
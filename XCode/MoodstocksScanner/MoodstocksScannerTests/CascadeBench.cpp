@@ -0,0 +1,101 @@
+//
+//  CascadeBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+
+#include "Cascade.h"
+
+using namespace msane;
+
+// What the frames of a session hold, at most one thing each
+struct Workload {
+    const char *name;
+    double barcodes;            // share of frames with a code
+    double images;              // share of frames with a reference image
+};
+
+// The result types the AS side asks for and the stage order
+struct Config {
+    const char *name;
+    bool barcodes;
+    bool image;
+    bool cascade;               // false: every wanted stage runs, as before
+    CascadeOrder order;
+};
+
+// Drives recognizeGray's loop over a Cascade with modelled stage costs:
+// decodeWithQuery: around 3 ms, searchWithQuery: around 12 ms, +-50%. The
+// SDK is not available on the host, so the times are the model's, the
+// runs, hits and skips are what the counters report on device.
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    const double decodeCost = 0.003, searchCost = 0.012;
+
+    const Workload workloads[] = {
+        { "barcode only", 0.6, 0 },
+        { "image only", 0, 0.6 },
+        { "both", 0.3, 0.3 },
+    };
+    const Config configs[] = {
+        { "every stage", true, true, false, CascadeBarcodeFirst },
+        { "barcode first", true, true, true, CascadeBarcodeFirst },
+        { "image first", true, true, true, CascadeImageFirst },
+        { "barcodes only", true, false, true, CascadeBarcodeFirst },
+        { "image only", false, true, true, CascadeImageFirst },
+    };
+
+    printf("%d frames, decode %.0f ms, search %.0f ms, +-50%%\n", frames, decodeCost * 1e3, searchCost * 1e3);
+    for (int w = 0; w < 3; w++) {
+        const Workload &workload = workloads[w];
+        printf("\n%s: %.0f%% barcodes, %.0f%% images\n", workload.name, workload.barcodes * 100,
+               workload.images * 100);
+        printf("%16s %10s %8s %8s %8s %8s\n", "", "ms/frame", "decodes", "searches", "skipped", "found");
+        for (int c = 0; c < 5; c++) {
+            const Config &config = configs[c];
+            if ((!config.barcodes && workload.barcodes > 0) || (!config.image && workload.images > 0))
+                continue;       // would lose results of this workload
+            Cascade cascade;
+            cascade.setOrder(config.order);
+            // same frames and costs for every config
+            std::mt19937 content(11), costs(13);
+            std::uniform_real_distribution<double> unit(0, 1);
+
+            for (int i = 0; i < frames; i++) {
+                double draw = unit(content);
+                bool barcode = draw < workload.barcodes;
+                bool image = !barcode && draw < workload.barcodes + workload.images;
+
+                CascadeStage stages[kCascadeStages];
+                int count = cascade.stages(config.barcodes, config.image, stages);
+                bool found = false;
+                for (int s = 0; s < count; s++) {
+                    if (found && config.cascade) {
+                        cascade.skip(stages[s]);
+                        continue;
+                    }
+                    bool decode = stages[s] == CascadeStageDecode;
+                    double cost = (decode ? decodeCost : searchCost) * (0.5 + unit(costs));
+                    bool hit = decode ? barcode : image;
+                    cascade.record(stages[s], cost, hit);
+                    found = found || hit;
+                }
+            }
+
+            StageStats decode = cascade.stats(CascadeStageDecode);
+            StageStats search = cascade.stats(CascadeStageSearch);
+            printf("%16s %10.2f %8llu %8llu %8llu %8llu\n", config.name, (decode.time + search.time) * 1e3 / frames,
+                   (unsigned long long) decode.runs, (unsigned long long) search.runs,
+                   (unsigned long long) (decode.skipped + search.skipped),
+                   (unsigned long long) (decode.hits + search.hits));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+//
+//  CascadeTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <thread>
+#include <vector>
+
+#include "Cascade.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+TEST(barcodesFirstByDefault)
+{
+    Cascade cascade;
+    CHECK_EQ(cascade.order(), CascadeBarcodeFirst);
+
+    CascadeStage stages[kCascadeStages];
+    CHECK_EQ(cascade.stages(true, true, stages), 2);
+    CHECK_EQ(stages[0], CascadeStageDecode);
+    CHECK_EQ(stages[1], CascadeStageSearch);
+}
+
+TEST(orderChangesTheFirstStage)
+{
+    Cascade cascade;
+    cascade.setOrder(CascadeImageFirst);
+    CHECK_EQ(cascade.order(), CascadeImageFirst);
+
+    CascadeStage stages[kCascadeStages];
+    CHECK_EQ(cascade.stages(true, true, stages), 2);
+    CHECK_EQ(stages[0], CascadeStageSearch);
+    CHECK_EQ(stages[1], CascadeStageDecode);
+
+    cascade.setOrder(CascadeBarcodeFirst);
+    cascade.stages(true, true, stages);
+    CHECK_EQ(stages[0], CascadeStageDecode);
+}
+
+TEST(onlyWantedStagesRun)
+{
+    Cascade cascade;
+    CascadeStage stages[kCascadeStages];
+    for (int order = 0; order < 2; order++) {
+        cascade.setOrder((CascadeOrder) order);
+        CHECK_EQ(cascade.stages(true, false, stages), 1);
+        CHECK_EQ(stages[0], CascadeStageDecode);
+        CHECK_EQ(cascade.stages(false, true, stages), 1);
+        CHECK_EQ(stages[0], CascadeStageSearch);
+        CHECK_EQ(cascade.stages(false, false, stages), 0);
+    }
+}
+
+TEST(countersPerStage)
+{
+    Cascade cascade;
+    cascade.record(CascadeStageDecode, 0.003, false);
+    cascade.record(CascadeStageDecode, 0.002, true);
+    cascade.record(CascadeStageSearch, 0.012, true);
+    cascade.skip(CascadeStageSearch);
+    cascade.skip(CascadeStageSearch);
+
+    StageStats decode = cascade.stats(CascadeStageDecode);
+    CHECK_EQ(decode.runs, 2u);
+    CHECK_EQ(decode.hits, 1u);
+    CHECK_EQ(decode.skipped, 0u);
+    CHECK(decode.time > 0.00499 && decode.time < 0.00501);
+
+    StageStats search = cascade.stats(CascadeStageSearch);
+    CHECK_EQ(search.runs, 1u);
+    CHECK_EQ(search.hits, 1u);
+    CHECK_EQ(search.skipped, 2u);
+
+    cascade.reset();
+    CHECK_EQ(cascade.stats(CascadeStageDecode).runs, 0u);
+    CHECK_EQ(cascade.stats(CascadeStageSearch).skipped, 0u);
+    CHECK_EQ(cascade.stats(CascadeStageSearch).time, 0.0);
+}
+
+TEST(resetKeepsTheOrder)
+{
+    Cascade cascade;
+    cascade.setOrder(CascadeImageFirst);
+    cascade.reset();
+    CHECK_EQ(cascade.order(), CascadeImageFirst);
+}
+
+// The scan queue and the batch workers record at the same time
+TEST(concurrentRecording)
+{
+    Cascade cascade;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&cascade, t] {
+            for (int i = 0; i < 10000; i++) {
+                cascade.record((CascadeStage) (t % 2), 0.001, i % 2 == 0);
+                cascade.skip((CascadeStage) ((t + 1) % 2));
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    for (int stage = 0; stage < kCascadeStages; stage++) {
+        StageStats stats = cascade.stats((CascadeStage) stage);
+        CHECK_EQ(stats.runs, 20000u);
+        CHECK_EQ(stats.hits, 10000u);
+        CHECK_EQ(stats.skipped, 20000u);
+    }
+}
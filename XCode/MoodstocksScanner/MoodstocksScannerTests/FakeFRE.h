@@ -0,0 +1,100 @@
+//
+//  FakeFRE.h
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#ifndef MoodstocksScanner_FakeFRE_h
+#define MoodstocksScanner_FakeFRE_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "ResultRing.h"
+
+// Stand-ins for the bits of the AIR runtime the extension talks to, so the
+// native side of a call can be replayed on the host: a status event queue
+// (FREDispatchStatusEventAsync) and an AS ByteArray that is reused between
+// calls (FREAcquireByteArray).
+namespace msanetest {
+
+struct FakeEvent {
+    std::string code;
+    std::string level;
+};
+
+struct FakeContext {
+    std::vector<FakeEvent> events;
+
+    void dispatch(const char *code, const char *level)
+    {
+        FakeEvent event = { code, level };
+        events.push_back(event);
+    }
+
+    size_t count(const char *code) const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < events.size(); i++)
+            n += events[i].code == code;
+        return n;
+    }
+};
+
+struct FakeByteArray {
+    std::vector<uint8_t> bytes;
+    size_t position;
+
+    FakeByteArray() : position(0) {}
+};
+
+// What drainResults() in MoodstocksScanner.mm does with the ring: grow the
+// ByteArray in powers of two when it is too small, then drain into it.
+// Returns the number of bytes written.
+inline size_t drainResults(FakeContext &context, msane::ResultRing &ring, FakeByteArray &array)
+{
+    size_t pending = ring.pendingBytes();
+    if (array.bytes.size() < pending) {
+        size_t capacity = 256;
+        while (capacity < pending) capacity <<= 1;
+        array.bytes.resize(capacity);
+    }
+
+    bool hasMore = false;
+    size_t written = array.bytes.empty() ? 0 : ring.drain(&array.bytes[0], array.bytes.size(), &hasMore);
+    if (hasMore)
+        context.dispatch("resultsAvailable", "");
+    array.position = 0;
+    return written;
+}
+
+// One record as MoodstocksScanner.as reads it back
+struct FakeRecord {
+    msane::ResultHeader header;
+    float corners[8];
+    const uint8_t *id;
+};
+
+inline bool readRecord(const FakeByteArray &array, size_t length, size_t *position, FakeRecord *record)
+{
+    if (*position + msane::kResultHeaderSize > length)
+        return false;
+    memcpy(&record->header, &array.bytes[*position], msane::kResultHeaderSize);
+    *position += msane::kResultHeaderSize;
+    if (record->header.flags & msane::ResultFlagCorners) {
+        memcpy(record->corners, &array.bytes[*position], msane::kResultCornersSize);
+        *position += msane::kResultCornersSize;
+    }
+    record->id = &array.bytes[*position];
+    *position += record->header.idLength;
+    return *position <= length;
+}
+
+} // namespace msanetest
+
+#endif
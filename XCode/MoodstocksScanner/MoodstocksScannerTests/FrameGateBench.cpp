@@ -0,0 +1,71 @@
+//
+//  FrameGateBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "FrameGate.h"
+#include "SyntheticFrames.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static const int kWidth = 640, kHeight = 480;
+
+// Cost of the gate per 640x480 frame (it has to stay under 1 ms), and the
+// searches it avoids on replayed 30 fps sequences: a hand held still with
+// some shake, a sweep to the product with motion blur, and a camera that
+// keeps refocusing
+int main()
+{
+    SyntheticScene scene(kWidth, kHeight, 11);
+    std::vector<std::vector<uint8_t> > frames(60);
+    for (size_t i = 0; i < frames.size(); i++)
+        scene.render((int) (i % 7), (int) (i % 5), (int) (i % 3), 0, 3, (unsigned) i, &frames[i]);
+
+    FrameGate gate;
+    std::vector<double> times;
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < frames.size(); i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            gate.evaluate(SyntheticScene::view(frames[i], kWidth, kHeight), (round * frames.size() + i) / 30.0);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    std::sort(times.begin(), times.end());
+    printf("640x480: median %.3f ms, p99 %.3f ms per frame\n\n", times[times.size() / 2], times[times.size() * 99 / 100]);
+
+    printf("%12s %8s %8s %8s %8s\n", "sequence", "frames", "blurred", "moving", "avoided");
+    const char *names[] = { "held still", "sweep", "refocusing" };
+    for (int s = 0; s < 3; s++) {
+        FrameGate sequenceGate;
+        std::vector<uint8_t> frame;
+        const int count = 150;
+        for (int i = 0; i < count; i++) {
+            int dx = 0, blur = 0, defocus = 0;
+            if (s == 0) {
+                dx = i % 4 == 0 ? 1 : 0;                    // shake
+            } else if (s == 1) {
+                // a second of panning onto the product, then held on it
+                dx = i < 30 ? -150 + i * 10 : 140;
+                blur = i < 30 ? 10 : 0;
+            } else {
+                defocus = (i / 15) % 2 ? 6 : 0;             // in and out of focus
+            }
+            scene.render(dx, 0, blur, defocus, 3, (unsigned) i, &frame);
+            sequenceGate.evaluate(SyntheticScene::view(frame, kWidth, kHeight), i / 30.0);
+        }
+        GateStats stats = sequenceGate.stats();
+        printf("%12s %8llu %8llu %8llu %7.0f%%\n", names[s], (unsigned long long) stats.frames,
+               (unsigned long long) stats.blurred, (unsigned long long) stats.moving,
+               100.0 * (stats.frames - stats.passed) / stats.frames);
+    }
+    return 0;
+}
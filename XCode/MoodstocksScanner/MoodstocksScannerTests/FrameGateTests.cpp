@@ -0,0 +1,114 @@
+//
+//  FrameGateTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <vector>
+
+#include "FrameGate.h"
+#include "SyntheticFrames.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static const int kWidth = 640, kHeight = 480;
+
+static GateVerdict feed(FrameGate &gate, const SyntheticScene &scene, int dx, int defocus, double now)
+{
+    std::vector<uint8_t> frame;
+    scene.render(dx, 0, 0, defocus, 2, (unsigned) (now * 1000), &frame);
+    return gate.evaluate(SyntheticScene::view(frame, kWidth, kHeight), now);
+}
+
+TEST(sharpStillFramesPass)
+{
+    SyntheticScene scene(kWidth, kHeight, 1);
+    FrameGate gate;
+    for (int i = 0; i < 10; i++)
+        CHECK(feed(gate, scene, 0, 0, i / 30.0).pass);
+    GateStats stats = gate.stats();
+    CHECK_EQ(stats.frames, 10u);
+    CHECK_EQ(stats.passed, 10u);
+}
+
+TEST(blurredFramesAreHeldBack)
+{
+    SyntheticScene scene(kWidth, kHeight, 2);
+    FrameGate gate;
+    GateVerdict sharp = feed(gate, scene, 0, 0, 0);
+    // the first out of focus frame also differs enough to count as moving
+    feed(gate, scene, 0, 8, 1 / 30.0);
+    GateVerdict blurred = feed(gate, scene, 0, 8, 2 / 30.0);
+    CHECK(blurred.sharpness < sharp.sharpness * 0.5);
+    CHECK(blurred.blurred);
+    CHECK(!blurred.moving);
+    CHECK(!blurred.pass);
+    CHECK(gate.stats().blurred >= 1);
+    CHECK_EQ(gate.stats().passed, 1u);
+}
+
+TEST(movingFramesAreHeldBack)
+{
+    SyntheticScene scene(kWidth, kHeight, 3);
+    FrameGate gate;
+    feed(gate, scene, 0, 0, 0);
+    GateVerdict moved = feed(gate, scene, 40, 0, 1 / 30.0);
+    CHECK(moved.moving);
+    CHECK(!moved.pass);
+    CHECK_EQ(gate.stats().moving, 1u);
+    // once the camera rests the next frame passes
+    CHECK(feed(gate, scene, 40, 0, 2 / 30.0).pass);
+}
+
+// A scene that cannot get any sharper, e.g. out of the focus range, is not
+// rejected forever: the peak decays with its half-life
+TEST(peakDecays)
+{
+    SyntheticScene scene(kWidth, kHeight, 4);
+    FrameGate gate;
+    feed(gate, scene, 0, 0, 0);
+    CHECK(!feed(gate, scene, 0, 8, 0.1).pass);
+    double accepted = 0;
+    for (double now = 0.2; now < 10 && accepted == 0; now += 0.1)
+        accepted = feed(gate, scene, 0, 8, now).pass ? now : 0;
+    // a bit over one half-life for the peak to fall to about this sharpness
+    CHECK(accepted > 1 && accepted < 6);
+}
+
+TEST(disabledGatePassesEverything)
+{
+    GatePolicy policy;
+    policy.enabled = false;
+    SyntheticScene scene(kWidth, kHeight, 5);
+    FrameGate gate(policy);
+    feed(gate, scene, 0, 0, 0);
+    CHECK(feed(gate, scene, 0, 8, 0.1).pass);
+    CHECK_EQ(gate.stats().frames, 0u);
+}
+
+TEST(resetForgetsThePreviousFrame)
+{
+    SyntheticScene scene(kWidth, kHeight, 6), other(kWidth, kHeight, 7);
+    FrameGate gate;
+    feed(gate, scene, 0, 0, 0);
+    gate.reset();
+    CHECK(!feed(gate, other, 0, 0, 0.1).moving);
+}
+
+TEST(tinyAndResizedPlanesPass)
+{
+    FrameGate gate;
+    std::vector<uint8_t> tiny(2 * 2, 128);
+    GrayView view = { &tiny[0], 2, 2, 2 };
+    CHECK(gate.evaluate(view, 0).pass);
+
+    // a frame sampled at another size is not compared, so it is no motion
+    SyntheticScene scene(kWidth, kHeight, 8);
+    CHECK(!feed(gate, scene, 0, 0, 0.1).moving);
+    std::vector<uint8_t> small(200 * 150, 90);
+    GrayView smaller = { &small[0], 200, 150, 200 };
+    CHECK(!gate.evaluate(smaller, 0.2).moving);
+}
@@ -0,0 +1,124 @@
+//
+//  FrameGovernorTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <chrono>
+#include <thread>
+
+#include "FrameGovernor.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// Replays `seconds` of 30 fps camera frames in virtual time, each admitted
+// frame costing `cost` seconds of CPU give or take 30%, and returns the
+// share of a core spent over the last half
+static double simulate(FrameGovernor &governor, double *now, double seconds, double cost, unsigned *state)
+{
+    const double frame = 1.0 / 30;
+    double spent = 0, end = *now + seconds;
+    for (; *now < end; *now += frame) {
+        if (!governor.admit(*now))
+            continue;
+        *state = *state * 1103515245u + 12345u;
+        double actual = cost * (0.7 + 0.6 * ((*state >> 16) % 1000) / 1000.0);
+        governor.processed(actual);
+        if (*now >= end - seconds / 2)
+            spent += actual;
+    }
+    return spent / (seconds / 2);
+}
+
+TEST(cheapFramesRunAtTheMinimumInterval)
+{
+    FrameGovernor governor;
+    double now = 0;
+    unsigned state = 1;
+    double share = simulate(governor, &now, 10, 0.002, &state);
+    GovernorStats stats = governor.stats();
+    CHECK(stats.interval == GovernorPolicy().minInterval);
+    CHECK(stats.skipped == 0);
+    CHECK(share < 0.1);
+}
+
+// The catalog grows and the search options change mid-scan: the frame
+// cost goes from 10 ms to 80 ms and back to 25 ms; CPU use stays at the
+// budget through all of it
+TEST(cpuUseStaysAtBudgetUnderVaryingLoad)
+{
+    GovernorPolicy policy;
+    policy.cpuBudget = 0.3;
+    policy.uiFrameTime = 0;
+    FrameGovernor governor(policy);
+    double now = 0;
+    unsigned state = 2;
+
+    const double costs[] = { 0.010, 0.080, 0.025, 0.150 };
+    for (int phase = 0; phase < 4; phase++) {
+        double share = simulate(governor, &now, 20, costs[phase], &state);
+        // the first phase is capped by the camera's frame rate: 10 ms x 30
+        double expected = costs[phase] * 30 < policy.cpuBudget ? costs[phase] * 30 : policy.cpuBudget;
+        CHECK(share > expected * 0.8 && share < expected * 1.2);
+    }
+    CHECK(governor.stats().interval > 0.15 * 0.7 / 0.3);
+}
+
+TEST(maxIntervalBoundsVeryExpensiveFrames)
+{
+    FrameGovernor governor;
+    double now = 0;
+    unsigned state = 3;
+    simulate(governor, &now, 20, 2.0, &state);
+    CHECK(governor.stats().interval == GovernorPolicy().maxInterval);
+}
+
+TEST(slowUiFramesLowerTheBudgetAndGoodOnesRestoreIt)
+{
+    FrameGovernor governor;
+    for (int i = 0; i < 100; i++)
+        governor.uiFrame(1.0 / 30);
+    double lowered = governor.stats().budget;
+    CHECK(lowered < 0.5 * 0.1 + 1e-9);
+
+    for (int i = 0; i < 1000; i++)
+        governor.uiFrame(1.0 / 60);
+    CHECK(governor.stats().budget == 0.5);
+}
+
+TEST(zeroBudgetAdmitsEveryFrame)
+{
+    GovernorPolicy policy;
+    policy.cpuBudget = 0;
+    FrameGovernor governor(policy);
+    governor.processed(1.0);
+    for (int i = 0; i < 30; i++)
+        CHECK(governor.admit(i / 30.0));
+    CHECK_EQ(governor.stats().skipped, 0u);
+}
+
+TEST(resetForgetsTheCost)
+{
+    FrameGovernor governor;
+    governor.admit(0);
+    governor.processed(0.5);
+    CHECK(governor.stats().interval == 1.0);
+    governor.reset();
+    CHECK(governor.stats().interval == GovernorPolicy().minInterval);
+    CHECK(governor.stats().averageCost == 0);
+}
+
+// The cost fed to the governor: waiting is free, spinning is not
+TEST(threadCpuTimeIgnoresWaiting)
+{
+    double cpu = threadCpuTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(threadCpuTime() - cpu < 0.01);
+
+    cpu = threadCpuTime();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(30);
+    while (std::chrono::steady_clock::now() < end) {}
+    CHECK(threadCpuTime() - cpu > 0.015);
+}
@@ -0,0 +1,77 @@
+//
+//  GrayJpeg.h
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#ifndef MoodstocksScanner_GrayJpeg_h
+#define MoodstocksScanner_GrayJpeg_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <jpeglib.h>
+
+// libjpeg in place of ImageIO for the server query: a single channel JPEG
+// of a luma plane, as searchServer builds it, and back. `quality` is 0 to
+// 1 like kCGImageDestinationLossyCompressionQuality.
+namespace msanetest {
+
+inline std::vector<uint8_t> encodeGrayJpeg(const uint8_t *pixels, int width, int height, float quality)
+{
+    jpeg_compress_struct c;
+    jpeg_error_mgr error;
+    c.err = jpeg_std_error(&error);
+    jpeg_create_compress(&c);
+    unsigned char *buffer = NULL;
+    unsigned long length = 0;
+    jpeg_mem_dest(&c, &buffer, &length);
+    c.image_width = width;
+    c.image_height = height;
+    c.input_components = 1;
+    c.in_color_space = JCS_GRAYSCALE;
+    jpeg_set_defaults(&c);
+    jpeg_set_quality(&c, (int) (quality * 100 + 0.5f), TRUE);
+    jpeg_start_compress(&c, TRUE);
+    while (c.next_scanline < c.image_height) {
+        JSAMPROW row = const_cast<uint8_t *>(pixels) + (size_t) c.next_scanline * width;
+        jpeg_write_scanlines(&c, &row, 1);
+    }
+    jpeg_finish_compress(&c);
+    std::vector<uint8_t> bytes(buffer, buffer + length);
+    free(buffer);
+    jpeg_destroy_compress(&c);
+    return bytes;
+}
+
+// Decodes to luma, returns the number of components of the file
+inline int decodeGrayJpeg(const std::vector<uint8_t> &bytes, std::vector<uint8_t> *plane, int *width, int *height)
+{
+    jpeg_decompress_struct d;
+    jpeg_error_mgr error;
+    d.err = jpeg_std_error(&error);
+    jpeg_create_decompress(&d);
+    jpeg_mem_src(&d, const_cast<uint8_t *>(&bytes[0]), bytes.size());
+    jpeg_read_header(&d, TRUE);
+    int components = d.num_components;
+    d.out_color_space = JCS_GRAYSCALE;
+    jpeg_start_decompress(&d);
+    *width = d.output_width;
+    *height = d.output_height;
+    plane->resize((size_t) *width * *height);
+    while (d.output_scanline < d.output_height) {
+        JSAMPROW row = &(*plane)[(size_t) d.output_scanline * *width];
+        jpeg_read_scanlines(&d, &row, 1);
+    }
+    jpeg_finish_decompress(&d);
+    jpeg_destroy_decompress(&d);
+    return components;
+}
+
+} // namespace msanetest
+
+#endif
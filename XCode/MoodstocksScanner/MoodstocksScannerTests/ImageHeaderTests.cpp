@@ -0,0 +1,97 @@
+//
+//  ImageHeaderTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <vector>
+
+#include "ImageHeader.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// SOI, an APP0 segment, then a start of frame of the given marker
+static std::vector<uint8_t> jpegWithFrame(uint8_t marker, int width, int height)
+{
+    const uint8_t head[] = {
+        0xff, 0xd8,
+        0xff, 0xe0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0,
+        0xff, 0xff,                                         // fill byte
+        0xff, 0xc4, 0x00, 0x04, 0x00, 0x00,                 // DHT, not a frame
+        0xff, marker, 0x00, 0x0b, 0x08
+    };
+    std::vector<uint8_t> bytes(head, head + sizeof(head));
+    bytes.push_back((uint8_t) (height >> 8));
+    bytes.push_back((uint8_t) height);
+    bytes.push_back((uint8_t) (width >> 8));
+    bytes.push_back((uint8_t) width);
+    bytes.push_back(1);
+    bytes.push_back(1);
+    bytes.push_back(0x11);
+    bytes.push_back(0);
+    return bytes;
+}
+
+TEST(jpegBaselineAndProgressive)
+{
+    ImageHeader header;
+    std::vector<uint8_t> baseline = jpegWithFrame(0xc0, 4032, 3024);
+    CHECK(readImageHeader(&baseline[0], baseline.size(), &header));
+    CHECK(header.format == ImageFormatJPEG && header.width == 4032 && header.height == 3024);
+
+    std::vector<uint8_t> progressive = jpegWithFrame(0xc2, 640, 480);
+    CHECK(readImageHeader(&progressive[0], progressive.size(), &header));
+    CHECK(header.width == 640 && header.height == 480);
+}
+
+TEST(jpegWithoutFrameIsRejected)
+{
+    ImageHeader header;
+    std::vector<uint8_t> bytes = jpegWithFrame(0xc0, 100, 100);
+    CHECK(!readImageHeader(&bytes[0], 30, &header));           // cut before the frame
+    CHECK(header.format == ImageFormatUnknown);
+
+    std::vector<uint8_t> scan = jpegWithFrame(0xda, 100, 100); // scan data first
+    CHECK(!readImageHeader(&scan[0], scan.size(), &header));
+
+    std::vector<uint8_t> empty = jpegWithFrame(0xc0, 0, 100);
+    CHECK(!readImageHeader(&empty[0], empty.size(), &header));
+}
+
+TEST(pngHeader)
+{
+    const uint8_t png[] = {
+        0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a,
+        0, 0, 0, 13, 'I', 'H', 'D', 'R',
+        0, 0, 0x07, 0x80, 0, 0, 0x04, 0x38, 8, 0, 0, 0, 0
+    };
+    ImageHeader header;
+    CHECK(readImageHeader(png, sizeof(png), &header));
+    CHECK(header.format == ImageFormatPNG && header.width == 1920 && header.height == 1080);
+    CHECK(!readImageHeader(png, 20, &header));
+}
+
+TEST(unknownBytes)
+{
+    const uint8_t gif[] = { 'G', 'I', 'F', '8', '9', 'a', 1, 0, 1, 0 };
+    ImageHeader header;
+    CHECK(!readImageHeader(gif, sizeof(gif), &header));
+    CHECK(header.format == ImageFormatUnknown);
+}
+
+TEST(scaledDecodeSideStaysAboveWanted)
+{
+    ImageHeader jpeg = { ImageFormatJPEG, 4032, 3024 };
+    CHECK_EQ(scaledDecodeSide(jpeg, 480), 504);     // 1/8
+    CHECK_EQ(scaledDecodeSide(jpeg, 1280), 2016);   // 1/2, 1/4 would be 1008
+    CHECK_EQ(scaledDecodeSide(jpeg, 4032), 4032);
+
+    // libjpeg rounds up, so 1/8 of 3841 is 481 and still enough
+    ImageHeader odd = { ImageFormatJPEG, 3841, 100 };
+    CHECK_EQ(scaledDecodeSide(odd, 480), 481);
+
+    ImageHeader png = { ImageFormatPNG, 4032, 3024 };
+    CHECK_EQ(scaledDecodeSide(png, 480), 4032);
+}
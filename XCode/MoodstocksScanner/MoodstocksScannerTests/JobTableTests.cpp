@@ -0,0 +1,110 @@
+//
+//  JobTableTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "FakeFRE.h"
+#include "JobTable.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+TEST(idsStartAtOneAndAreUnique)
+{
+    JobTable jobs;
+    uint32_t open = jobs.begin(JobOperationOpen);
+    uint32_t sync = jobs.begin(JobOperationSync);
+    CHECK_EQ(open, 1u);
+    CHECK_EQ(sync, 2u);
+    CHECK(jobs.isRunning(open) && jobs.isRunning(sync));
+    CHECK_EQ(jobs.runningCount(), 2u);
+}
+
+TEST(completionsCarryOperationAndError)
+{
+    JobTable jobs;
+    uint32_t open = jobs.begin(JobOperationOpen);
+    uint32_t sync = jobs.begin(JobOperationSync);
+    CHECK(jobs.finish(sync, 7));
+    CHECK(!jobs.isRunning(sync));
+
+    JobCompletion done[4];
+    bool hasMore = true;
+    CHECK_EQ(jobs.drain(done, 4, &hasMore), 1u);
+    CHECK(!hasMore);
+    CHECK(done[0].id == sync && done[0].operation == JobOperationSync && done[0].error == 7);
+    CHECK(jobs.isRunning(open));
+}
+
+TEST(unknownAndFinishedIdsAreIgnored)
+{
+    JobTable jobs;
+    uint32_t id = jobs.begin(JobOperationClose);
+    CHECK(!jobs.finish(99, 0));
+    CHECK(jobs.finish(id, 0));
+    CHECK(!jobs.finish(id, 0));
+    CHECK_EQ(jobs.completedCount(), 1u);
+}
+
+// Several jobs finishing between two drains cost ActionScript one event
+TEST(completionsAreCoalesced)
+{
+    JobTable jobs;
+    FakeContext context;
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 10; i++)
+        ids.push_back(jobs.begin(JobOperationOpen));
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (jobs.finish(ids[i], 0))
+            context.dispatch("jobsCompleted", "");
+    }
+    CHECK_EQ(context.count("jobsCompleted"), 1u);
+
+    JobCompletion done[4];
+    bool hasMore = false;
+    CHECK_EQ(jobs.drain(done, 4, &hasMore), 4u);
+    CHECK(hasMore);
+    CHECK_EQ(done[0].id, ids[0]);
+    CHECK_EQ(done[3].id, ids[3]);
+
+    // still outstanding: a job finishing now is not announced again
+    uint32_t late = jobs.begin(JobOperationSync);
+    CHECK(!jobs.finish(late, 0));
+    CHECK_EQ(jobs.drain(done, 4, &hasMore), 4u);
+    CHECK_EQ(jobs.drain(done, 4, &hasMore), 3u);
+    CHECK(!hasMore);
+    CHECK_EQ(done[2].id, late);
+
+    uint32_t next = jobs.begin(JobOperationSync);
+    CHECK(jobs.finish(next, 0));
+}
+
+TEST(finishFromManyThreads)
+{
+    JobTable jobs;
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 4000; i++)
+        ids.push_back(jobs.begin(JobOperationSync));
+
+    std::vector<std::thread> threads;
+    std::atomic<int> notifications(0);
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&jobs, &ids, &notifications, t]() {
+            for (size_t i = t; i < ids.size(); i += 4)
+                notifications += jobs.finish(ids[i], 0);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+    CHECK_EQ(notifications.load(), 1);
+    CHECK_EQ(jobs.runningCount(), 0u);
+    CHECK_EQ(jobs.completedCount(), 4000u);
+}
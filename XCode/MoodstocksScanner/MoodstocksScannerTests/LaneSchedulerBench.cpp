@@ -0,0 +1,94 @@
+//
+//  LaneSchedulerBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "LaneScheduler.h"
+
+using namespace msane;
+
+// Stub cascade for one frame: a barcode decode and an image search. Stages
+// sleep for their cost, as if each lane had a core of its own, and check
+// for cancellation before it like the extension's lanes check before the
+// SDK call.
+class StubFrame : public LaneJob {
+public:
+    StubFrame() : barcode(false), image(false), decodeCost(0), searchCost(0), imageFirst(false) {}
+
+    bool barcode, image;
+    double decodeCost, searchCost;      // seconds
+    bool imageFirst;                    // cascade order, lane 0 is the first stage
+
+    bool stage(bool search)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(search ? searchCost : decodeCost));
+        return search ? image : barcode;
+    }
+
+    virtual bool runLane(int lane, const std::atomic<bool> &cancelled)
+    {
+        if (cancelled)
+            return false;
+        return stage((lane == 0) == imageFirst);
+    }
+};
+
+static double percentile(std::vector<double> values, int p)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() * p / 100];
+}
+
+// Frame latency p50/p99 of the sequential cascade against parallel lanes:
+// decode 3 ms and search 12 ms on average (+-50%), 30% of the frames show
+// a barcode and 30% an image
+int main()
+{
+    const int frames = 400;
+    std::vector<StubFrame> jobs(frames);
+    for (int i = 0; i < frames; i++) {
+        jobs[i].barcode = (i * 37) % 10 < 3;
+        jobs[i].image = (i * 53 + 5) % 10 < 3;
+        jobs[i].decodeCost = 0.003 * (0.5 + (double) ((i * 7919) % 100) / 100);
+        jobs[i].searchCost = 0.012 * (0.5 + (double) ((i * 104729) % 100) / 100);
+    }
+
+    LaneScheduler lanes(2);
+    printf("%d frames, decode ~3 ms, search ~12 ms, 30%% barcodes, 30%% images\n", frames);
+    printf("%14s %12s %12s %12s %12s\n", "", "seq p50 ms", "seq p99 ms", "lanes p50", "lanes p99");
+    const char *names[] = { "barcode first", "image first" };
+    for (int order = 0; order < 2; order++) {
+        std::vector<double> sequential, parallel;
+        for (int i = 0; i < frames; i++) {
+            StubFrame &job = jobs[i];
+            job.imageFirst = order == 1;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!job.stage(job.imageFirst))
+                job.stage(!job.imageFirst);
+            sequential.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+            start = std::chrono::steady_clock::now();
+            lanes.run(&job, 2);
+            parallel.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            // the scan queue settles the loser before the next frame
+            lanes.settle();
+        }
+        printf("%14s %12.1f %12.1f %12.1f %12.1f\n", names[order],
+               percentile(sequential, 50), percentile(sequential, 99),
+               percentile(parallel, 50), percentile(parallel, 99));
+    }
+    LaneStats stats = lanes.stats();
+    printf("\n%llu runs, %llu answered before the slower lane was done\n",
+           (unsigned long long) stats.runs, (unsigned long long) stats.early);
+    return 0;
+}
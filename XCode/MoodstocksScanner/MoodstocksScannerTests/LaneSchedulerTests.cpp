@@ -0,0 +1,223 @@
+//
+//  LaneSchedulerTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "FrameGovernor.h"
+#include "LaneScheduler.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// Stub stages: each lane sleeps or spins for its delay, then hits or misses.
+// A lane with `untilCancelled` only returns once another lane has won.
+class StubLanes : public LaneJob {
+public:
+    StubLanes() : spin(false)
+    {
+        for (int i = 0; i < kMaxLanes; i++) {
+            hit[i] = false;
+            delay[i] = 0;
+            untilCancelled[i] = false;
+            runs[i] = 0;
+            sawCancel[i] = false;
+        }
+    }
+
+    bool hit[kMaxLanes];
+    int delay[kMaxLanes];                       // milliseconds
+    bool untilCancelled[kMaxLanes];
+    bool spin;                                  // burn the delay in CPU time instead of sleeping
+    std::atomic<int> runs[kMaxLanes];
+    std::atomic<bool> sawCancel[kMaxLanes];
+
+    virtual bool runLane(int lane, const std::atomic<bool> &cancelled)
+    {
+        runs[lane]++;
+        if (spin) {
+            double end = threadCpuTime() + delay[lane] / 1e3;
+            while (threadCpuTime() < end) {}
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay[lane]));
+        }
+        if (untilCancelled[lane]) {
+            while (!cancelled)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (cancelled) {
+            sawCancel[lane] = true;
+            return false;
+        }
+        return hit[lane];
+    }
+};
+
+TEST(firstHitWins)
+{
+    LaneScheduler lanes(2);
+    StubLanes job;
+    job.delay[0] = 60;
+    job.hit[1] = true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CHECK_EQ(lanes.run(&job, 2), 1);
+    double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(waited < 50);                         // not held up by the slow lane
+
+    lanes.settle();
+    CHECK(job.sawCancel[0]);
+    LaneStats stats = lanes.stats();
+    CHECK_EQ(stats.runs, 1u);
+    CHECK_EQ(stats.early, 1u);
+}
+
+TEST(losingLaneIsCancelled)
+{
+    LaneScheduler lanes(2);
+    StubLanes job;
+    job.hit[0] = true;
+    job.untilCancelled[1] = true;
+
+    CHECK_EQ(lanes.run(&job, 2), 0);
+    lanes.settle();                             // would hang if never cancelled
+    CHECK_EQ(job.runs[1].load(), 1);
+    CHECK(job.sawCancel[1]);
+}
+
+TEST(allMissWaitsForEveryLane)
+{
+    LaneScheduler lanes(2);
+    StubLanes job;
+    job.delay[0] = 5;
+    job.delay[1] = 20;
+
+    CHECK_EQ(lanes.run(&job, 2), -1);
+    CHECK_EQ(job.runs[0].load(), 1);
+    CHECK_EQ(job.runs[1].load(), 1);
+    CHECK(!job.sawCancel[0] && !job.sawCancel[1]);
+    CHECK_EQ(lanes.stats().early, 0u);
+}
+
+TEST(moreLanesThanThreads)
+{
+    LaneScheduler lanes(1);
+    StubLanes job;
+    job.hit[3] = true;
+
+    CHECK_EQ(lanes.run(&job, 4), 3);
+    for (int lane = 0; lane < 4; lane++)
+        CHECK_EQ(job.runs[lane].load(), 1);
+    CHECK_EQ(lanes.stats().early, 0u);
+}
+
+TEST(laneCountIsClamped)
+{
+    LaneScheduler lanes(2);
+    StubLanes job;
+    CHECK_EQ(lanes.run(&job, 0), -1);
+    CHECK_EQ(lanes.stats().runs, 0u);
+
+    CHECK_EQ(lanes.run(&job, kMaxLanes + 3), -1);
+    int ran = 0;
+    for (int lane = 0; lane < kMaxLanes; lane++)
+        ran += job.runs[lane];
+    CHECK_EQ(ran, kMaxLanes);
+}
+
+TEST(nextRunWaitsForCancelledLanes)
+{
+    LaneScheduler lanes(2);
+    StubLanes first;
+    first.hit[0] = true;
+    first.delay[1] = 30;                        // still sleeping when lane 0 wins
+
+    StubLanes second;
+    second.hit[1] = true;
+    for (int round = 0; round < 20; round++) {
+        CHECK_EQ(lanes.run(&first, 2), 0);
+        CHECK_EQ(lanes.run(&second, 2), 1);
+    }
+    lanes.settle();
+    CHECK_EQ(first.runs[1].load(), 20);
+    CHECK_EQ(second.runs[0].load(), 20);
+    CHECK_EQ(lanes.stats().runs, 40u);
+}
+
+TEST(cpuTimeOfEveryLane)
+{
+    LaneScheduler lanes(2);
+    StubLanes job;
+    job.spin = true;
+    job.delay[0] = 20;
+    job.delay[1] = 20;
+
+    double before = threadCpuTime();
+    CHECK_EQ(lanes.run(&job, 2), -1);
+    double caller = threadCpuTime() - before;
+    double cpu = lanes.stats().cpuTime;
+    CHECK(cpu >= 0.039);                        // two lanes of 20 ms
+    CHECK(caller < 0.010);                      // the caller slept meanwhile
+
+    CHECK_EQ(lanes.settle(&job), cpu);
+    CHECK_EQ(lanes.settle(&job), 0.0);          // handed out once
+}
+
+// Two scan queues sharing the pool, as two extension contexts do: each
+// caller gets the winner of its own job and only its own lanes are
+// cancelled
+TEST(concurrentCallersGetTheirOwnWinner)
+{
+    LaneScheduler lanes(2);
+    const int rounds = 3000;
+    std::atomic<int> wrong(0);
+    std::thread callers[2];
+    for (int c = 0; c < 2; c++) {
+        callers[c] = std::thread([&lanes, &wrong, c] {
+            StubLanes job;
+            job.hit[c] = true;                  // lane 0 wins one job, lane 1 the other
+            for (int i = 0; i < rounds; i++) {
+                if (lanes.run(&job, 2) != c)
+                    wrong++;
+                lanes.settle(&job);
+                if (job.sawCancel[c])
+                    wrong++;
+            }
+        });
+    }
+    callers[0].join();
+    callers[1].join();
+    CHECK_EQ(wrong.load(), 0);
+    CHECK_EQ(lanes.stats().runs, 2u * rounds);
+}
+
+// settle(job) hands out the CPU of that job's lanes, not of the other
+// caller's running meanwhile
+TEST(cpuTimeOfEachCaller)
+{
+    LaneScheduler lanes(2);
+    double cpu[2] = { 0, 0 };
+    std::thread callers[2];
+    for (int c = 0; c < 2; c++) {
+        callers[c] = std::thread([&lanes, &cpu, c] {
+            StubLanes job;
+            job.spin = true;
+            job.delay[0] = 5 + c * 5;
+            job.delay[1] = 5 + c * 5;
+            for (int i = 0; i < 10; i++) {
+                lanes.run(&job, 2);
+                cpu[c] += lanes.settle(&job);
+            }
+        });
+    }
+    callers[0].join();
+    callers[1].join();
+    CHECK(cpu[0] >= 0.099 && cpu[0] < 0.150);   // 10 runs of two 5 ms lanes
+    CHECK(cpu[1] >= 0.199 && cpu[1] < 0.250);   // 10 runs of two 10 ms lanes
+    CHECK(lanes.stats().cpuTime >= cpu[0] + cpu[1] - 1e-9);
+}
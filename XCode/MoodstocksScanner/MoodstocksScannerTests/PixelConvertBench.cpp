@@ -0,0 +1,95 @@
+//
+//  PixelConvertBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "PixelConvert.h"
+
+using namespace msane;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What scanBitmapData() would do without the library: per pixel float
+// luma through the lineStride32 and inverted row lookup
+static void naiveBitmapToGray(const BitmapView &src, const GrayView &dst)
+{
+    for (int y = 0; y < src.height; y++) {
+        int row = src.invertedY ? src.height - 1 - y : y;
+        for (int x = 0; x < src.width; x++) {
+            uint32_t p = src.bits[(size_t) row * src.lineStride32 + x];
+            float luma = 0.299f * ((p >> 16) & 255) + 0.587f * ((p >> 8) & 255) + 0.114f * (p & 255);
+            dst.pixels[(size_t) y * dst.stride + x] = (uint8_t) (luma + 0.5f);
+        }
+    }
+}
+
+int main()
+{
+    const int sizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+
+    printf("BitmapData to gray, kernel %s\n", kernelName(activeKernel()));
+    printf("%10s %12s %12s %12s\n", "size", "naive ms", "library ms", "speedup");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        std::vector<uint32_t> bits((size_t) width * height);
+        for (size_t i = 0; i < bits.size(); i++)
+            bits[i] = (uint32_t) rand() | 0xff000000u;
+        std::vector<uint8_t> gray((size_t) width * height);
+        BitmapView src = { &bits[0], width, height, width, true, false, false };
+        GrayView dst = { &gray[0], width, height, width };
+
+        const int frames = 50;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            naiveBitmapToGray(src, dst);
+        double naive = secondsSince(start) / frames;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            convertBitmapToGray(src, dst);
+        double library = secondsSince(start) / frames;
+
+        printf("%5dx%-4d %12.3f %12.3f %11.1fx\n", width, height, naive * 1e3, library * 1e3, naive / library);
+    }
+
+    // camera frames: BGRA to upright gray per kernel, unrotated and portrait
+    const ConvertKernel kernels[] = { ConvertKernelScalar, ConvertKernelSSE4, ConvertKernelAVX2, ConvertKernelNEON };
+    printf("\nBGRA to gray, megapixels/s\n%8s %12s %12s %12s\n", "kernel", "size", "rotation 0", "rotation 90");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(*kernels); k++) {
+        if (!selectKernel(kernels[k]))
+            continue;
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+            int width = sizes[s][0], height = sizes[s][1];
+            std::vector<uint8_t> pixels((size_t) width * height * 4);
+            for (size_t i = 0; i < pixels.size(); i++)
+                pixels[i] = (uint8_t) rand();
+            std::vector<uint8_t> gray((size_t) width * height);
+            ColorView src = { &pixels[0], width, height, width * 4, PixelLayoutBGRA, false, false };
+            CropRect all = { 0, 0, width, height };
+
+            double rate[2];
+            for (int r = 0; r < 2; r++) {
+                Rotation rotation = r == 0 ? Rotation0 : Rotation90;
+                GrayView dst = { &gray[0], r == 0 ? width : height, r == 0 ? height : width, r == 0 ? width : height };
+                const int frames = 100;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int i = 0; i < frames; i++)
+                    convertToGray(src, all, rotation, dst);
+                rate[r] = (double) width * height * frames / secondsSince(start) / 1e6;
+            }
+            printf("%8s %7dx%-4d %12.0f %12.0f\n", kernelName(kernels[k]), width, height, rate[0], rate[1]);
+        }
+    }
+    return 0;
+}
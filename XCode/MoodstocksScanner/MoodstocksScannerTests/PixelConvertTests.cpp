@@ -0,0 +1,224 @@
+//
+//  PixelConvertTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "PixelConvert.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// ARGB32 in host endianness, i.e. B, G, R, A in memory
+static uint32_t argb(uint32_t a, uint32_t r, uint32_t g, uint32_t b)
+{
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static std::vector<uint32_t> randomBitmap(int stride, int height, unsigned seed)
+{
+    std::vector<uint32_t> bits((size_t) stride * height);
+    srand(seed);
+    for (size_t i = 0; i < bits.size(); i++)
+        bits[i] = argb(255, rand() & 255, rand() & 255, rand() & 255);
+    return bits;
+}
+
+static uint8_t expectedLuma(uint32_t pixel)
+{
+    return lumaOf((pixel >> 16) & 255, (pixel >> 8) & 255, pixel & 255);
+}
+
+TEST(bitmapHonoursLineStride)
+{
+    const int width = 37, stride = 48, height = 5;
+    std::vector<uint32_t> bits = randomBitmap(stride, height, 1);
+    BitmapView src = { &bits[0], width, height, stride, false, false, false };
+    std::vector<uint8_t> gray(width * height);
+    GrayView dst = { &gray[0], width, height, width };
+
+    convertBitmapToGray(src, dst);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            CHECK_EQ(gray[y * width + x], expectedLuma(bits[y * stride + x]));
+}
+
+TEST(bitmapInvertedYIsFlipped)
+{
+    const int width = 20, height = 7;
+    std::vector<uint32_t> bits = randomBitmap(width, height, 2);
+    BitmapView src = { &bits[0], width, height, width, true, false, false };
+    std::vector<uint8_t> gray(width * height);
+    GrayView dst = { &gray[0], width, height, width };
+
+    convertBitmapToGray(src, dst);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            CHECK_EQ(gray[y * width + x], expectedLuma(bits[(height - 1 - y) * width + x]));
+}
+
+TEST(bitmapPremultipliedIsUnpremultiplied)
+{
+    // mid gray at half opacity, premultiplied: 128 * 128 / 255 = 64
+    uint32_t bits[3] = { argb(128, 64, 64, 64), argb(0, 0, 0, 0), argb(255, 200, 200, 200) };
+    uint8_t gray[3];
+    GrayView dst = { gray, 3, 1, 3 };
+
+    BitmapView src = { bits, 3, 1, 3, false, true, true };
+    convertBitmapToGray(src, dst);
+    CHECK(abs(gray[0] - 128) <= 1);
+    CHECK_EQ(gray[1], 0);
+    CHECK_EQ(gray[2], 200);
+
+    // an opaque bitmap never is, whatever the premultiplied flag says
+    BitmapView opaque = { bits, 3, 1, 3, false, true, false };
+    convertBitmapToGray(opaque, dst);
+    CHECK_EQ(gray[0], 64);
+}
+
+TEST(bitmapCropIsBoundsChecked)
+{
+    const int width = 16, height = 16;
+    std::vector<uint32_t> bits = randomBitmap(width, height, 3);
+    BitmapView src = { &bits[0], width, height, width, true, false, false };
+    std::vector<uint8_t> gray(8 * 4);
+    GrayView dst = { &gray[0], 8, 4, 8 };
+
+    CropRect crop = { 4, 10, 8, 4 };
+    CHECK(convertBitmapToGray(src, crop, dst));
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 8; x++)
+            CHECK_EQ(gray[y * 8 + x], expectedLuma(bits[(height - 1 - (10 + y)) * width + 4 + x]));
+
+    CropRect outside = { 10, 10, 8, 4 };
+    CHECK(!convertBitmapToGray(src, outside, dst));
+    CropRect tooBig = { 0, 0, 9, 4 };
+    CHECK(!convertBitmapToGray(src, tooBig, dst));
+}
+
+//
+//  Kernels, rotation and crop
+//
+
+static std::vector<ConvertKernel> supportedKernels()
+{
+    ConvertKernel saved = activeKernel();
+    std::vector<ConvertKernel> kernels;
+    const ConvertKernel all[] = { ConvertKernelScalar, ConvertKernelSSE4, ConvertKernelAVX2, ConvertKernelNEON };
+    for (size_t i = 0; i < sizeof(all) / sizeof(*all); i++) {
+        if (selectKernel(all[i]))
+            kernels.push_back(all[i]);
+    }
+    selectKernel(saved);
+    return kernels;
+}
+
+// Straightforward reference: luma of source pixel (x, y) of the crop lands
+// where a clockwise rotation puts it
+static std::vector<uint8_t> referenceGray(const std::vector<uint8_t> &pixels, const ColorView &src,
+                                          const CropRect &crop, Rotation rotation)
+{
+    bool swapped = rotation == Rotation90 || rotation == Rotation270;
+    int outWidth = swapped ? crop.height : crop.width;
+    std::vector<uint8_t> out((size_t) crop.width * crop.height);
+    for (int y = 0; y < crop.height; y++) {
+        for (int x = 0; x < crop.width; x++) {
+            int row = src.invertedY ? src.height - 1 - (crop.y + y) : crop.y + y;
+            const uint8_t *p = &pixels[(size_t) row * src.stride + (size_t) (crop.x + x) * 4];
+            uint8_t luma = src.layout == PixelLayoutBGRA ? lumaOf(p[2], p[1], p[0]) : lumaOf(p[0], p[1], p[2]);
+            int dx = x, dy = y;
+            switch (rotation) {
+                case Rotation0:   break;
+                case Rotation90:  dx = crop.height - 1 - y; dy = x; break;
+                case Rotation180: dx = crop.width - 1 - x; dy = crop.height - 1 - y; break;
+                case Rotation270: dx = y; dy = crop.width - 1 - x; break;
+            }
+            out[(size_t) dy * outWidth + dx] = luma;
+        }
+    }
+    return out;
+}
+
+static std::vector<uint8_t> randomPixels(size_t bytes, unsigned seed)
+{
+    std::vector<uint8_t> pixels(bytes);
+    srand(seed);
+    for (size_t i = 0; i < bytes; i++)
+        pixels[i] = (uint8_t) rand();
+    return pixels;
+}
+
+TEST(everyKernelMatchesTheReference)
+{
+    ConvertKernel saved = activeKernel();
+    std::vector<ConvertKernel> kernels = supportedKernels();
+    CHECK(kernels.size() >= 1 && kernels[0] == ConvertKernelScalar);
+
+    // odd widths exercise the scalar tails of the vector kernels
+    const int widths[] = { 1, 15, 16, 17, 31, 33, 129, 300 };
+    for (size_t k = 0; k < kernels.size(); k++) {
+        CHECK(selectKernel(kernels[k]));
+        for (size_t w = 0; w < sizeof(widths) / sizeof(*widths); w++) {
+            for (int layout = PixelLayoutBGRA; layout <= PixelLayoutRGBA; layout++) {
+                int width = widths[w], height = 3, stride = width * 4 + 12;
+                std::vector<uint8_t> pixels = randomPixels((size_t) stride * height, (unsigned) (width + layout));
+                ColorView src = { &pixels[0], width, height, stride, (PixelLayout) layout, false, false };
+                CropRect all = { 0, 0, width, height };
+                std::vector<uint8_t> gray((size_t) width * height);
+                GrayView dst = { &gray[0], width, height, width };
+                CHECK(convertToGray(src, all, Rotation0, dst));
+                CHECK(gray == referenceGray(pixels, src, all, Rotation0));
+            }
+        }
+    }
+    selectKernel(saved);
+}
+
+TEST(rotationAndCropInOnePass)
+{
+    const int width = 300, height = 170, stride = width * 4;
+    std::vector<uint8_t> pixels = randomPixels((size_t) stride * height, 7);
+    const CropRect crops[] = { { 0, 0, width, height }, { 13, 21, 150, 37 }, { 290, 160, 10, 10 } };
+
+    for (int inverted = 0; inverted < 2; inverted++) {
+        ColorView src = { &pixels[0], width, height, stride, PixelLayoutBGRA, inverted != 0, false };
+        for (size_t c = 0; c < sizeof(crops) / sizeof(*crops); c++) {
+            for (int rotation = Rotation0; rotation <= Rotation270; rotation++) {
+                const CropRect &crop = crops[c];
+                bool swapped = rotation == Rotation90 || rotation == Rotation270;
+                int outWidth = swapped ? crop.height : crop.width;
+                int outHeight = swapped ? crop.width : crop.height;
+                std::vector<uint8_t> gray((size_t) outWidth * outHeight);
+                GrayView dst = { &gray[0], outWidth, outHeight, outWidth };
+                CHECK(convertToGray(src, crop, (Rotation) rotation, dst));
+                CHECK(gray == referenceGray(pixels, src, crop, (Rotation) rotation));
+            }
+        }
+    }
+}
+
+TEST(rotationForEachVideoOrientation)
+{
+    CHECK_EQ(rotationForVideoOrientation(VideoOrientationLandscapeRight), Rotation0);
+    CHECK_EQ(rotationForVideoOrientation(VideoOrientationPortrait), Rotation90);
+    CHECK_EQ(rotationForVideoOrientation(VideoOrientationLandscapeLeft), Rotation180);
+    CHECK_EQ(rotationForVideoOrientation(VideoOrientationPortraitUpsideDown), Rotation270);
+}
+
+TEST(destinationMustFitTheRotatedCrop)
+{
+    std::vector<uint8_t> pixels(40 * 20 * 4);
+    ColorView src = { &pixels[0], 40, 20, 160, PixelLayoutBGRA, false, false };
+    CropRect all = { 0, 0, 40, 20 };
+    std::vector<uint8_t> gray(40 * 20);
+    GrayView landscape = { &gray[0], 40, 20, 40 };
+    GrayView portrait = { &gray[0], 20, 40, 20 };
+    CHECK(convertToGray(src, all, Rotation0, landscape));
+    CHECK(!convertToGray(src, all, Rotation90, landscape));
+    CHECK(convertToGray(src, all, Rotation270, portrait));
+}
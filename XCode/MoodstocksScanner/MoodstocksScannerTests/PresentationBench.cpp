@@ -0,0 +1,77 @@
+//
+//  PresentationBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ScannerPool.h"
+#include "StubScanner.h"
+#include "Timeline.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static void startCamera()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+// Time to first frame of `presentations` runs of the camera UI, from
+// runScanner to the first frame, the way showCam: and hideCam handle the
+// scanner: reopened on every presentation before, or kept open while a
+// reference or the pool holds it now.
+static std::vector<double> present(StubScanner &scanner, int presentations, bool keepOpen)
+{
+    ScannerPool pool;
+    Timeline timeline;
+    std::vector<double> times;
+    for (int i = 0; i < presentations; i++) {
+        timeline.start();
+        if (!keepOpen || !pool.touch("key")) {
+            scanner.open();
+            pool.insert("key", 0);
+        }
+        startCamera();
+        timeline.mark("camera");
+        times.push_back(timeline.marks()[0].milliseconds);
+
+        if (!keepOpen) {
+            scanner.close();
+            pool.remove("key");
+        }
+    }
+    return times;
+}
+
+int main(int argc, char *argv[])
+{
+    const int presentations = 5;
+    size_t megabytes = argc > 1 ? (size_t) atoi(argv[1]) : 32;
+    std::string path = "/tmp/msane-stub-scanner.db";
+
+    if (!writeStubDatabase(path, megabytes))
+        return 1;
+
+    StubScanner scanner(path);
+    printf("stub database of %zu MB, time to first frame in ms\n", megabytes);
+    printf("%14s %10s %10s %10s\n", "presentation", "first", "repeat", "repeat avg");
+    for (int keepOpen = 0; keepOpen < 2; keepOpen++) {
+        std::vector<double> times = present(scanner, presentations, keepOpen != 0);
+        double repeat = 0;
+        for (int i = 1; i < presentations; i++)
+            repeat += times[i];
+        printf("%14s %10.1f %10.1f %10.1f\n", keepOpen ? "kept open" : "reopened", times[0], times[1],
+               repeat / (presentations - 1));
+    }
+    remove(path.c_str());
+    return scanner.index() == 1 ? 1 : 0;
+}
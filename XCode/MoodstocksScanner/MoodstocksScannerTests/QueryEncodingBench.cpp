@@ -0,0 +1,97 @@
+//
+//  QueryEncodingBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "GrayJpeg.h"
+#include "Resample.h"
+#include "SyntheticFrames.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static const int kWidth = 640, kHeight = 480;
+
+// Mean SSIM over 8x8 blocks
+static double ssim(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b, int width, int height)
+{
+    const double c1 = 6.5025, c2 = 58.5225;
+    double total = 0;
+    int blocks = 0;
+    for (int by = 0; by + 8 <= height; by += 8) {
+        for (int bx = 0; bx + 8 <= width; bx += 8) {
+            double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            for (int y = by; y < by + 8; y++) {
+                for (int x = bx; x < bx + 8; x++) {
+                    double va = a[(size_t) y * width + x], vb = b[(size_t) y * width + x];
+                    sa += va;
+                    sb += vb;
+                    saa += va * va;
+                    sbb += vb * vb;
+                    sab += va * vb;
+                }
+            }
+            double ma = sa / 64, mb = sb / 64;
+            double va = saa / 64 - ma * ma, vb = sbb / 64 - mb * mb, cov = sab / 64 - ma * mb;
+            total += (2 * ma * mb + c1) * (2 * cov + c2) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            blocks++;
+        }
+    }
+    return total / blocks;
+}
+
+// The server query of searchServer at each quality. MSImage only takes
+// pixels, so the JPEG is decoded again and the SDK encodes its own upload;
+// its encoder is opaque, a q90 JPEG of what it is handed stands in for it.
+// "prepared" is what serverFallbackStats reports, "upload" the stand-in's
+// size, SSIM is against the noise-free frame.
+int main()
+{
+    const int frames = 12;
+    SyntheticScene scene(kWidth, kHeight, 5);
+    int queryWidth, queryHeight;
+    querySizeFor(kWidth, kHeight, ScanTargetImage, &queryWidth, &queryHeight);
+    Resampler resampler;
+
+    printf("%d synthetic %dx%d frames, noise +-5, to %dx%d queries\n", frames, kWidth, kHeight, queryWidth, queryHeight);
+    printf("%10s %12s %12s %8s %10s\n", "quality", "prepared B", "upload B", "SSIM", "prep ms");
+    const float qualities[] = { 0, 0.9f, 0.7f, 0.5f };
+    for (int q = 0; q < 4; q++) {
+        double prepared = 0, upload = 0, similarity = 0, time = 0;
+        for (int i = 0; i < frames; i++) {
+            std::vector<uint8_t> noisy, clean;
+            scene.render(i * 7 - 40, i * 5 - 30, 0, 0, 5, (unsigned) i, &noisy);
+            scene.render(i * 7 - 40, i * 5 - 30, 0, 0, 0, 0, &clean);
+            std::vector<uint8_t> query((size_t) queryWidth * queryHeight), reference(query.size());
+            GrayView dst = { &query[0], queryWidth, queryHeight, queryWidth };
+            GrayView cleanDst = { &reference[0], queryWidth, queryHeight, queryWidth };
+            resampler.resample(SyntheticScene::view(noisy, kWidth, kHeight), dst);
+            resampler.resample(SyntheticScene::view(clean, kWidth, kHeight), cleanDst);
+
+            std::vector<uint8_t> handed = query;
+            if (qualities[q] > 0) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                std::vector<uint8_t> jpeg = encodeGrayJpeg(&query[0], queryWidth, queryHeight, qualities[q]);
+                int width, height;
+                decodeGrayJpeg(jpeg, &handed, &width, &height);
+                time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                prepared += jpeg.size();
+            }
+            upload += encodeGrayJpeg(&handed[0], queryWidth, queryHeight, 0.9f).size();
+            similarity += ssim(handed, reference, queryWidth, queryHeight);
+        }
+        if (qualities[q] > 0)
+            printf("%10.1f %12.0f %12.0f %8.3f %10.2f\n", qualities[q], prepared / frames, upload / frames,
+                   similarity / frames, time / frames);
+        else
+            printf("%10s %12s %12.0f %8.3f %10s\n", "raw", "-", upload / frames, similarity / frames, "-");
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+//
+//  QueryEncodingTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "GrayJpeg.h"
+#include "Resample.h"
+#include "SyntheticFrames.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// The query searchServer prepares from a 640x480 plane
+static std::vector<uint8_t> noisyQuery(int *width, int *height)
+{
+    SyntheticScene scene(640, 480, 3);
+    std::vector<uint8_t> frame;
+    scene.render(0, 0, 0, 0, 5, 1, &frame);
+    querySizeFor(640, 480, ScanTargetImage, width, height);
+    std::vector<uint8_t> query((size_t) *width * *height);
+    GrayView dst = { &query[0], *width, *height, *width };
+    Resampler resampler;
+    resampler.resample(SyntheticScene::view(frame, 640, 480), dst);
+    return query;
+}
+
+TEST(queryIsASingleChannelJpegOfTheMinimumSize)
+{
+    int width, height;
+    std::vector<uint8_t> query = noisyQuery(&width, &height);
+    CHECK_EQ(width, kQueryMinLongestSide);
+    CHECK_EQ(height, 360);
+
+    std::vector<uint8_t> jpeg = encodeGrayJpeg(&query[0], width, height, 0.7f);
+    std::vector<uint8_t> decoded;
+    int decodedWidth, decodedHeight;
+    CHECK_EQ(decodeGrayJpeg(jpeg, &decoded, &decodedWidth, &decodedHeight), 1);
+    CHECK_EQ(decodedWidth, width);
+    CHECK_EQ(decodedHeight, height);
+
+    // what the SDK gets back stays close to the plane
+    long error = 0;
+    for (size_t i = 0; i < query.size(); i++)
+        error += labs((long) decoded[i] - query[i]);
+    CHECK((double) error / query.size() < 4);
+}
+
+TEST(lowerQualityPreparesFewerBytes)
+{
+    int width, height;
+    std::vector<uint8_t> query = noisyQuery(&width, &height);
+    size_t q90 = encodeGrayJpeg(&query[0], width, height, 0.9f).size();
+    size_t q70 = encodeGrayJpeg(&query[0], width, height, 0.7f).size();
+    size_t q50 = encodeGrayJpeg(&query[0], width, height, 0.5f).size();
+    CHECK(q70 < q90);
+    CHECK(q50 < q70);
+    CHECK(q70 < query.size() / 4);
+}
+
+// The SDK encodes the upload from the decoded pixels, a q90 JPEG stands in
+// for it: smaller than from the raw plane, larger than the prepared JPEG,
+// which is why the stats do not call it the upload size
+TEST(preparedBytesAreNotTheUpload)
+{
+    int width, height;
+    std::vector<uint8_t> query = noisyQuery(&width, &height);
+    std::vector<uint8_t> prepared = encodeGrayJpeg(&query[0], width, height, 0.7f);
+    std::vector<uint8_t> decoded;
+    decodeGrayJpeg(prepared, &decoded, &width, &height);
+
+    size_t upload = encodeGrayJpeg(&decoded[0], width, height, 0.9f).size();
+    size_t rawUpload = encodeGrayJpeg(&query[0], width, height, 0.9f).size();
+    CHECK(upload < rawUpload);
+    CHECK(upload > prepared.size());
+}
@@ -0,0 +1,93 @@
+//
+//  RegionOfInterestBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "FrameGate.h"
+#include "PixelConvert.h"
+#include "RegionOfInterest.h"
+#include "Resample.h"
+#include "SceneCache.h"
+#include "SyntheticFrames.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static const int kWidth = 1280, kHeight = 720;
+
+// Per frame work of scanBitmapData on 720p Stage3D bitmaps, the whole
+// frame vs the default centre region: conversion to gray, scene hash,
+// frame gate and the query handed to imageWithGrayscalePixels:, for image
+// matching (480 wide) and barcodes (as large as allowed)
+int main()
+{
+    SyntheticScene scene(kWidth, kHeight, 9);
+    std::vector<std::vector<uint32_t> > bitmaps(30);
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        std::vector<uint8_t> frame;
+        scene.render((int) (i % 5), (int) (i % 3), 0, 0, 3, (unsigned) i, &frame);
+        bitmaps[i].resize(frame.size());
+        for (size_t p = 0; p < frame.size(); p++)
+            bitmaps[i][p] = 0xff000000u | frame[p] * 0x010101u;
+    }
+
+    printf("%dx%d BitmapData frames, ms per frame\n", kWidth, kHeight);
+    printf("%10s %8s %10s %10s %10s %10s %12s\n", "target", "region", "convert", "hash+gate", "query", "total",
+           "query size");
+    const ScanTarget targets[] = { ScanTargetImage, ScanTargetBarcode };
+    const char *targetNames[] = { "image", "barcode" };
+    for (int t = 0; t < 2; t++) {
+        for (int cropped = 0; cropped < 2; cropped++) {
+            RoiPolicy policy;
+            policy.enabled = cropped != 0;
+            policy.fallbackMisses = 0;
+            RegionOfInterest region(policy);
+            FrameGate gate;
+            Resampler resampler;
+            std::vector<uint8_t> gray((size_t) kWidth * kHeight);
+            std::vector<uint8_t> query((size_t) kQueryMaxSide * kQueryMaxSide);
+            int queryWidth = 0, queryHeight = 0;
+            double convert = 0, measure = 0, prepare = 0;
+
+            const int rounds = 10;
+            for (int round = 0; round < rounds; round++) {
+                for (size_t i = 0; i < bitmaps.size(); i++) {
+                    BitmapView bitmap = { &bitmaps[i][0], kWidth, kHeight, kWidth, true, false, false };
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    CropRect crop;
+                    region.next(kWidth, kHeight, &crop);
+                    GrayView plane = { &gray[0], crop.width, crop.height, crop.width };
+                    convertBitmapToGray(bitmap, crop, plane);
+                    std::chrono::steady_clock::time_point converted = std::chrono::steady_clock::now();
+
+                    sceneHash(plane);
+                    gate.evaluate(plane, (round * bitmaps.size() + i) / 30.0);
+                    std::chrono::steady_clock::time_point measured = std::chrono::steady_clock::now();
+
+                    querySizeFor(crop.width, crop.height, targets[t], &queryWidth, &queryHeight);
+                    GrayView dst = { &query[0], queryWidth, queryHeight, queryWidth };
+                    if (queryWidth != crop.width || queryHeight != crop.height)
+                        resampler.resample(plane, dst);
+                    std::chrono::steady_clock::time_point prepared = std::chrono::steady_clock::now();
+
+                    convert += std::chrono::duration<double, std::milli>(converted - start).count();
+                    measure += std::chrono::duration<double, std::milli>(measured - converted).count();
+                    prepare += std::chrono::duration<double, std::milli>(prepared - measured).count();
+                    region.scanned(cropped != 0, false);
+                }
+            }
+            double frames = rounds * bitmaps.size();
+            printf("%10s %8s %10.3f %10.3f %10.3f %10.3f %7dx%-4d\n", targetNames[t], cropped ? "centre" : "full",
+                   convert / frames, measure / frames, prepare / frames, (convert + measure + prepare) / frames,
+                   queryWidth, queryHeight);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+//
+//  RegionOfInterestTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <math.h>
+
+#include "RegionOfInterest.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+static RoiPolicy policyWithFallback(int misses)
+{
+    RoiPolicy policy;
+    policy.fallbackMisses = misses;
+    return policy;
+}
+
+static bool near(float a, float b)
+{
+    return fabs(a - b) < 1e-5;
+}
+
+TEST(centreViewfinderByDefault)
+{
+    RegionOfInterest region;
+    CHECK(region.policy().enabled);
+
+    CropRect crop;
+    CHECK(region.next(1280, 720, &crop));
+    CHECK_EQ(crop.x, 256);
+    CHECK_EQ(crop.y, 144);
+    CHECK_EQ(crop.width, 768);
+    CHECK_EQ(crop.height, 432);
+}
+
+TEST(cropIsClampedToTheFrame)
+{
+    RoiRect past = { 0.9, 0.8, 0.5, 0.5 };
+    CropRect crop = cropOf(past, 100, 50);
+    CHECK_EQ(crop.x, 90);
+    CHECK_EQ(crop.y, 40);
+    CHECK_EQ(crop.width, 10);
+    CHECK_EQ(crop.height, 10);
+
+    RoiRect before = { -0.2, -0.1, 0.5, 0.3 };
+    crop = cropOf(before, 100, 100);
+    CHECK_EQ(crop.x, 0);
+    CHECK_EQ(crop.y, 0);
+    CHECK_EQ(crop.width, 30);
+    CHECK_EQ(crop.height, 20);
+
+    RoiRect everything = { -1, -1, 3, 3 };
+    crop = cropOf(everything, 64, 48);
+    CHECK_EQ(crop.width, 64);
+    CHECK_EQ(crop.height, 48);
+}
+
+TEST(cropIsAtLeastOnePixel)
+{
+    RoiRect empty = { 0.5, 0.5, 0, 0 };
+    CropRect crop = cropOf(empty, 100, 100);
+    CHECK_EQ(crop.x, 50);
+    CHECK_EQ(crop.width, 1);
+    CHECK_EQ(crop.height, 1);
+
+    RoiRect edge = { 1, 1, 0.1, 0.1 };
+    crop = cropOf(edge, 100, 100);
+    CHECK_EQ(crop.x, 99);
+    CHECK_EQ(crop.y, 99);
+    CHECK_EQ(crop.width, 1);
+    CHECK_EQ(crop.height, 1);
+}
+
+TEST(cornersAreMappedToTheFrame)
+{
+    RoiRect region = { 0.2, 0.2, 0.6, 0.6 };
+    float corners[] = { -1, -1, 1, -1, 1, 1, -1, 1, 0, 0 };
+    mapToFrame(region, corners, 5);
+    CHECK(near(corners[0], -0.6f) && near(corners[1], -0.6f));
+    CHECK(near(corners[2], 0.6f) && near(corners[3], -0.6f));
+    CHECK(near(corners[4], 0.6f) && near(corners[5], 0.6f));
+    CHECK(near(corners[6], -0.6f) && near(corners[7], 0.6f));
+    CHECK(near(corners[8], 0) && near(corners[9], 0));
+
+    // off centre, and the whole frame maps onto itself
+    RoiRect corner = { 0, 0.5, 0.5, 0.5 };
+    float point[] = { -1, -1, 1, 1 };
+    mapToFrame(corner, point, 2);
+    CHECK(near(point[0], -1) && near(point[1], 0));
+    CHECK(near(point[2], 0) && near(point[3], 1));
+
+    RoiRect frame = { 0, 0, 1, 1 };
+    float same[] = { -0.5f, 0.25f };
+    mapToFrame(frame, same, 1);
+    CHECK(near(same[0], -0.5f) && near(same[1], 0.25f));
+}
+
+TEST(fullFrameAfterRegionMisses)
+{
+    RegionOfInterest region(policyWithFallback(3));
+    CropRect crop;
+    bool fallback;
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 3; i++) {
+            CHECK(region.next(640, 480, &crop, &fallback));
+            CHECK(!fallback);
+            region.scanned(true, false);
+        }
+        CHECK(!region.next(640, 480, &crop, &fallback));
+        CHECK(fallback);
+        CHECK_EQ(crop.width, 640);
+        CHECK_EQ(crop.height, 480);
+        region.scanned(false, false);
+    }
+
+    RoiStats stats = region.stats();
+    CHECK_EQ(stats.frames, 8u);
+    CHECK_EQ(stats.cropped, 6u);
+    CHECK_EQ(stats.fallbacks, 2u);
+    CHECK_EQ(stats.fallbackHits, 0u);
+}
+
+TEST(regionMatchRestartsTheCount)
+{
+    RegionOfInterest region(policyWithFallback(3));
+    CropRect crop;
+    region.next(640, 480, &crop);
+    region.scanned(true, false);
+    region.next(640, 480, &crop);
+    region.scanned(true, false);
+    region.next(640, 480, &crop);
+    region.scanned(true, true);
+    for (int i = 0; i < 3; i++) {
+        CHECK(region.next(640, 480, &crop));
+        region.scanned(true, false);
+    }
+    CHECK(!region.next(640, 480, &crop));
+}
+
+TEST(fallbackHitsCountFullFrameMatches)
+{
+    RegionOfInterest region(policyWithFallback(1));
+    CropRect crop;
+    region.next(640, 480, &crop);
+    region.scanned(true, false);
+    CHECK(!region.next(640, 480, &crop));
+    region.scanned(false, true);
+    region.next(640, 480, &crop);
+    region.scanned(true, true);             // a region hit is not one
+
+    RoiStats stats = region.stats();
+    CHECK_EQ(stats.fallbacks, 1u);
+    CHECK_EQ(stats.fallbackHits, 1u);
+}
+
+TEST(noFallbackWithZeroMisses)
+{
+    RegionOfInterest region(policyWithFallback(0));
+    CropRect crop;
+    for (int i = 0; i < 50; i++) {
+        CHECK(region.next(640, 480, &crop));
+        region.scanned(true, false);
+    }
+    CHECK_EQ(region.stats().fallbacks, 0u);
+}
+
+TEST(disabledScansWholeFrames)
+{
+    RoiPolicy policy;
+    policy.enabled = false;
+    RegionOfInterest region(policy);
+    CropRect crop;
+    bool fallback;
+    CHECK(!region.next(1280, 720, &crop, &fallback));
+    CHECK(!fallback);                       // whole frames, but not after misses
+    CHECK_EQ(crop.width, 1280);
+    region.scanned(false, true);
+
+    RoiStats stats = region.stats();
+    CHECK_EQ(stats.cropped, 0u);
+    CHECK_EQ(stats.fallbackHits, 0u);
+    CHECK_EQ(stats.pixels, stats.framePixels);
+}
+
+TEST(pixelsConverted)
+{
+    RegionOfInterest region;
+    CropRect crop;
+    region.next(1280, 720, &crop);
+    RoiStats stats = region.stats();
+    CHECK_EQ(stats.framePixels, 1280u * 720u);
+    CHECK_EQ(stats.pixels, 768u * 432u);
+}
+
+TEST(newPolicyForgetsTheMisses)
+{
+    RegionOfInterest region(policyWithFallback(2));
+    CropRect crop;
+    region.next(640, 480, &crop);
+    region.scanned(true, false);
+    region.next(640, 480, &crop);
+    region.scanned(true, false);
+    region.setPolicy(policyWithFallback(2));
+    CHECK(region.next(640, 480, &crop));
+}
@@ -0,0 +1,82 @@
+//
+//  ResampleBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "Resample.h"
+
+using namespace msane;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The baseline: a bilinear sample per output pixel, which aliases when
+// shrinking by more than 2x but is what a quick implementation would do
+static void bilinear(const GrayView &src, const GrayView &dst)
+{
+    float sx = (float) src.width / dst.width, sy = (float) src.height / dst.height;
+    for (int y = 0; y < dst.height; y++) {
+        float fy = (y + 0.5f) * sy - 0.5f;
+        int y0 = fy < 0 ? 0 : (int) fy;
+        int y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+        float wy = fy - y0 < 0 ? 0 : fy - y0;
+        for (int x = 0; x < dst.width; x++) {
+            float fx = (x + 0.5f) * sx - 0.5f;
+            int x0 = fx < 0 ? 0 : (int) fx;
+            int x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+            float wx = fx - x0 < 0 ? 0 : fx - x0;
+            const uint8_t *a = src.pixels + (size_t) y0 * src.stride;
+            const uint8_t *b = src.pixels + (size_t) y1 * src.stride;
+            float top = a[x0] + (a[x1] - a[x0]) * wx;
+            float bottom = b[x0] + (b[x1] - b[x0]) * wx;
+            dst.pixels[(size_t) y * dst.stride + x] = (uint8_t) (top + (bottom - top) * wy + 0.5f);
+        }
+    }
+}
+
+int main()
+{
+    const int sizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 4032, 3024 } };
+
+    printf("to the image query size (480 longest side)\n");
+    printf("%10s %9s %12s %12s %13s %11s\n", "input", "output", "bilinear ms", "area ms", "area scratch", "input MB/s");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        int width = sizes[s][0], height = sizes[s][1];
+        int queryWidth, queryHeight;
+        querySizeFor(width, height, ScanTargetImage, &queryWidth, &queryHeight);
+
+        std::vector<uint8_t> in((size_t) width * height);
+        for (size_t i = 0; i < in.size(); i++)
+            in[i] = (uint8_t) rand();
+        std::vector<uint8_t> out((size_t) queryWidth * queryHeight);
+        GrayView src = { &in[0], width, height, width };
+        GrayView dst = { &out[0], queryWidth, queryHeight, queryWidth };
+
+        int frames = width * height > 4000000 ? 20 : 100;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            bilinear(src, dst);
+        double naive = secondsSince(start) / frames;
+
+        Resampler resampler;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+            resampler.resample(src, dst);
+        double area = secondsSince(start) / frames;
+
+        printf("%5dx%-4d %4dx%-4d %12.3f %12.3f %10.0f KB %11.0f\n", width, height, queryWidth, queryHeight,
+               naive * 1e3, area * 1e3, resampler.scratchBytes() / 1024.0, width * height / area / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+//
+//  ResampleTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "Resample.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+TEST(querySizeForImages)
+{
+    int w, h;
+    querySizeFor(1920, 1080, ScanTargetImage, &w, &h);
+    CHECK(w == 480 && h == 270);
+    querySizeFor(1080, 1920, ScanTargetImage, &w, &h);
+    CHECK(w == 270 && h == 480);
+    querySizeFor(480, 360, ScanTargetImage, &w, &h);
+    CHECK(w == 480 && h == 360);
+    querySizeFor(320, 240, ScanTargetImage, &w, &h);
+    CHECK(w == 480 && h == 360);
+}
+
+TEST(querySizeForBarcodes)
+{
+    int w, h;
+    querySizeFor(4000, 3000, ScanTargetBarcode, &w, &h);
+    CHECK(w == 1280 && h == 960);
+    querySizeFor(1000, 700, ScanTargetBarcode, &w, &h);
+    CHECK(w == 1000 && h == 700);
+    querySizeFor(200, 100, ScanTargetBarcode, &w, &h);
+    CHECK(w == 480 && h == 240);
+    querySizeFor(5000, 10, ScanTargetBarcode, &w, &h);
+    CHECK(w == 1280 && h == 3);
+}
+
+static std::vector<uint8_t> plane(int width, int height, unsigned seed)
+{
+    std::vector<uint8_t> pixels((size_t) width * height);
+    srand(seed);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = (uint8_t) rand();
+    return pixels;
+}
+
+TEST(flatPlaneStaysFlat)
+{
+    const int sizes[][4] = { { 1920, 1080, 480, 270 }, { 1000, 777, 480, 373 }, { 300, 200, 480, 320 } };
+    Resampler resampler;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+        std::vector<uint8_t> in((size_t) sizes[s][0] * sizes[s][1], 173);
+        std::vector<uint8_t> out((size_t) sizes[s][2] * sizes[s][3], 0);
+        GrayView src = { &in[0], sizes[s][0], sizes[s][1], sizes[s][0] };
+        GrayView dst = { &out[0], sizes[s][2], sizes[s][3], sizes[s][2] };
+        CHECK(resampler.resample(src, dst));
+        for (size_t i = 0; i < out.size(); i++) {
+            if (abs(out[i] - 173) > 1) {
+                CHECK(abs(out[i] - 173) <= 1);
+                break;
+            }
+        }
+    }
+}
+
+TEST(exactHalvingIsABoxFilter)
+{
+    const int width = 66, height = 34;
+    std::vector<uint8_t> in = plane(width, height, 1);
+    std::vector<uint8_t> out((width / 2) * (height / 2));
+    GrayView src = { &in[0], width, height, width };
+    GrayView dst = { &out[0], width / 2, height / 2, width / 2 };
+    Resampler resampler;
+    CHECK(resampler.resample(src, dst));
+    for (int y = 0; y < height / 2; y++) {
+        for (int x = 0; x < width / 2; x++) {
+            int sum = in[2 * y * width + 2 * x] + in[2 * y * width + 2 * x + 1]
+                    + in[(2 * y + 1) * width + 2 * x] + in[(2 * y + 1) * width + 2 * x + 1];
+            CHECK_EQ(out[y * (width / 2) + x], (sum + 2) >> 2);
+        }
+    }
+}
+
+TEST(areaAverageKeepsTheMean)
+{
+    // a 1.5x ratio: each output pixel covers parts of neighbouring inputs
+    const int width = 720, height = 540;
+    std::vector<uint8_t> in = plane(width, height, 2);
+    std::vector<uint8_t> out(480 * 360);
+    GrayView src = { &in[0], width, height, width };
+    GrayView dst = { &out[0], 480, 360, 480 };
+    Resampler resampler;
+    CHECK(resampler.resample(src, dst));
+
+    double inMean = 0, outMean = 0;
+    for (size_t i = 0; i < in.size(); i++) inMean += in[i];
+    for (size_t i = 0; i < out.size(); i++) outMean += out[i];
+    inMean /= in.size();
+    outMean /= out.size();
+    CHECK(inMean - outMean < 0.5 && outMean - inMean < 0.5);
+
+    // averaging smooths: much less spread than the uniform noise put in
+    double variance = 0;
+    for (size_t i = 0; i < out.size(); i++) variance += (out[i] - outMean) * (out[i] - outMean);
+    CHECK(variance / out.size() < 5400 / 2.0);
+}
+
+TEST(steadySizeDoesNotAllocate)
+{
+    std::vector<uint8_t> in = plane(1280, 720, 3);
+    std::vector<uint8_t> out(480 * 270);
+    GrayView src = { &in[0], 1280, 720, 1280 };
+    GrayView dst = { &out[0], 480, 270, 480 };
+    Resampler resampler;
+    resampler.resample(src, dst);
+    size_t scratch = resampler.scratchBytes();
+
+    uint64_t before = msanetest::allocationCount();
+    for (int i = 0; i < 20; i++)
+        resampler.resample(src, dst);
+    CHECK_EQ(msanetest::allocationCount() - before, 0u);
+    CHECK_EQ(resampler.scratchBytes(), scratch);
+}
+
+TEST(emptyViewsAreRejected)
+{
+    uint8_t pixel = 0;
+    GrayView empty = { &pixel, 0, 1, 1 };
+    GrayView one = { &pixel, 1, 1, 1 };
+    Resampler resampler;
+    CHECK(!resampler.resample(empty, one));
+    CHECK(!resampler.resample(one, empty));
+}
@@ -0,0 +1,94 @@
+//
+//  ResultRingBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "FakeFRE.h"
+#include "ResultRing.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// The path the ring replaced: every result formatted into a "Type:\n<id>"
+// string, copied into its own status event (FREDispatchStatusEventAsync
+// copies code and level), and split again by the event handler on the AS
+// side. Returns the id bytes seen so the work is not optimized away.
+static size_t stringEvents(const char *id, int total, int burst, FakeContext &context)
+{
+    size_t bytes = 0;
+    for (int done = 0; done < total; done += burst) {
+        for (int i = 0; i < burst; i++) {
+            std::string value = std::string("Image") + ":\n" + id;
+            context.dispatch("scanCompleted", value.c_str());
+        }
+        for (size_t e = 0; e < context.events.size(); e++) {
+            const std::string &level = context.events[e].level;
+            bytes += level.size() - level.find('\n') - 1;
+        }
+        context.events.clear();
+    }
+    return bytes;
+}
+
+// Results per second through the ring and the fake drainResults() call, and
+// heap allocations per result, for a few burst sizes between two drains,
+// against one string status event per result as before
+int main()
+{
+    const char *id = "9780201633610";
+    const float corners[8] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f };
+    const int total = 2000000;
+    const int bursts[] = { 1, 8, 64, 512 };
+
+    printf("%8s %8s %14s %12s %14s\n", "path", "burst", "results/s", "ns/result", "allocs/result");
+    for (size_t b = 0; b < sizeof(bursts) / sizeof(*bursts); b++) {
+        FakeContext stringContext;
+        uint64_t allocations = allocationCount();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t stringBytes = stringEvents(id, total, bursts[b], stringContext);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double perResult = (double) (allocationCount() - allocations) / total;
+        printf("%8s %8d %14.0f %12.1f %14.4f\n", "strings", bursts[b], total / seconds, seconds * 1e9 / total, perResult);
+        if (stringBytes == 0)
+            return 1;
+
+        ResultRing ring;
+        FakeContext context;
+        FakeByteArray array;
+        ResultHeader header;
+        memset(&header, 0, sizeof(header));
+        header.type = 2;
+        header.flags = ResultFlagCorners;
+        header.idLength = (uint32_t) strlen(id);
+
+        allocations = allocationCount();
+        start = std::chrono::steady_clock::now();
+        size_t bytes = 0;
+        for (int done = 0; done < total; done += bursts[b]) {
+            for (int i = 0; i < bursts[b]; i++) {
+                header.tag = (uint32_t) (done + i);
+                ring.push(header, corners, (const uint8_t *) id);
+            }
+            size_t written = drainResults(context, ring, array);
+            size_t position = 0;
+            FakeRecord record;
+            while (readRecord(array, written, &position, &record))
+                bytes += record.header.idLength;
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        perResult = (double) (allocationCount() - allocations) / total;
+        printf("%8s %8d %14.0f %12.1f %14.4f\n", "ring", bursts[b], total / seconds, seconds * 1e9 / total, perResult);
+        if (bytes == 0)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+//
+//  ResultRingTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "FakeFRE.h"
+#include "ResultRing.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static ResultHeader headerFor(uint32_t tag, uint32_t idLength, uint8_t flags = 0)
+{
+    ResultHeader header;
+    memset(&header, 0, sizeof(header));
+    header.type = 8;
+    header.origin = 1;
+    header.source = ResultSourceBitmap;
+    header.flags = flags;
+    header.tag = tag;
+    header.idLength = idLength;
+    header.timestamp = tag * 0.5;
+    return header;
+}
+
+TEST(recordsComeBackInOrder)
+{
+    ResultRing ring(1024);
+    FakeContext context;
+    const float corners[8] = { -1, -1, 1, -1, 1, 1, -1, 1 };
+
+    CHECK(ring.push(headerFor(1, 3), NULL, (const uint8_t *) "abc"));
+    CHECK(!ring.push(headerFor(2, 5, ResultFlagCorners), corners, (const uint8_t *) "hello"));
+    CHECK_EQ(ring.pendingCount(), 2u);
+
+    FakeByteArray array;
+    size_t written = drainResults(context, ring, array);
+    CHECK_EQ(written, 2 * kResultHeaderSize + kResultCornersSize + 8);
+    CHECK_EQ(ring.pendingCount(), 0u);
+
+    size_t position = 0;
+    FakeRecord record;
+    CHECK(readRecord(array, written, &position, &record));
+    CHECK_EQ(record.header.tag, 1u);
+    CHECK(!(record.header.flags & ResultFlagCorners));
+    CHECK(memcmp(record.id, "abc", 3) == 0);
+    CHECK(readRecord(array, written, &position, &record));
+    CHECK_EQ(record.header.tag, 2u);
+    CHECK(record.header.flags & ResultFlagCorners);
+    CHECK(record.corners[2] == 1 && record.corners[7] == 1);
+    CHECK(record.header.timestamp == 1.0);
+    CHECK(memcmp(record.id, "hello", 5) == 0);
+    CHECK_EQ(position, written);
+}
+
+TEST(cornersAreDroppedWithoutData)
+{
+    ResultRing ring(256);
+    ring.push(headerFor(1, 0, ResultFlagCorners), NULL, NULL);
+    CHECK_EQ(ring.pendingBytes(), kResultHeaderSize);
+}
+
+TEST(oneNotificationPerDrain)
+{
+    ResultRing ring(1024);
+    CHECK(ring.push(headerFor(1, 0), NULL, NULL));
+    CHECK(!ring.push(headerFor(2, 0), NULL, NULL));
+    uint8_t buffer[256];
+    bool hasMore = true;
+    ring.drain(buffer, sizeof(buffer), &hasMore);
+    CHECK(!hasMore);
+    CHECK(ring.push(headerFor(3, 0), NULL, NULL));
+}
+
+TEST(partialDrainKeepsWholeRecords)
+{
+    ResultRing ring(1024);
+    for (uint32_t tag = 0; tag < 4; tag++)
+        ring.push(headerFor(tag, 4), NULL, (const uint8_t *) "1234");
+
+    uint8_t buffer[2 * (kResultHeaderSize + 4) + 10];
+    bool hasMore = false;
+    CHECK_EQ(ring.drain(buffer, sizeof(buffer), &hasMore), 2 * (kResultHeaderSize + 4));
+    CHECK(hasMore);
+    CHECK_EQ(ring.pendingCount(), 2u);
+
+    // still outstanding, so the next push does not notify again
+    CHECK(!ring.push(headerFor(9, 0), NULL, NULL));
+}
+
+TEST(fullRingDropsOldest)
+{
+    const size_t record = kResultHeaderSize + 8;
+    ResultRing ring(3 * record + record / 2);
+    for (uint32_t tag = 0; tag < 10; tag++)
+        ring.push(headerFor(tag, 8), NULL, (const uint8_t *) "abcdefgh");
+
+    CHECK_EQ(ring.pendingCount(), 3u);
+    CHECK_EQ(ring.droppedCount(), 7u);
+
+    // the survivors are the newest and wrap around the end of the buffer
+    uint8_t buffer[512];
+    size_t written = ring.drain(buffer, sizeof(buffer), NULL);
+    CHECK_EQ(written, 3 * record);
+    for (uint32_t i = 0; i < 3; i++) {
+        ResultHeader header;
+        memcpy(&header, buffer + i * record, kResultHeaderSize);
+        CHECK_EQ(header.tag, 7 + i);
+        CHECK(memcmp(buffer + i * record + kResultHeaderSize, "abcdefgh", 8) == 0);
+    }
+}
+
+TEST(oversizedRecordIsLostAlone)
+{
+    ResultRing ring(64);
+    ring.push(headerFor(1, 0), NULL, NULL);
+    std::vector<uint8_t> id(100, 'x');
+    CHECK(!ring.push(headerFor(2, (uint32_t) id.size()), NULL, &id[0]));
+    CHECK_EQ(ring.pendingCount(), 1u);
+    CHECK_EQ(ring.droppedCount(), 1u);
+}
+
+TEST(clearForgetsEverything)
+{
+    ResultRing ring(256);
+    ring.push(headerFor(1, 0), NULL, NULL);
+    ring.clear();
+    CHECK_EQ(ring.pendingCount(), 0u);
+    CHECK_EQ(ring.pendingBytes(), 0u);
+    CHECK(ring.push(headerFor(2, 0), NULL, NULL));
+}
+
+TEST(steadyStateDoesNotAllocate)
+{
+    ResultRing ring(16 * 1024);
+    FakeContext context;
+    FakeByteArray array;
+    const float corners[8] = { 0 };
+
+    // the first drain sizes the ByteArray, after that nothing may allocate
+    for (uint32_t tag = 0; tag < 32; tag++)
+        ring.push(headerFor(tag, 13, ResultFlagCorners), corners, (const uint8_t *) "9780201633610");
+    drainResults(context, ring, array);
+
+    uint64_t before = allocationCount();
+    std::vector<uint8_t> probe(1);
+    CHECK_EQ(allocationCount() - before, 1u);
+
+    before = allocationCount();
+    for (int round = 0; round < 100; round++) {
+        for (uint32_t tag = 0; tag < 32; tag++)
+            ring.push(headerFor(tag, 13, ResultFlagCorners), corners, (const uint8_t *) "9780201633610");
+        drainResults(context, ring, array);
+    }
+    CHECK_EQ(allocationCount() - before, 0u);
+}
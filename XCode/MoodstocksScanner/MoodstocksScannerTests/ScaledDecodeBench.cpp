@@ -0,0 +1,133 @@
+//
+//  ScaledDecodeBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include "ImageHeader.h"
+#include "Resample.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// scanEncodedBytes() on the host: libjpeg stands in for ImageIO. A 12 MP
+// colour photo is decoded either at full size and then resampled, or at
+// the DCT scale scaledDecodeSide() picks, straight to luma.
+
+static std::vector<uint8_t> encodePhoto(int width, int height)
+{
+    std::vector<uint8_t> rgb((size_t) width * 3);
+    jpeg_compress_struct c;
+    jpeg_error_mgr error;
+    c.err = jpeg_std_error(&error);
+    jpeg_create_compress(&c);
+    unsigned char *buffer = NULL;
+    unsigned long length = 0;
+    jpeg_mem_dest(&c, &buffer, &length);
+    c.image_width = width;
+    c.image_height = height;
+    c.input_components = 3;
+    c.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&c);
+    jpeg_set_quality(&c, 90, TRUE);
+    jpeg_start_compress(&c, TRUE);
+    while (c.next_scanline < c.image_height) {
+        int y = c.next_scanline;
+        for (int x = 0; x < width; x++) {
+            double v = 128 + 60 * sin(x * 0.01) * cos(y * 0.013) + (rand() % 16);
+            rgb[x * 3] = (uint8_t) v;
+            rgb[x * 3 + 1] = (uint8_t) (255 - v);
+            rgb[x * 3 + 2] = (uint8_t) ((x ^ y) & 255);
+        }
+        JSAMPROW row = &rgb[0];
+        jpeg_write_scanlines(&c, &row, 1);
+    }
+    jpeg_finish_compress(&c);
+    std::vector<uint8_t> bytes(buffer, buffer + length);
+    free(buffer);
+    jpeg_destroy_compress(&c);
+    return bytes;
+}
+
+// Decodes to luma at 1/`denominator`, into `plane`
+static void decodeGray(const std::vector<uint8_t> &bytes, int denominator, std::vector<uint8_t> &plane,
+                       int *width, int *height)
+{
+    jpeg_decompress_struct d;
+    jpeg_error_mgr error;
+    d.err = jpeg_std_error(&error);
+    jpeg_create_decompress(&d);
+    jpeg_mem_src(&d, &bytes[0], bytes.size());
+    jpeg_read_header(&d, TRUE);
+    d.out_color_space = JCS_GRAYSCALE;
+    d.scale_num = 1;
+    d.scale_denom = denominator;
+    jpeg_start_decompress(&d);
+    *width = d.output_width;
+    *height = d.output_height;
+    plane.resize((size_t) *width * *height);
+    while (d.output_scanline < d.output_height) {
+        JSAMPROW row = &plane[(size_t) d.output_scanline * *width];
+        jpeg_read_scanlines(&d, &row, 1);
+    }
+    jpeg_finish_decompress(&d);
+    jpeg_destroy_decompress(&d);
+}
+
+static void scan(const std::vector<uint8_t> &bytes, bool scaled, double *seconds, size_t *peak)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    msanetest::resetHeapPeak();
+    size_t base = msanetest::heapPeak();
+
+    ImageHeader header;
+    readImageHeader(&bytes[0], bytes.size(), &header);
+    int queryWidth, queryHeight;
+    querySizeFor(header.width, header.height, ScanTargetImage, &queryWidth, &queryHeight);
+    int longest = header.width > header.height ? header.width : header.height;
+    int side = scaled ? scaledDecodeSide(header, queryWidth > queryHeight ? queryWidth : queryHeight) : longest;
+
+    std::vector<uint8_t> plane;
+    int width, height;
+    decodeGray(bytes, (longest + side - 1) / side, plane, &width, &height);
+
+    std::vector<uint8_t> query((size_t) queryWidth * queryHeight);
+    GrayView src = { &plane[0], width, height, width };
+    GrayView dst = { &query[0], queryWidth, queryHeight, queryWidth };
+    Resampler resampler;
+    resampler.resample(src, dst);
+
+    *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    *peak = msanetest::heapPeak() - base;
+}
+
+int main()
+{
+    std::vector<uint8_t> photo = encodePhoto(4032, 3024);
+    printf("4032x3024 JPEG, %zu KB, to a 480x360 query\n", photo.size() / 1024);
+    printf("%14s %10s %12s\n", "decode", "ms", "peak heap");
+
+    const char *names[] = { "full size", "DCT scaled" };
+    for (int scaled = 0; scaled < 2; scaled++) {
+        double best = 1e9;
+        size_t peak = 0;
+        for (int i = 0; i < 5; i++) {
+            double seconds;
+            scan(photo, scaled != 0, &seconds, &peak);
+            if (seconds < best)
+                best = seconds;
+        }
+        printf("%14s %10.1f %9.1f MB\n", names[scaled], best * 1e3, peak / 1048576.0);
+    }
+    return 0;
+}
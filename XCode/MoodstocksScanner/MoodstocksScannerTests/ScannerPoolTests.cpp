@@ -0,0 +1,150 @@
+//
+//  ScannerPoolTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ScannerPool.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// What openWithKey: and evictScanners do with the pool, with a map of open
+// stub scanners standing in for _scanners
+struct StubBackend {
+    ScannerPool pool;
+    std::map<std::string, uint64_t> open;  // key -> database bytes
+    int opens;
+    int closes;
+
+    StubBackend(size_t maxScanners, uint64_t maxBytes) : pool(maxScanners, maxBytes), opens(0), closes(0) {}
+
+    void use(const std::string &key, uint64_t bytes)
+    {
+        if (!pool.touch(key)) {
+            open[key] = bytes;
+            opens++;
+            pool.insert(key, bytes);
+        }
+        std::vector<std::string> evicted;
+        pool.evict(&evicted);
+        for (size_t i = 0; i < evicted.size(); i++) {
+            open.erase(evicted[i]);
+            closes++;
+        }
+    }
+};
+
+TEST(touchCountsHitsAndMisses)
+{
+    ScannerPool pool;
+    CHECK(!pool.touch("a"));
+    pool.insert("a", 100);
+    CHECK(pool.touch("a"));
+    CHECK(pool.contains("a"));
+    CHECK(!pool.contains("b"));
+
+    ScannerPoolStats stats = pool.stats();
+    CHECK_EQ(stats.open, 1u);
+    CHECK_EQ(stats.bytes, 100u);
+    CHECK_EQ(stats.hits, 1u);
+    CHECK_EQ(stats.misses, 1u);
+}
+
+TEST(leastRecentlyUsedGoesFirst)
+{
+    StubBackend backend(2, 1000);
+    backend.use("a", 10);
+    backend.use("b", 10);
+    backend.use("a", 10);
+    backend.use("c", 10);
+
+    CHECK(backend.open.count("a") && backend.open.count("c"));
+    CHECK(!backend.open.count("b"));
+    CHECK_EQ(backend.pool.stats().evictions, 1u);
+}
+
+TEST(byteBudgetEvictsButKeepsTheScannerInUse)
+{
+    StubBackend backend(8, 100);
+    backend.use("a", 40);
+    backend.use("b", 40);
+    backend.use("c", 40);
+    CHECK(!backend.open.count("a"));
+    CHECK_EQ(backend.pool.stats().bytes, 80u);
+
+    // a single database over budget still stays open, it is in use
+    backend.use("huge", 500);
+    CHECK_EQ(backend.open.size(), 1u);
+    CHECK(backend.open.count("huge"));
+}
+
+TEST(busyScannersAreNeverEvicted)
+{
+    StubBackend backend(2, 1000);
+    backend.use("syncing", 10);
+    backend.pool.setBusy("syncing", true);
+    backend.use("b", 10);
+    backend.use("c", 10);
+    CHECK(backend.open.count("syncing"));
+    CHECK(!backend.open.count("b"));
+
+    // once the sync is done it is the oldest and goes
+    backend.pool.setBusy("syncing", false);
+    backend.use("d", 10);
+    CHECK(!backend.open.count("syncing"));
+    CHECK_EQ(backend.open.size(), 2u);
+}
+
+TEST(growthAfterSyncCountsAgainstTheBudget)
+{
+    StubBackend backend(8, 100);
+    backend.use("a", 30);
+    backend.use("b", 30);
+    backend.pool.setBytes("a", 80);
+    CHECK_EQ(backend.pool.stats().bytes, 110u);
+    backend.use("b", 30);
+    CHECK(!backend.open.count("a"));
+}
+
+TEST(limitsCanShrink)
+{
+    StubBackend backend(4, 1000);
+    const char *keys[] = { "a", "b", "c", "d" };
+    for (int i = 0; i < 4; i++)
+        backend.use(keys[i], 10);
+    backend.pool.setLimits(0, 1000);
+    backend.use("d", 10);
+    CHECK_EQ(backend.open.size(), 1u);
+    CHECK_EQ(backend.pool.stats().open, 1u);
+}
+
+TEST(removeForgetsTheScanner)
+{
+    ScannerPool pool;
+    pool.insert("a", 10);
+    pool.insert("b", 20);
+    CHECK(pool.remove("a"));
+    CHECK(!pool.remove("a"));
+    CHECK_EQ(pool.stats().open, 1u);
+    CHECK_EQ(pool.stats().bytes, 20u);
+    // reinserting replaces, it does not count twice
+    pool.insert("b", 25);
+    CHECK_EQ(pool.stats().bytes, 25u);
+}
+
+// Switching back and forth between two partners opens each database once
+TEST(switchingBetweenTwoCatalogsIsAHit)
+{
+    StubBackend backend(4, 1000);
+    for (int i = 0; i < 100; i++)
+        backend.use(i % 2 ? "partnerA" : "partnerB", 100);
+    CHECK_EQ(backend.opens, 2);
+    CHECK_EQ(backend.closes, 0);
+    CHECK_EQ(backend.pool.stats().hits, 98u);
+}
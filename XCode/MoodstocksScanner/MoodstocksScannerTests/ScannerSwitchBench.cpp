@@ -0,0 +1,73 @@
+//
+//  ScannerSwitchBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "ScannerPool.h"
+#include "StubScanner.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// Latency of switching between two catalogs with stub scanners, the way
+// openWithKey: does it: with the pool, a touch of the open scanner; without
+// it, as before, a close and a reopen of the other database
+int main(int argc, char *argv[])
+{
+    const int switches = 20;
+    size_t megabytes = argc > 1 ? (size_t) atoi(argv[1]) : 16;
+    const char *keys[] = { "partnerA", "partnerB" };
+
+    std::map<std::string, StubScanner *> scanners;
+    for (int k = 0; k < 2; k++) {
+        std::string path = std::string("/tmp/msane-stub-") + keys[k] + ".db";
+        if (!writeStubDatabase(path, megabytes))
+            return 1;
+        scanners[keys[k]] = new StubScanner(path);
+    }
+
+    printf("two stub databases of %zu MB, %d switches\n", megabytes, switches);
+    printf("%10s %12s %12s\n", "", "avg ms", "max ms");
+    unsigned checksum = 0;
+    for (int pooled = 0; pooled < 2; pooled++) {
+        ScannerPool pool;
+        std::string current;
+        double total = 0, worst = 0;
+        for (int i = 0; i <= switches; i++) {
+            std::string key = keys[i % 2];
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!pooled && !current.empty()) {
+                scanners[current]->close();
+                pool.remove(current);
+            }
+            if (!pool.touch(key)) {
+                scanners[key]->open();
+                pool.insert(key, (uint64_t) megabytes << 20);
+            }
+            current = key;
+            checksum += scanners[key]->index();
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            // the first two opens happen either way
+            if (i >= 2) {
+                total += elapsed;
+                worst = elapsed > worst ? elapsed : worst;
+            }
+        }
+        printf("%10s %12.3f %12.3f\n", pooled ? "pooled" : "reopened", total / (switches - 1), worst);
+    }
+
+    for (int k = 0; k < 2; k++) {
+        remove((std::string("/tmp/msane-stub-") + keys[k] + ".db").c_str());
+        delete scanners[keys[k]];
+    }
+    return checksum == 1 ? 1 : 0;
+}
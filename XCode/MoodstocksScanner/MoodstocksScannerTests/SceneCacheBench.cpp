@@ -0,0 +1,82 @@
+//
+//  SceneCacheBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "SceneCache.h"
+#include "SyntheticFrames.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// Hit rate and search time saved by the scene cache on replayed 30 fps
+// sequences of 640x480 frames, each a few seconds of a typical use. A
+// fresh search is charged `kSearchCost`, the on-device search time of a
+// mid-sized catalog; hashing and lookups are measured.
+static const double kSearchCost = 0.030;
+static const int kWidth = 640, kHeight = 480;
+
+struct Sequence {
+    const char *name;
+    int frames;
+    double speed;   // pan in pixels per frame
+    int tremor;     // +- pixels of hand shake
+    int cutEvery;   // frames between switches to another scene, 0 for none
+};
+
+int main()
+{
+    const Sequence sequences[] = {
+        { "held still", 150, 0, 1, 0 },
+        { "slow pan", 150, 0.5, 1, 0 },
+        { "fast pan", 150, 4, 0, 30 },
+        { "browsing", 150, 0, 1, 20 },
+    };
+    std::vector<SyntheticScene *> scenes;
+    for (unsigned s = 0; s < 8; s++)
+        scenes.push_back(new SyntheticScene(kWidth, kHeight, 100 + s));
+
+    printf("%12s %8s %8s %10s %12s %12s\n", "sequence", "frames", "hits", "hit rate", "hash us/fr", "search saved");
+    std::vector<uint8_t> frame;
+    for (size_t q = 0; q < sizeof(sequences) / sizeof(*sequences); q++) {
+        const Sequence &sequence = sequences[q];
+        SceneCache cache;
+        double hashing = 0;
+        unsigned state = 7;
+        for (int i = 0; i < sequence.frames; i++) {
+            const SyntheticScene &scene = *scenes[sequence.cutEvery ? (i / sequence.cutEvery) % scenes.size() : 0];
+            // every scene is panned over from the left, as far as it goes
+            int dx = (int) (sequence.speed * (sequence.cutEvery ? i % sequence.cutEvery : i)) - 60;
+            if (sequence.speed == 0)
+                dx = 0;
+            state = state * 1103515245u + 12345u;
+            int shake = sequence.tremor ? (int) ((state >> 16) % (2 * sequence.tremor + 1)) - sequence.tremor : 0;
+            scene.render(dx + shake, shake, 0, 0, 3, i, &frame);
+
+            double now = i / 30.0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            SceneHash hash = sceneHash(SyntheticScene::view(frame, kWidth, kHeight));
+            int slot = cache.lookup(hash, 1, now);
+            hashing += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (slot < 0)
+                cache.insert(hash, 1, now, kSearchCost);
+        }
+        SceneCacheStats stats = cache.stats();
+        double spent = (sequence.frames - stats.hits) * kSearchCost + hashing;
+        printf("%12s %8d %8llu %9.0f%% %12.1f %11.0f%%\n", sequence.name, sequence.frames,
+               (unsigned long long) stats.hits, 100.0 * stats.hits / sequence.frames, hashing * 1e6 / sequence.frames,
+               100.0 * (1 - spent / (sequence.frames * kSearchCost)));
+    }
+
+    for (size_t s = 0; s < scenes.size(); s++)
+        delete scenes[s];
+    return 0;
+}
@@ -0,0 +1,144 @@
+//
+//  SceneCacheTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <vector>
+
+#include "FrameGate.h"
+#include "SceneCache.h"
+#include "SyntheticFrames.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+static const int kWidth = 320, kHeight = 240;
+
+static SceneHash hashOf(const SyntheticScene &scene, int dx, int dy, int noise, unsigned seed)
+{
+    std::vector<uint8_t> frame;
+    scene.render(dx, dy, 0, 0, noise, seed, &frame);
+    return sceneHash(SyntheticScene::view(frame, kWidth, kHeight));
+}
+
+TEST(hammingDistanceCountsBits)
+{
+    CHECK_EQ(hammingDistance(0, 0), 0);
+    CHECK_EQ(hammingDistance(0, ~(uint64_t) 0), 64);
+    CHECK_EQ(hammingDistance(0x0f, 0xf0), 8);
+}
+
+TEST(noiseKeepsTheHashClose)
+{
+    SyntheticScene scene(kWidth, kHeight, 1), other(kWidth, kHeight, 2);
+    SceneHash a = hashOf(scene, 0, 0, 0, 1);
+    SceneHash b = hashOf(scene, 0, 0, 6, 2);
+    SceneHash c = hashOf(other, 0, 0, 0, 1);
+    CHECK(hammingDistance(a.bits, b.bits) <= 4);
+    CHECK(hammingDistance(a.bits, c.bits) > 10);
+    CHECK_EQ(a.width, kWidth);
+}
+
+TEST(tinyPlanesAreNotHashed)
+{
+    std::vector<uint8_t> frame(10 * 10, 128);
+    GrayView view = { &frame[0], 10, 10, 10 };
+    CHECK_EQ(sceneHash(view).width, 0);
+
+    SceneCache cache;
+    CHECK_EQ(cache.insert(sceneHash(view), 1, 0, 0.1), -1);
+    CHECK_EQ(cache.stats().lookups, 0u);
+}
+
+TEST(nearDuplicatesHitWithinTtl)
+{
+    SyntheticScene scene(kWidth, kHeight, 3);
+    SceneCache cache(1.0, 4);
+    SceneHash first = hashOf(scene, 0, 0, 4, 1);
+    CHECK_EQ(cache.lookup(first, 1, 0), -1);
+    int slot = cache.insert(first, 1, 0, 0.05);
+    CHECK(slot >= 0);
+
+    CHECK_EQ(cache.lookup(hashOf(scene, 0, 0, 4, 2), 1, 0.5), slot);
+    // other result types, or too late
+    CHECK_EQ(cache.lookup(first, 2, 0.5), -1);
+    CHECK_EQ(cache.lookup(first, 1, 1.5), -1);
+
+    SceneCacheStats stats = cache.stats();
+    CHECK_EQ(stats.lookups, 4u);
+    CHECK_EQ(stats.hits, 1u);
+    CHECK(stats.savedTime == 0.05);
+}
+
+TEST(brightnessAloneTellsScenesApart)
+{
+    std::vector<uint8_t> white((size_t) kWidth * kHeight, 240), black((size_t) kWidth * kHeight, 10);
+    SceneCache cache;
+    cache.insert(sceneHash(SyntheticScene::view(white, kWidth, kHeight)), 1, 0, 0.05);
+    CHECK_EQ(cache.lookup(sceneHash(SyntheticScene::view(black, kWidth, kHeight)), 1, 0.1), -1);
+}
+
+TEST(fullCacheReplacesTheOldest)
+{
+    SceneCache cache(10, 0);
+    SceneHash hash = { 0, 128, 100, 100 };
+    for (int i = 0; i < SceneCache::kCapacity; i++) {
+        hash.bits = (uint64_t) 0xff << i;
+        CHECK_EQ(cache.insert(hash, 1, i, 0.01), i);
+    }
+    hash.bits = ~(uint64_t) 0;
+    CHECK_EQ(cache.insert(hash, 1, 100, 0.01), 0);
+    hash.bits = 0xff;
+    CHECK_EQ(cache.lookup(hash, 1, 100), -1);
+}
+
+TEST(clearAndZeroTtlDisable)
+{
+    SyntheticScene scene(kWidth, kHeight, 4);
+    SceneHash hash = hashOf(scene, 0, 0, 0, 1);
+    SceneCache cache;
+    cache.insert(hash, 1, 0, 0.05);
+    cache.clear();
+    CHECK_EQ(cache.lookup(hash, 1, 0), -1);
+
+    cache.configure(0, 4);
+    CHECK_EQ(cache.insert(hash, 1, 0, 0.05), -1);
+    CHECK_EQ(cache.lookup(hash, 1, 0), -1);
+}
+
+// recognizeFrame: in MoodstocksScanner.mm feeds the gate before the cache
+// lookup. A camera panning slowly over a scene keeps hitting the cache;
+// when a frame finally misses, the gate must compare it with the frame
+// just before, not with the last one it saw before the hits.
+TEST(gateStaysCurrentThroughCacheHits)
+{
+    SyntheticScene scene(kWidth, kHeight, 5);
+    SceneCache cache(10, 6);
+    FrameGate gate;
+    std::vector<uint8_t> frame;
+
+    int hits = 0;
+    GateVerdict verdict = { true, false, false, 0, 0 };
+    int dx = 0;
+    for (; dx <= 32; dx++) {
+        scene.render(dx, 0, 0, 0, 2, dx, &frame);
+        GrayView view = SyntheticScene::view(frame, kWidth, kHeight);
+        SceneHash hash = sceneHash(view);
+        verdict = gate.evaluate(view, dx * 0.03);
+        if (cache.lookup(hash, 1, dx * 0.03) >= 0) {
+            hits++;
+            continue;
+        }
+        if (dx > 0)
+            break;
+        cache.insert(hash, 1, 0, 0.05);
+    }
+    CHECK(hits >= 2);
+    CHECK(dx <= 32);
+    CHECK(!verdict.moving);
+    CHECK(verdict.pass);
+    CHECK_EQ(gate.stats().frames, (uint64_t) dx + 1);
+}
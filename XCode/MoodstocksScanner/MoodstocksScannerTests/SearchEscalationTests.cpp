@@ -0,0 +1,138 @@
+//
+//  SearchEscalationTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SearchEscalation.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+static SceneHash hashOf(uint64_t bits, int width = 640, int height = 480)
+{
+    SceneHash hash = { bits, 128, width, height };
+    return hash;
+}
+
+// Misses `count` default searches of the scene
+static void miss(SearchEscalation &escalation, const SceneHash &hash, int count)
+{
+    for (int i = 0; i < count; i++) {
+        CHECK_EQ(escalation.next(hash), SearchLevelDefault);
+        escalation.outcome(SearchLevelDefault, false);
+    }
+}
+
+TEST(smallTargetAfterMisses)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(0x0123456789abcdefull);
+    miss(escalation, scene, 3);
+    CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+}
+
+TEST(smallTargetMissesDoubleTheThreshold)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(42);
+    int threshold = 3;
+    for (int round = 0; round < 4; round++) {
+        miss(escalation, scene, threshold);
+        CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+        escalation.outcome(SearchLevelSmallTarget, false);
+        threshold *= 2;
+    }
+    CHECK_EQ(threshold, 48);
+}
+
+TEST(matchRestartsTheThreshold)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(42);
+    miss(escalation, scene, 3);
+    CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+    escalation.outcome(SearchLevelSmallTarget, false);
+
+    miss(escalation, scene, 2);
+    escalation.next(scene);
+    escalation.outcome(SearchLevelDefault, true);
+    miss(escalation, scene, 3);                     // 3 again, not 6
+    CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+}
+
+TEST(newSceneStartsFromScratch)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(0);
+    miss(escalation, scene, 3);
+
+    // a few bits off is still the same scene
+    CHECK_EQ(escalation.next(hashOf(0x3ff)), SearchLevelSmallTarget);
+    CHECK_EQ(escalation.stats().sceneChanges, 0u);
+
+    // more than maxDistance bits off is not
+    CHECK_EQ(escalation.next(hashOf(0x7ff)), SearchLevelDefault);
+    CHECK_EQ(escalation.stats().sceneChanges, 1u);
+    miss(escalation, hashOf(0x7ff), 2);
+    CHECK_EQ(escalation.next(hashOf(0x7ff)), SearchLevelDefault);
+    escalation.outcome(SearchLevelDefault, false);
+    CHECK_EQ(escalation.next(hashOf(0x7ff)), SearchLevelSmallTarget);
+
+    // and neither is the same picture at another size
+    CHECK_EQ(escalation.next(hashOf(0x7ff, 1280, 720)), SearchLevelDefault);
+    CHECK_EQ(escalation.stats().sceneChanges, 2u);
+}
+
+TEST(unhashedFramesAreLeftAlone)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(42);
+    miss(escalation, scene, 3);
+    CHECK_EQ(escalation.next(hashOf(0, 0, 0)), SearchLevelDefault);
+    CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+    CHECK_EQ(escalation.stats().sceneChanges, 0u);
+}
+
+TEST(disabledNeverEscalates)
+{
+    EscalationPolicy policy;
+    policy.enabled = false;
+    SearchEscalation escalation(policy);
+    miss(escalation, hashOf(42), 20);
+}
+
+TEST(newPolicyForgetsTheScene)
+{
+    SearchEscalation escalation;
+    SceneHash scene = hashOf(42);
+    miss(escalation, scene, 3);
+
+    EscalationPolicy policy;
+    policy.misses = 1;
+    escalation.setPolicy(policy);
+    miss(escalation, scene, 1);
+    CHECK_EQ(escalation.next(scene), SearchLevelSmallTarget);
+    CHECK_EQ(escalation.stats().sceneChanges, 0u);
+}
+
+TEST(statsPerLevel)
+{
+    SearchEscalation escalation;
+    escalation.record(SearchLevelDefault, 0.010, false);
+    escalation.record(SearchLevelDefault, 0.012, true);
+    escalation.record(SearchLevelSmallTarget, 0.040, true);
+
+    EscalationStats stats = escalation.stats();
+    CHECK_EQ(stats.levels[SearchLevelDefault].runs, 2u);
+    CHECK_EQ(stats.levels[SearchLevelDefault].hits, 1u);
+    CHECK(stats.levels[SearchLevelDefault].time > 0.0219 && stats.levels[SearchLevelDefault].time < 0.0221);
+    CHECK_EQ(stats.levels[SearchLevelSmallTarget].runs, 1u);
+    CHECK_EQ(stats.levels[SearchLevelSmallTarget].hits, 1u);
+
+    escalation.resetStats();
+    stats = escalation.stats();
+    CHECK_EQ(stats.levels[SearchLevelDefault].runs, 0u);
+    CHECK_EQ(stats.levels[SearchLevelSmallTarget].time, 0.0);
+}
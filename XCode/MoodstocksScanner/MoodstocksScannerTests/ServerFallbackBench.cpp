@@ -0,0 +1,248 @@
+//
+//  ServerFallbackBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ServerFallback.h"
+
+using namespace msane;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Local HTTP stand-in for the Moodstocks API: reads a POST, answers after a
+// lognormal latency around 200 ms, 5% of the requests after 3 to 8 s.
+// Latencies are multiplied by `scale`.
+class StandInServer {
+public:
+    explicit StandInServer(double scale) : _scale(scale), _random(7), _stopping(false), _port(0)
+    {
+        _socket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(_socket, (sockaddr *) &address, length) == 0 && listen(_socket, 16) == 0
+            && getsockname(_socket, (sockaddr *) &address, &length) == 0)
+            _port = ntohs(address.sin_port);
+        _acceptor = std::thread(&StandInServer::acceptLoop, this);
+    }
+
+    ~StandInServer()
+    {
+        _stopping = true;
+        shutdown(_socket, SHUT_RDWR);
+        close(_socket);
+        _acceptor.join();
+        for (size_t i = 0; i < _handlers.size(); i++)
+            _handlers[i].join();
+    }
+
+    int port() const { return _port; }
+
+private:
+    void acceptLoop()
+    {
+        for (;;) {
+            int client = accept(_socket, NULL, NULL);
+            if (client < 0)
+                return;
+            double latency;
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                std::uniform_real_distribution<double> unit(0, 1);
+                if (unit(_random) < 0.05) {
+                    latency = 3 + 5 * unit(_random);
+                } else {
+                    std::lognormal_distribution<double> server(log(0.2), 0.4);
+                    latency = server(_random);
+                }
+            }
+            _handlers.push_back(std::thread(&StandInServer::handle, this, client, latency * _scale));
+        }
+    }
+
+    void handle(int client, double latency)
+    {
+        char buffer[4096];
+        std::string request;
+        size_t expected = std::string::npos;
+        while (expected == std::string::npos || request.size() < expected) {
+            ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+            if (count <= 0)
+                break;
+            request.append(buffer, (size_t) count);
+            size_t header = request.find("\r\n\r\n");
+            if (expected == std::string::npos && header != std::string::npos)
+                expected = header + 4 + (size_t) atol(request.c_str() + request.find("Content-Length:") + 15);
+        }
+
+        // sleeps in steps so the server can stop while answers are pending
+        double end = now() + latency;
+        while (!_stopping && now() < end)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        const char *answer = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\n{}";
+        send(client, answer, strlen(answer), MSG_NOSIGNAL);
+        close(client);
+    }
+
+    double _scale;
+    std::mt19937 _random;
+    std::atomic<bool> _stopping;
+    int _socket;
+    int _port;
+    std::thread _acceptor;
+    std::vector<std::thread> _handlers;     // acceptor thread only until the destructor
+    std::mutex _lock;
+};
+
+// One server search, posted from a thread of its own the way the SDK's
+// operation runs off the scan queue. A timeout shuts down this request's
+// socket only, as the extension cancels its own MSApiSearch.
+class Search {
+public:
+    Search(ServerFallback &fallback, uint32_t id, int port, size_t bytes)
+        : _fallback(fallback), _id(id), _socket(socket(AF_INET, SOCK_STREAM, 0)), _done(false)
+    {
+        _thread = std::thread(&Search::post, this, port, bytes);
+    }
+
+    ~Search()
+    {
+        _thread.join();
+        close(_socket);
+    }
+
+    // Waits for the answer until `deadline` seconds (0 for no deadline) and
+    // returns false on a timeout, after cancelling the request
+    bool wait(double deadline)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            if (deadline <= 0) {
+                while (!_done)
+                    _answered.wait(lock);
+            } else {
+                _answered.wait_for(lock, std::chrono::duration<double>(deadline), [this] { return _done; });
+            }
+        }
+        if (!_fallback.expire(_id))
+            return true;
+        shutdown(_socket, SHUT_RDWR);
+        return false;
+    }
+
+private:
+    void post(int port, size_t bytes)
+    {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((uint16_t) port);
+        bool ok = connect(_socket, (sockaddr *) &address, sizeof(address)) == 0;
+
+        if (ok) {
+            char header[128];
+            snprintf(header, sizeof(header), "POST /v2/search HTTP/1.1\r\nContent-Length: %zu\r\n\r\n", bytes);
+            std::string request = std::string(header) + std::string(bytes, 'q');
+            ok = send(_socket, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t) request.size();
+        }
+        char answer[256];
+        ok = ok && recv(_socket, answer, sizeof(answer), 0) > 0;
+
+        // a cancelled request ends here with !ok, finish() then drops it
+        _fallback.finish(_id, now(), false, !ok);
+        std::lock_guard<std::mutex> guard(_lock);
+        _done = true;
+        _answered.notify_all();
+    }
+
+    ServerFallback &_fallback;
+    uint32_t _id;
+    int _socket;
+    bool _done;
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _answered;
+};
+
+static double percentile(std::vector<double> values, int p)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() * p / 100];
+}
+
+// Frame latency until a result or a timeout record, against the stand-in:
+// every frame searched on the server, or only local misses, with and
+// without a deadline. 60% of the frames hit the 12 ms local search.
+int main(int argc, char *argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    double scale = argc > 2 ? atof(argv[2]) : 1.0;
+    const double localSearch = 0.012;
+    const size_t queryBytes = 35000;
+
+    printf("%d frames, 60%% local hits, %.0f ms local search, server latency x%.2f\n",
+           frames, localSearch * 1e3, scale);
+    printf("%20s %10s %10s %9s\n", "", "p50 ms", "p99 ms", "timeouts");
+    const char *names[] = { "always server", "local first", "local first + 1 s" };
+    for (int mode = 0; mode < 3; mode++) {
+        StandInServer server(scale);
+        if (server.port() == 0)
+            return 1;
+        FallbackPolicy policy;
+        policy.enabled = true;
+        policy.deadline = mode == 2 ? 1.0 * scale : 0;
+        ServerFallback fallback(policy);
+
+        std::vector<double> latencies;
+        for (int i = 0; i < frames; i++) {
+            double start = now();
+            bool local = (i * 37) % 10 < 6;
+            if (mode != 0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(localSearch));
+                if (local) {
+                    latencies.push_back((now() - start) * 1e3);
+                    continue;
+                }
+            }
+            uint32_t id = fallback.begin(now());
+            Search search(fallback, id, server.port(), queryBytes);
+            search.wait(policy.deadline);
+            latencies.push_back((now() - start) * 1e3);
+        }
+        printf("%20s %10.0f %10.0f %9llu\n", names[mode], percentile(latencies, 50), percentile(latencies, 99),
+               (unsigned long long) fallback.stats().timeouts);
+    }
+    return 0;
+}
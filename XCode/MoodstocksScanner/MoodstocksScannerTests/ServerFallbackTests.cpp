@@ -0,0 +1,156 @@
+//
+//  ServerFallbackTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <atomic>
+#include <thread>
+
+#include "ServerFallback.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+static FallbackPolicy enabledPolicy()
+{
+    FallbackPolicy policy;
+    policy.enabled = true;
+    return policy;
+}
+
+TEST(offByDefault)
+{
+    ServerFallback fallback;
+    CHECK(!fallback.policy().enabled);
+    CHECK_EQ(fallback.begin(0), 0u);
+    CHECK_EQ(fallback.stats().requests, 0u);
+}
+
+TEST(answerSettlesTheRequest)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(10.0);
+    CHECK(id != 0);
+    CHECK(fallback.finish(id, 10.25, true, false));
+
+    FallbackStats stats = fallback.stats();
+    CHECK_EQ(stats.requests, 1u);
+    CHECK_EQ(stats.hits, 1u);
+    CHECK_EQ(stats.misses, 0u);
+    CHECK(stats.time > 0.249 && stats.time < 0.251);
+
+    CHECK(!fallback.finish(id, 11.0, true, false));     // only once
+    CHECK(!fallback.expire(id));
+    CHECK_EQ(fallback.stats().hits, 1u);
+}
+
+TEST(oneRequestInFlight)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(0);
+    CHECK_EQ(fallback.begin(0.1), 0u);
+    CHECK_EQ(fallback.begin(0.2), 0u);
+    CHECK_EQ(fallback.stats().busy, 2u);
+
+    CHECK(fallback.finish(id, 0.3, false, false));
+    uint32_t next = fallback.begin(0.4);
+    CHECK(next != 0 && next != id);
+    CHECK_EQ(fallback.stats().misses, 1u);
+}
+
+TEST(deadlineBeatsTheAnswer)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(0);
+    CHECK(fallback.expire(id));
+    CHECK(!fallback.expire(id));
+    CHECK(!fallback.finish(id, 5.0, true, false));      // late answer dropped
+
+    FallbackStats stats = fallback.stats();
+    CHECK_EQ(stats.timeouts, 1u);
+    CHECK_EQ(stats.hits, 0u);
+    CHECK_EQ(stats.time, 0.0);
+    CHECK(fallback.begin(5.0) != 0);
+}
+
+TEST(lateDeadlineOfAnOlderRequest)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t first = fallback.begin(0);
+    CHECK(fallback.finish(first, 0.2, false, false));
+    uint32_t second = fallback.begin(0.3);
+
+    // the timer of the first request must not settle the second one
+    CHECK(!fallback.expire(first));
+    CHECK(fallback.finish(second, 0.5, true, false));
+    CHECK_EQ(fallback.stats().timeouts, 0u);
+}
+
+TEST(errorsAreNotTimed)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(0);
+    CHECK(fallback.finish(id, 2.0, false, true));
+    FallbackStats stats = fallback.stats();
+    CHECK_EQ(stats.errors, 1u);
+    CHECK_EQ(stats.misses, 0u);
+    CHECK_EQ(stats.time, 0.0);
+}
+
+TEST(offlineMissesAreReportedAsIs)
+{
+    ServerFallback fallback(enabledPolicy());
+    fallback.setNetwork(false);
+    CHECK_EQ(fallback.begin(0), 0u);
+    CHECK_EQ(fallback.stats().offline, 1u);
+
+    fallback.setNetwork(true);
+    CHECK(fallback.begin(1) != 0);
+}
+
+TEST(abandonFreesTheSlot)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(0);
+    fallback.prepared(id, 30000);
+    fallback.abandon(id);
+    CHECK_EQ(fallback.stats().requests, 0u);
+    CHECK(!fallback.finish(id, 1, true, false));
+    CHECK(fallback.begin(1) != 0);
+}
+
+TEST(preparedQueriesOfThePendingRequest)
+{
+    ServerFallback fallback(enabledPolicy());
+    uint32_t id = fallback.begin(0);
+    fallback.prepared(id, 30000);
+    fallback.prepared(id + 1, 50000);                    // not in flight
+    fallback.prepared(0, 50000);
+    FallbackStats stats = fallback.stats();
+    CHECK_EQ(stats.prepared, 1u);
+    CHECK_EQ(stats.preparedBytes, 30000u);
+}
+
+// The answer and the deadline race each other on different threads; exactly
+// one of them settles each request
+TEST(answerAndDeadlineRace)
+{
+    ServerFallback fallback(enabledPolicy());
+    const int rounds = 2000;
+    std::atomic<int> settled(0);
+    for (int i = 0; i < rounds; i++) {
+        uint32_t id = fallback.begin(i);
+        std::thread answer([&fallback, &settled, id, i] {
+            if (fallback.finish(id, i + 0.1, true, false))
+                settled++;
+        });
+        if (fallback.expire(id))
+            settled++;
+        answer.join();
+    }
+    CHECK_EQ(settled.load(), rounds);
+    FallbackStats stats = fallback.stats();
+    CHECK_EQ(stats.hits + stats.timeouts, (uint64_t) rounds);
+}
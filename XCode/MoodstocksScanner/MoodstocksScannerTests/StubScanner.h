@@ -0,0 +1,66 @@
+//
+//  StubScanner.h
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#ifndef MoodstocksScanner_StubScanner_h
+#define MoodstocksScanner_StubScanner_h
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+// Stands in for MSScanner in the benchmarks: opening reads and indexes the
+// whole database file, as the SDK does before the first search.
+namespace msanetest {
+
+class StubScanner {
+public:
+    explicit StubScanner(const std::string &path) : _path(path), _open(false), _index(0) {}
+
+    void open()
+    {
+        FILE *file = fopen(_path.c_str(), "rb");
+        if (file == NULL)
+            return;
+        std::vector<unsigned char> block(1 << 16);
+        size_t read;
+        while ((read = fread(&block[0], 1, block.size(), file)) > 0) {
+            for (size_t i = 0; i < read; i++)
+                _index = _index * 31 + block[i];
+        }
+        fclose(file);
+        _open = true;
+    }
+
+    void close() { _open = false; }
+    bool isOpen() const { return _open; }
+    unsigned index() const { return _index; }
+
+private:
+    std::string _path;
+    bool _open;
+    unsigned _index;
+};
+
+// Writes a stub database of `megabytes` MB at `path`
+inline bool writeStubDatabase(const std::string &path, size_t megabytes)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL)
+        return false;
+    std::vector<unsigned char> block(1 << 20);
+    for (size_t i = 0; i < block.size(); i++)
+        block[i] = (unsigned char) (i * 2654435761u >> 24);
+    for (size_t m = 0; m < megabytes; m++)
+        fwrite(&block[0], 1, block.size(), file);
+    fclose(file);
+    return true;
+}
+
+} // namespace msanetest
+
+#endif
@@ -0,0 +1,192 @@
+//
+//  SyncSchedulerTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "SyncScheduler.h"
+#include "TestHarness.h"
+
+using namespace msane;
+
+// Every test runs in virtual time: seconds from an arbitrary epoch
+
+TEST(firstSyncStartsRightAway)
+{
+    SyncScheduler scheduler;
+    CHECK(scheduler.shouldStart(1000));
+    scheduler.started(1000);
+    CHECK(scheduler.running());
+    CHECK(!scheduler.shouldStart(1000));
+}
+
+TEST(successWaitsTheMinimumInterval)
+{
+    SyncPolicy policy;
+    policy.minInterval = 600;
+    SyncScheduler scheduler(policy);
+
+    scheduler.started(1000);
+    scheduler.finished(1030, SyncSucceeded);
+    CHECK(!scheduler.running());
+    CHECK(scheduler.lastSuccess() == 1030);
+    CHECK(scheduler.lastDuration() == 30);
+    CHECK(scheduler.nextAllowed() == 1630);
+    CHECK(!scheduler.shouldStart(1629));
+    CHECK(scheduler.shouldStart(1630));
+}
+
+TEST(persistedSuccessIsHonoured)
+{
+    SyncScheduler scheduler;
+    scheduler.setLastSuccess(5000);
+    CHECK(!scheduler.shouldStart(5000 + 3599));
+    CHECK(scheduler.shouldStart(5000 + 3600));
+}
+
+TEST(networkFailuresBackOffExponentially)
+{
+    SyncPolicy policy;
+    policy.backoffInitial = 30;
+    policy.backoffMax = 200;
+    SyncScheduler scheduler(policy);
+
+    const double expected[] = { 30, 60, 120, 200, 200 };
+    double now = 0;
+    for (int i = 0; i < 5; i++) {
+        CHECK(scheduler.shouldStart(now));
+        scheduler.started(now);
+        scheduler.finished(now, SyncNetworkFailure);
+        CHECK_EQ(scheduler.failures(), (unsigned) i + 1);
+        CHECK(scheduler.nextAllowed() == now + expected[i]);
+        CHECK(!scheduler.shouldStart(now + expected[i] - 1));
+        now += expected[i];
+    }
+
+    scheduler.started(now);
+    scheduler.finished(now, SyncSucceeded);
+    CHECK_EQ(scheduler.failures(), 0u);
+    CHECK(scheduler.nextAllowed() == now + policy.minInterval);
+}
+
+TEST(otherFailuresWaitAFullInterval)
+{
+    SyncScheduler scheduler;
+    scheduler.started(100);
+    scheduler.finished(100, SyncOtherFailure);
+    CHECK_EQ(scheduler.failures(), 0u);
+    CHECK(scheduler.nextAllowed() == 100 + 3600);
+    // a success of long ago must not shorten the wait
+    scheduler.setLastSuccess(50);
+    CHECK(scheduler.nextAllowed() == 100 + 3600);
+}
+
+TEST(unmeteredOnlyWaitsForWiFi)
+{
+    SyncPolicy policy;
+    policy.unmeteredOnly = true;
+    SyncScheduler scheduler(policy);
+
+    scheduler.setNetwork(true, false);
+    CHECK(!scheduler.shouldStart(0));
+    scheduler.request();
+    CHECK(!scheduler.shouldStart(0));
+    scheduler.setNetwork(true, true);
+    CHECK(scheduler.shouldStart(0));
+    scheduler.setNetwork(false, true);
+    CHECK(!scheduler.shouldStart(0));
+}
+
+TEST(idleOnlyWaitsUntilNotScanning)
+{
+    SyncPolicy policy;
+    policy.idleOnly = true;
+    SyncScheduler scheduler(policy);
+
+    scheduler.setBusy(true);
+    CHECK(!scheduler.shouldStart(0));
+    scheduler.setBusy(false);
+    CHECK(scheduler.shouldStart(0));
+}
+
+TEST(requestsSkipIntervalAndIdlePolicies)
+{
+    SyncPolicy policy;
+    policy.idleOnly = true;
+    SyncScheduler scheduler(policy);
+    scheduler.setLastSuccess(1000);
+    scheduler.setBusy(true);
+    CHECK(!scheduler.shouldStart(1001));
+
+    scheduler.request();
+    CHECK(scheduler.shouldStart(1001));
+    scheduler.started(1001);
+    scheduler.finished(1002, SyncSucceeded);
+    CHECK(!scheduler.shouldStart(1003));
+}
+
+TEST(suspensionHoldsSyncsBack)
+{
+    SyncScheduler scheduler;
+    scheduler.setSuspended(true);
+    CHECK(!scheduler.shouldStart(0));
+    scheduler.request();
+    CHECK(!scheduler.shouldStart(0));
+    scheduler.setSuspended(false);
+    CHECK(scheduler.shouldStart(0));
+}
+
+TEST(interruptedSyncResumesFirstThing)
+{
+    SyncScheduler scheduler;
+    scheduler.setLastSuccess(1000);
+    scheduler.request();
+    scheduler.started(1010);
+    scheduler.setSuspended(true);
+    scheduler.finished(1020, SyncInterrupted);
+    CHECK(!scheduler.shouldStart(1030));
+
+    scheduler.setSuspended(false);
+    CHECK(scheduler.shouldStart(1030));
+    CHECK(scheduler.lastSuccess() == 1000);
+}
+
+TEST(cancelledSyncLeavesNoTrace)
+{
+    SyncScheduler scheduler;
+    scheduler.setLastSuccess(1000);
+    scheduler.started(2000);
+    scheduler.finished(2001, SyncCancelled);
+    CHECK(scheduler.lastSuccess() == 1000);
+    CHECK(scheduler.nextAllowed() == 1000 + 3600);
+    CHECK(scheduler.lastDuration() == 0);
+}
+
+// A day of virtual time with the network dropping out for two hours: one
+// sync per interval, backoff during the outage, back on schedule after
+TEST(dayWithAnOutage)
+{
+    SyncPolicy policy;
+    policy.minInterval = 3600;
+    SyncScheduler scheduler(policy);
+
+    int syncs = 0, failures = 0;
+    for (double now = 0; now < 24 * 3600; now += 10) {
+        bool outage = now >= 6 * 3600 && now < 8 * 3600;
+        scheduler.setNetwork(true, true);
+        if (!scheduler.shouldStart(now))
+            continue;
+        scheduler.started(now);
+        if (outage) {
+            scheduler.finished(now + 5, SyncNetworkFailure);
+            failures++;
+        } else {
+            scheduler.finished(now + 5, SyncSucceeded);
+            syncs++;
+        }
+    }
+    CHECK(syncs >= 22 && syncs <= 24);
+    // 30 s doubling to an hour: about eight attempts in two hours, not 720
+    CHECK(failures >= 4 && failures <= 10);
+}
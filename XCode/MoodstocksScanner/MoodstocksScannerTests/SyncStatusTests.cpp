@@ -0,0 +1,147 @@
+//
+//  SyncStatusTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <map>
+#include <string>
+
+#include "FakeFRE.h"
+#include "SyncStatus.h"
+#include "TestHarness.h"
+
+using namespace msane;
+using namespace msanetest;
+
+// syncChanged:key: and deliverSyncStatus: of MoodstocksScanner.mm in
+// virtual time, with dispatch_after on the main queue replaced by a list
+// of pending flushes
+struct SyncBridge {
+    SyncStatusBoard board;
+    FakeContext context;
+    std::multimap<double, std::string> pending;
+
+    void changed(const std::string &key, const SyncStatus &status, double now)
+    {
+        run(now);
+        double delay = board.update(key, status, now);
+        if (delay == 0)
+            deliver(key, now);
+        else if (delay > 0)
+            pending.insert(std::make_pair(now + delay, key));
+    }
+
+    void run(double now)
+    {
+        while (!pending.empty() && pending.begin()->first <= now) {
+            double time = pending.begin()->first;
+            std::string key = pending.begin()->second;
+            pending.erase(pending.begin());
+            deliver(key, time);
+        }
+    }
+
+    void deliver(const std::string &key, double now)
+    {
+        SyncStatus status;
+        if (!board.flush(key, now, &status))
+            return;
+        char level[32];
+        status.format(level, sizeof(level));
+        context.dispatch("syncStatus", (std::string(level) + "," + key).c_str());
+    }
+};
+
+static SyncStatus statusOf(bool syncing, int progress, int error = 0)
+{
+    SyncStatus status = { syncing, progress, error };
+    return status;
+}
+
+TEST(formatsStatus)
+{
+    char level[32];
+    CHECK_EQ(statusOf(true, 42).format(level, sizeof(level)), 6u);
+    CHECK(std::string(level) == "1,42,0");
+    CHECK_EQ(statusOf(false, 100, -3).format(level, 4), 3u);
+    CHECK(std::string(level) == "0,1");
+}
+
+TEST(firstChangeGoesOutRightAway)
+{
+    SyncStatusThrottle throttle(0.25);
+    CHECK(throttle.update(statusOf(true, 0), 10) == 0);
+    SyncStatus status;
+    CHECK(throttle.flush(10, &status));
+    CHECK(status.syncing && status.progress == 0);
+    // unchanged: nothing to do
+    CHECK(throttle.update(statusOf(true, 0), 10.1) < 0);
+    // changed within the interval: flush once the interval is over
+    CHECK(throttle.update(statusOf(true, 1), 10.1) > 0.14);
+    CHECK(throttle.update(statusOf(true, 2), 10.2) < 0);
+    CHECK(throttle.flush(10.25, &status));
+    CHECK_EQ(status.progress, 2);
+}
+
+// 1000 progress notifications within two seconds, as a fast sync posts
+// them: a handful of events, the last one the final state
+TEST(burstIsCoalesced)
+{
+    SyncBridge bridge;
+    double now = 0;
+    for (int i = 0; i < 1000; i++) {
+        now += 0.002;
+        bridge.changed("key", statusOf(true, i / 10), now);
+    }
+    bridge.changed("key", statusOf(false, 100), now + 0.001);
+    bridge.run(now + 1);
+
+    size_t events = bridge.context.count("syncStatus");
+    CHECK(events >= 8 && events <= 10);
+    CHECK_EQ(bridge.board.updateCount(), 1001u);
+    CHECK_EQ(bridge.board.deliveryCount(), (uint64_t) events);
+    CHECK(bridge.context.events.back().level == "0,100,0,key");
+    CHECK(bridge.pending.empty());
+}
+
+// Two pooled catalogs syncing at once each get their own throttle, so the
+// end of one is not swallowed by progress of the other
+TEST(catalogsAreThrottledApart)
+{
+    SyncBridge bridge;
+    double now = 0;
+    for (int i = 0; i < 200; i++) {
+        now += 0.005;
+        bridge.changed("a", statusOf(true, i / 2), now);
+        bridge.changed("b", statusOf(true, i / 4), now);
+    }
+    bridge.changed("a", statusOf(false, 100), now);
+    for (int i = 0; i < 20; i++) {
+        now += 0.005;
+        bridge.changed("b", statusOf(true, 50 + i), now);
+    }
+    bridge.changed("b", statusOf(false, 100, 2), now);
+    bridge.run(now + 1);
+
+    bool finishedA = false;
+    for (size_t i = 0; i < bridge.context.events.size(); i++)
+        finishedA |= bridge.context.events[i].level == "0,100,0,a";
+    CHECK(finishedA);
+    CHECK(bridge.context.events.back().level == "0,100,2,b");
+}
+
+TEST(intervalAppliesToEveryCatalog)
+{
+    SyncStatusBoard board(0.25);
+    board.update("a", statusOf(true, 0), 0);
+    board.setInterval(1);
+    board.update("b", statusOf(true, 0), 0);
+
+    SyncStatus status;
+    CHECK(board.flush("a", 0, &status));
+    CHECK(board.flush("b", 0, &status));
+    CHECK(board.update("a", statusOf(true, 1), 0.5) > 0.4);
+    CHECK(board.update("b", statusOf(true, 1), 0.5) > 0.4);
+}
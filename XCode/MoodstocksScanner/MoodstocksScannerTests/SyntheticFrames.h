@@ -0,0 +1,112 @@
+//
+//  SyntheticFrames.h
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#ifndef MoodstocksScanner_SyntheticFrames_h
+#define MoodstocksScanner_SyntheticFrames_h
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "PixelConvert.h"
+
+// Stand-in for recorded camera sequences: a textured scene of random
+// rectangles rendered into luma frames, shifted for camera motion, box
+// blurred along x for motion blur or both ways when out of focus, with
+// sensor noise on top.
+namespace msanetest {
+
+class SyntheticScene {
+public:
+    static const int kMargin = 160;
+
+    SyntheticScene(int width, int height, unsigned seed)
+        : _width(width), _height(height), _canvasWidth(width + 2 * kMargin),
+          _canvas((size_t) (width + 2 * kMargin) * (height + 2 * kMargin))
+    {
+        int canvasHeight = height + 2 * kMargin;
+        unsigned state = seed;
+        for (int y = 0; y < canvasHeight; y++)
+            for (int x = 0; x < _canvasWidth; x++)
+                _canvas[(size_t) y * _canvasWidth + x] = (uint8_t) (64 + (x + y) * 64 / (_canvasWidth + canvasHeight));
+        for (int r = 0; r < 600; r++) {
+            int w = 4 + next(&state) % 60, h = 4 + next(&state) % 60;
+            int x0 = next(&state) % (_canvasWidth - w), y0 = next(&state) % (canvasHeight - h);
+            uint8_t value = (uint8_t) (next(&state) & 255);
+            for (int y = y0; y < y0 + h; y++)
+                for (int x = x0; x < x0 + w; x++)
+                    _canvas[(size_t) y * _canvasWidth + x] = value;
+        }
+    }
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+
+    // The frame seen from offset (dx, dy), both within +-kMargin, motion
+    // blurred over `blur` pixels along x, defocused over `defocus` pixels
+    // and with noise of up to +-`noise` levels
+    void render(int dx, int dy, int blur, int defocus, int noise, unsigned seed, std::vector<uint8_t> *frame) const
+    {
+        frame->resize((size_t) _width * _height);
+        unsigned state = seed;
+        int span = blur > defocus ? blur : defocus;
+        if (span < 1)
+            span = 1;
+        for (int y = 0; y < _height; y++) {
+            const uint8_t *row = &_canvas[(size_t) (y + kMargin + dy) * _canvasWidth + kMargin + dx];
+            uint8_t *out = &(*frame)[(size_t) y * _width];
+            int sum = 0;
+            for (int k = 0; k < span; k++)
+                sum += row[k];
+            for (int x = 0; x < _width; x++) {
+                out[x] = (uint8_t) (sum / span);
+                sum += row[x + span] - row[x];
+            }
+        }
+
+        if (defocus > 1) {
+            std::vector<uint8_t> column(_height);
+            for (int x = 0; x < _width; x++) {
+                for (int y = 0; y < _height; y++)
+                    column[y] = (*frame)[(size_t) y * _width + x];
+                for (int y = 0; y < _height; y++) {
+                    int sum = 0;
+                    for (int k = 0; k < defocus; k++)
+                        sum += column[y + k < _height ? y + k : _height - 1];
+                    (*frame)[(size_t) y * _width + x] = (uint8_t) (sum / defocus);
+                }
+            }
+        }
+
+        for (size_t i = 0; noise > 0 && i < frame->size(); i++) {
+            int value = (*frame)[i] + (int) (next(&state) % (2 * noise + 1)) - noise;
+            (*frame)[i] = (uint8_t) (value < 0 ? 0 : value > 255 ? 255 : value);
+        }
+    }
+
+    static msane::GrayView view(std::vector<uint8_t> &frame, int width, int height)
+    {
+        msane::GrayView view = { &frame[0], width, height, width };
+        return view;
+    }
+
+private:
+    static unsigned next(unsigned *state)
+    {
+        *state = *state * 1103515245u + 12345u;
+        return *state >> 8;
+    }
+
+    int _width;
+    int _height;
+    int _canvasWidth;
+    std::vector<uint8_t> _canvas;
+};
+
+} // namespace msanetest
+
+#endif
@@ -0,0 +1,60 @@
+//
+//  TestHarness.h
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#ifndef MoodstocksScanner_TestHarness_h
+#define MoodstocksScanner_TestHarness_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+// Just enough of a test framework for the portable cores: TEST() registers
+// a function, CHECK() records a failure and carries on. Each *Tests.cpp is
+// linked with TestMain.cpp into its own executable, one ctest entry per core.
+namespace msanetest {
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+    const char *name;
+    TestFunction function;
+};
+
+std::vector<TestCase> &registry();
+void fail(const char *file, int line, const char *expression);
+
+struct Registrar {
+    Registrar(const char *name, TestFunction function)
+    {
+        TestCase test = { name, function };
+        registry().push_back(test);
+    }
+};
+
+// Heap allocations (operator new and malloc) made by this thread so far,
+// from Allocations.cpp
+uint64_t allocationCount();
+
+// Most heap bytes live at once since resetHeapPeak(), all threads; glibc only
+size_t heapPeak();
+void resetHeapPeak();
+
+} // namespace msanetest
+
+#define TEST(name) \
+    static void name(); \
+    static msanetest::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) msanetest::fail(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+#endif
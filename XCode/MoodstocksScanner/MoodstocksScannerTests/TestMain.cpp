@@ -0,0 +1,45 @@
+//
+//  TestMain.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include "TestHarness.h"
+
+#include <string.h>
+
+namespace msanetest {
+
+static int failures = 0;
+
+std::vector<TestCase> &registry()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void fail(const char *file, int line, const char *expression)
+{
+    fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    failures++;
+}
+
+} // namespace msanetest
+
+int main(int argc, char **argv)
+{
+    const char *only = argc > 1 ? argv[1] : NULL;
+    int run = 0;
+    for (size_t i = 0; i < msanetest::registry().size(); i++) {
+        const msanetest::TestCase &test = msanetest::registry()[i];
+        if (only != NULL && strcmp(only, test.name) != 0)
+            continue;
+        int before = msanetest::failures;
+        test.function();
+        printf("%s %s\n", msanetest::failures == before ? "ok  " : "FAIL", test.name);
+        run++;
+    }
+    printf("%d tests, %d failed checks\n", run, msanetest::failures);
+    return msanetest::failures == 0 && run > 0 ? 0 : 1;
+}
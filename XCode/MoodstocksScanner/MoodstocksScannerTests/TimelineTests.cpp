@@ -0,0 +1,62 @@
+//
+//  TimelineTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.h"
+#include "Timeline.h"
+
+using namespace msane;
+
+TEST(marksKeepTheirOrderAndFirstTime)
+{
+    Timeline timeline;
+    timeline.mark("extension");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timeline.mark("open");
+    timeline.mark("extension");
+
+    std::vector<Timeline::Mark> marks = timeline.marks();
+    CHECK_EQ(marks.size(), 2u);
+    CHECK(marks[0].name == "extension");
+    CHECK(marks[1].name == "open");
+    CHECK(marks[0].milliseconds >= 0 && marks[0].milliseconds < 20);
+    CHECK(marks[1].milliseconds >= 20);
+}
+
+TEST(startForgetsEarlierMarks)
+{
+    Timeline timeline;
+    timeline.mark("camera");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    timeline.start();
+    timeline.mark("camera");
+
+    std::vector<Timeline::Mark> marks = timeline.marks();
+    CHECK_EQ(marks.size(), 1u);
+    CHECK(marks[0].milliseconds < 10);
+}
+
+// Prewarm marks from background queues while runScanner marks on the main
+// thread: every name still appears once
+TEST(marksFromManyThreads)
+{
+    static const char *names[] = { "bundle", "open", "view", "sync" };
+    Timeline timeline;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&timeline] {
+            for (int i = 0; i < 1000; i++)
+                timeline.mark(names[i % 4]);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    CHECK_EQ(timeline.marks().size(), 4u);
+}
@@ -0,0 +1,89 @@
+//
+//  WorkerPoolBench.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "WorkerPool.h"
+
+using namespace msane;
+
+// Stub recognizer for a batch of photos. `blocking` items sleep for their
+// cost, as if each worker had a core of its own; the others spin on this
+// machine's cores.
+class StubRecognizer : public BatchJob {
+public:
+    StubRecognizer(double cost, bool blocking) : _cost(cost), _blocking(blocking), _done(false) {}
+
+    virtual void process(size_t index, unsigned)
+    {
+        // photos differ: +-50% around the mean cost
+        double cost = _cost * (0.5 + (double) ((index * 7919) % 100) / 100);
+        if (_blocking) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(cost));
+            return;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(cost));
+        while (std::chrono::steady_clock::now() < end) {}
+    }
+
+    virtual void finished(size_t, bool)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _done = true;
+        _finished.notify_all();
+    }
+
+    void waitFinished()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (!_done)
+            _finished.wait(lock);
+    }
+
+private:
+    double _cost;
+    bool _blocking;
+    bool _done;
+    std::mutex _lock;
+    std::condition_variable _finished;
+};
+
+int main()
+{
+    const size_t items = 400;
+    const double cost = 0.002;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned maxThreads = std::max(8u, cores);
+
+    printf("%zu items of ~%.0f ms, %u hardware threads\n", items, cost * 1e3, cores);
+    printf("%8s %16s %9s %16s %9s\n", "threads", "blocking img/s", "scaling", "spinning img/s", "scaling");
+    double base[2] = { 0, 0 };
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        WorkerPool pool(threads);
+        double rate[2];
+        for (int spinning = 0; spinning < 2; spinning++) {
+            std::shared_ptr<StubRecognizer> job = std::make_shared<StubRecognizer>(cost, spinning == 0);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            pool.run(job, items);
+            job->waitFinished();
+            rate[spinning] = items / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (threads == 1)
+                base[spinning] = rate[spinning];
+        }
+        printf("%8u %16.0f %8.2fx %16.0f %8.2fx\n", threads, rate[0], rate[0] / base[0], rate[1], rate[1] / base[1]);
+    }
+    return 0;
+}
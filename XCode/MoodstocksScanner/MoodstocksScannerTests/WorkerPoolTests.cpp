@@ -0,0 +1,171 @@
+//
+//  WorkerPoolTests.cpp
+//  MoodstocksScanner
+//
+//  Copyright (c) Santanu Karar. All rights reserved.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.h"
+#include "WorkerPool.h"
+
+using namespace msane;
+
+// Stub recognizer: records which items ran on which worker
+class StubBatch : public BatchJob {
+public:
+    StubBatch(size_t count, unsigned threads)
+        : runs(count), badWorker(false), finishedCalls(0), processed(0), cancelled(false),
+          delay(0), _threads(threads), _done(false) {}
+
+    std::vector<std::atomic<int> > runs;
+    std::atomic<bool> badWorker;
+    std::atomic<int> finishedCalls;
+    size_t processed;
+    bool cancelled;
+    int delay;      // milliseconds per item
+
+    virtual void process(size_t index, unsigned worker)
+    {
+        if (worker >= _threads)
+            badWorker = true;
+        if (delay > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        runs[index]++;
+    }
+
+    virtual void finished(size_t count, bool wasCancelled)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        processed = count;
+        cancelled = wasCancelled;
+        finishedCalls++;
+        _done = true;
+        _finished.notify_all();
+    }
+
+    void waitFinished()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (!_done)
+            _finished.wait(lock);
+    }
+
+private:
+    unsigned _threads;
+    bool _done;
+    std::mutex _lock;
+    std::condition_variable _finished;
+};
+
+TEST(everyItemRunsOnce)
+{
+    WorkerPool pool(3);
+    CHECK_EQ(pool.threads(), 3u);
+    std::shared_ptr<StubBatch> job = std::make_shared<StubBatch>(1000, 3);
+    CHECK(pool.run(job, 1000));
+    pool.wait();
+    job->waitFinished();
+
+    bool once = true;
+    for (size_t i = 0; i < job->runs.size(); i++)
+        once = once && job->runs[i] == 1;
+    CHECK(once);
+    CHECK(!job->badWorker);
+    CHECK_EQ(job->finishedCalls.load(), 1);
+    CHECK_EQ(job->processed, 1000u);
+    CHECK(!job->cancelled);
+    CHECK(!pool.busy());
+}
+
+TEST(oneBatchAtATime)
+{
+    WorkerPool pool(2);
+    std::shared_ptr<StubBatch> slow = std::make_shared<StubBatch>(4, 2);
+    slow->delay = 20;
+    CHECK(pool.run(slow, 4));
+    CHECK(pool.busy());
+    std::shared_ptr<StubBatch> other = std::make_shared<StubBatch>(1, 2);
+    CHECK(!pool.run(other, 1));
+    pool.wait();
+    slow->waitFinished();
+
+    CHECK(pool.run(other, 1));
+    pool.wait();
+    other->waitFinished();
+    CHECK_EQ(other->processed, 1u);
+}
+
+TEST(cancelSkipsItemsNotStarted)
+{
+    WorkerPool pool(2);
+    std::shared_ptr<StubBatch> job = std::make_shared<StubBatch>(200, 2);
+    job->delay = 2;
+    CHECK(pool.run(job, 200));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pool.cancel();
+    pool.wait();
+    job->waitFinished();
+
+    CHECK(job->cancelled);
+    CHECK(job->processed > 0 && job->processed < 200);
+    size_t ran = 0;
+    for (size_t i = 0; i < job->runs.size(); i++)
+        ran += job->runs[i];
+    CHECK_EQ(ran, job->processed);
+    CHECK_EQ(pool.processed(), job->processed);
+}
+
+// A batch may start the next one from finished(), as the extension does
+class ChainedBatch : public BatchJob {
+public:
+    ChainedBatch(WorkerPool &pool, std::shared_ptr<StubBatch> next) : _pool(pool), _next(next) {}
+
+    virtual void process(size_t, unsigned) {}
+    virtual void finished(size_t, bool) { _pool.run(_next, 5); }
+
+private:
+    WorkerPool &_pool;
+    std::shared_ptr<StubBatch> _next;
+};
+
+TEST(nextBatchFromFinished)
+{
+    WorkerPool pool(2);
+    std::shared_ptr<StubBatch> next = std::make_shared<StubBatch>(5, 2);
+    std::shared_ptr<ChainedBatch> first = std::make_shared<ChainedBatch>(pool, next);
+    CHECK(pool.run(first, 10));
+    next->waitFinished();
+    CHECK_EQ(next->processed, 5u);
+}
+
+TEST(destructorCancelsAndJoins)
+{
+    std::shared_ptr<StubBatch> job = std::make_shared<StubBatch>(1000, 2);
+    job->delay = 1;
+    {
+        WorkerPool pool(2);
+        pool.run(job, 1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    job->waitFinished();
+    CHECK(job->cancelled);
+    CHECK(job->processed < 1000);
+}
+
+TEST(emptyBatchStillFinishes)
+{
+    WorkerPool pool(4);
+    std::shared_ptr<StubBatch> job = std::make_shared<StubBatch>(0, 4);
+    CHECK(pool.run(job, 0));
+    job->waitFinished();
+    CHECK_EQ(job->finishedCalls.load(), 1);
+    CHECK_EQ(job->processed, 0u);
+}